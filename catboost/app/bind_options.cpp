@@ -50,6 +50,12 @@ void BindDsvPoolFormatParams(NLastGetopt::TOpts* parser,
         .NoArgument()
         .StoreValue(&dsvPoolFormatParams->Format.HasHeader,
                     true);
+
+    parser->AddLongOption("use-pool-cache",
+        "[for dsv format] Load pools from binary cache files stored next to them, create caches on first load")
+        .NoArgument()
+        .StoreValue(&dsvPoolFormatParams->UsePoolCache,
+                    true);
 }
 
 inline static void BindPoolLoadParams(NLastGetopt::TOpts* parser, NCatboostOptions::TPoolLoadParams* loadParamsPtr) {
@@ -458,6 +464,13 @@ void ParseCommandLine(int argc, const char* argv[],
         })
         .Help("Controls how frequently to sample weights and objects when constructing trees. Possible values are PerTree and PerTreeLevel.");
 
+    parser.AddLongOption("dev-score-calc-stats-subtraction")
+        .RequiredArgument("bool")
+        .Handler1T<TString>([plainJsonPtr](const TString& param) {
+            (*plainJsonPtr)["dev_score_calc_stats_subtraction"] = FromString<bool>(param);
+        })
+        .Help("True by default. CPU only. Derive bucket stats of the larger split side from the previous tree level stats when the documents sample doesn't change within a tree.");
+
     parser
         .AddLongOption("subsample")
         .RequiredArgument("Float")
@@ -637,6 +650,12 @@ void ParseCommandLine(int argc, const char* argv[],
                 (*plainJsonPtr)["used_ram_limit"] = param;
             });
 
+    parser.AddLongOption("online-ctr-cache-size", "Memory budget for online ctrs kept between iterations, least recently used ctrs are evicted. CPU only.\nAllowed suffixes: GB, MB, KB in different cases")
+            .RequiredArgument("SIZE")
+            .Handler1T<TString>([&plainJsonPtr](const TString& param) {
+                (*plainJsonPtr)["online_ctr_cache_size"] = param;
+            });
+
     parser.AddLongOption("allow-writing-files", "Allow writing files on disc. Possible values: true, false")
             .RequiredArgument("bool")
             .Handler1T<TString>([&plainJsonPtr](const TString& param) {
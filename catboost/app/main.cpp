@@ -20,6 +20,8 @@ int main(int argc, const char* argv[]) {
         modChooser.AddMode("ostr", mode_ostr, "evaluate object importances");
         modChooser.AddMode("eval-metrics", mode_eval_metrics, "evaluate metrics for model");
         modChooser.AddMode("metadata", mode_metadata, "get/set/dump metainfo fields from model");
+        modChooser.AddMode("optimize-model", mode_optimize_model, "optimize model trees order and ctr tables for faster evaluation");
+        modChooser.AddMode("quantize", mode_quantize, "convert dsv pool to quantized pool");
         modChooser.DisableSvnRevisionOption();
         modChooser.SetVersionHandler(PrintProgramSvnVersion);
         return modChooser.Run(argc, argv);
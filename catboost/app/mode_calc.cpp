@@ -7,6 +7,7 @@
 #include <catboost/libs/algo/apply.h>
 #include <catboost/libs/helpers/eval_helpers.h>
 #include <catboost/libs/helpers/multiclass_label_helpers/visible_label_helper.h>
+#include <catboost/libs/logging/logging.h>
 #include <catboost/libs/model/model.h>
 
 #include <library/getopt/small/last_getopt.h>
@@ -59,6 +60,7 @@ int mode_calc(int argc, const char* argv[]) {
     TAnalyticalModeCommonParams params;
     size_t iterationsLimit = 0;
     size_t evalPeriod = 0;
+    ELeafValuesPrecision leafValuesPrecision = ELeafValuesPrecision::Double;
 
     auto parser = NLastGetopt::TOpts();
     parser.AddHelpOption();
@@ -86,11 +88,21 @@ int mode_calc(int argc, const char* argv[]) {
         });
     parser.AddLongOption("eval-period", "predictions are evaluated every <eval-period> trees")
         .StoreResult(&evalPeriod);
+    parser.AddLongOption("leaf-values-precision", "leaf values precision used for evaluation: Double, Float or Int16")
+        .RequiredArgument("PRECISION")
+        .Handler1T<TString>([&](const TString& precision) {
+            leafValuesPrecision = FromString<ELeafValuesPrecision>(precision);
+        });
     parser.SetFreeArgsNum(0);
     NLastGetopt::TOptsParseResult parserResult{&parser, argc, argv};
 
     CB_ENSURE(NFs::Exists(params.ModelFileName), "Model file doesn't exist " << params.ModelFileName);
-    TFullModel model = ReadModel(params.ModelFileName);
+    NPar::TLocalExecutor executor;
+    executor.RunAdditionalThreads(params.ThreadCount - 1);
+    TModelLoadOptions modelLoadOptions;
+    modelLoadOptions.Executor = &executor;
+    TModelLoadStats modelLoadStats;
+    TFullModel model = ReadModel(params.ModelFileName, modelLoadOptions, &modelLoadStats);
     if (model.HasCategoricalFeatures()) {
         CB_ENSURE(params.DsvPoolFormatParams.CdFilePath.Inited(),
                   "Model has categorical features. Specify column_description file with correct categorical features.");
@@ -112,10 +124,15 @@ int mode_calc(int argc, const char* argv[]) {
 
     const int blockSize = Max<int>(32, static_cast<int>(10000. / (static_cast<double>(iterationsLimit) / evalPeriod) / model.ObliviousTrees.ApproxDimension));
     TOFStream outputStream(params.OutputPath);
-    NPar::TLocalExecutor executor;
-    executor.RunAdditionalThreads(params.ThreadCount - 1);
 
     SetVerboseLogingMode();
+    MATRIXNET_INFO_LOG << "Model loaded: core " << modelLoadStats.CoreLoadSeconds << " sec, "
+        << modelLoadStats.CtrTableCount << " ctr tables (" << modelLoadStats.CtrTablesBytes << " bytes) "
+        << modelLoadStats.CtrTablesLoadSeconds << " sec" << Endl;
+    if (leafValuesPrecision != ELeafValuesPrecision::Double) {
+        const double maxAbsError = model.ObliviousTrees.SetLeafValuesPrecision(leafValuesPrecision);
+        MATRIXNET_INFO_LOG << "Leaf values are evaluated with " << leafValuesPrecision << " precision, max abs error of raw predictions is " << maxAbsError << Endl;
+    }
     bool IsFirstBlock = true;
     ReadAndProceedPoolInBlocks(params, blockSize, [&](const TPool& poolPart) {
         if (IsFirstBlock) {
@@ -0,0 +1,112 @@
+#include "modes.h"
+
+#include <catboost/libs/cat_feature/cat_feature.h>
+#include <catboost/libs/helpers/exception.h>
+#include <catboost/libs/logging/logging.h>
+#include <catboost/libs/model/model.h>
+
+#include <library/getopt/small/last_getopt.h>
+
+#include <util/generic/maybe.h>
+#include <util/random/fast.h>
+#include <util/system/fs.h>
+#include <util/system/hp_timer.h>
+
+static TVector<TVector<float>> GenerateBenchmarkDocuments(const TFullModel& model, size_t docCount) {
+    TFastRng64 rng(0);
+    TVector<TVector<float>> docs(docCount, TVector<float>(model.ObliviousTrees.GetFlatFeatureVectorExpectedSize()));
+    for (auto& doc : docs) {
+        for (const auto& floatFeature : model.ObliviousTrees.FloatFeatures) {
+            const auto& borders = floatFeature.Borders;
+            if (!borders.empty()) {
+                doc[floatFeature.FlatFeatureIndex] = borders.front() - 1.0f + (borders.back() - borders.front() + 2.0f) * rng.GenRandReal1();
+            }
+        }
+        for (const auto& catFeature : model.ObliviousTrees.CatFeatures) {
+            doc[catFeature.FlatFeatureIndex] = ConvertCatFeatureHashToFloat(CalcCatFeatureHash(ToString(rng.Uniform(100))));
+        }
+    }
+    return docs;
+}
+
+//! Best of several runs, first run also warms up caches
+static double MeasureEvaluationSeconds(const TFullModel& model, const TVector<TConstArrayRef<float>>& docs) {
+    TVector<double> results(docs.size() * model.ObliviousTrees.ApproxDimension);
+    double bestTime = std::numeric_limits<double>::max();
+    for (int run = 0; run < 3; ++run) {
+        THPTimer timer;
+        model.CalcFlat(docs, results);
+        bestTime = Min(bestTime, timer.Passed());
+    }
+    return bestTime;
+}
+
+int mode_optimize_model(int argc, const char* argv[]) {
+    TString modelPath;
+    TString outputModelPath;
+    size_t benchmarkDocCount = 10000;
+    TMaybe<ECtrTableIndexLayout> ctrTableIndexLayout;
+    bool precomputeCtrValues = false;
+    bool reorderTrees = false;
+
+    auto parser = NLastGetopt::TOpts();
+    parser.AddHelpOption();
+    parser.AddLongOption('m', "model-path", "path to model")
+        .StoreResult(&modelPath)
+        .DefaultValue("model.cbm");
+    parser.AddLongOption('o', "output-model-path", "path to optimized model")
+        .RequiredArgument("PATH")
+        .StoreResult(&outputModelPath)
+        .DefaultValue("model.optimized.cbm");
+    parser.AddLongOption("benchmark-doc-count", "count of random documents used to measure evaluation speedup, 0 to skip")
+        .RequiredArgument("INT")
+        .StoreResult(&benchmarkDocCount);
+    parser.AddLongOption("reorder-trees", "group trees by depth and shared features, changes summation order of predictions in last bits")
+        .NoArgument()
+        .StoreValue(&reorderTrees, true);
+    parser.AddLongOption("ctr-table-index-layout", "index layout of saved ctr tables: LinearProbing or BucketizedCuckoo")
+        .RequiredArgument("LAYOUT")
+        .Handler1T<TString>([&](const TString& layout) {
+            ctrTableIndexLayout = FromString<ECtrTableIndexLayout>(layout);
+        });
+    parser.AddLongOption("precompute-ctr-values", "store binarized ctr values instead of ctr counters, model can't be exported to C++ or Python then")
+        .NoArgument()
+        .StoreValue(&precomputeCtrValues, true);
+    parser.SetFreeArgsNum(0);
+    NLastGetopt::TOptsParseResult parserResult{&parser, argc, argv};
+
+    CB_ENSURE(NFs::Exists(modelPath), "Model file doesn't exist " << modelPath);
+    TFullModel model = ReadModel(modelPath);
+
+    TVector<TVector<float>> docs;
+    TVector<TConstArrayRef<float>> docRefs;
+    double originalSeconds = 0.0;
+    if (benchmarkDocCount > 0) {
+        docs = GenerateBenchmarkDocuments(model, benchmarkDocCount);
+        docRefs.assign(docs.begin(), docs.end());
+        originalSeconds = MeasureEvaluationSeconds(model, docRefs);
+    }
+
+    if (reorderTrees) {
+        const auto depthGroupCount = model.ObliviousTrees.GetTreeDepthGroups().size();
+        model.OptimizeTreeOrder();
+        MATRIXNET_INFO_LOG << "Trees reordered: " << model.GetTreeCount() << " trees, depth groups "
+            << depthGroupCount << " -> " << model.ObliviousTrees.GetTreeDepthGroups().size() << Endl;
+    }
+    if (ctrTableIndexLayout.Defined()) {
+        model.SetCtrTablesIndexLayout(*ctrTableIndexLayout);
+        MATRIXNET_INFO_LOG << "Ctr tables index layout: " << *ctrTableIndexLayout << Endl;
+    }
+    if (precomputeCtrValues) {
+        model.PrecomputeCtrValues(/*dropCounters*/ true);
+        MATRIXNET_INFO_LOG << "Ctr values precomputed for " << model.ObliviousTrees.CtrFeatures.size() << " ctr features" << Endl;
+    }
+    if (benchmarkDocCount > 0) {
+        const double optimizedSeconds = MeasureEvaluationSeconds(model, docRefs);
+        MATRIXNET_INFO_LOG << "Evaluation of " << benchmarkDocCount << " documents: " << originalSeconds << " sec -> "
+            << optimizedSeconds << " sec, speedup " << originalSeconds / Max(optimizedSeconds, 1e-9) << Endl;
+    }
+
+    ExportModel(model, outputModelPath);
+    return 0;
+}
@@ -0,0 +1,398 @@
+#include "modes.h"
+#include "cmd_line.h"
+#include "bind_options.h"
+#include "proceed_pool_in_blocks.h"
+
+#include <catboost/idl/pool/flat/quantized_chunk_t.fbs.h>
+#include <catboost/libs/data/load_data.h>
+#include <catboost/libs/helpers/exception.h>
+#include <catboost/libs/logging/logging.h>
+#include <catboost/libs/quantization_schema/detail.h>
+#include <catboost/libs/quantization_schema/quantize.h>
+#include <catboost/libs/quantized_pool/detail.h>
+#include <catboost/libs/quantized_pool/pool.h>
+#include <catboost/libs/quantized_pool/serialization.h>
+
+#include <contrib/libs/flatbuffers/include/flatbuffers/flatbuffers.h>
+
+#include <library/getopt/small/last_getopt.h>
+#include <library/grid_creator/binarization.h>
+#include <library/threading/local_executor/local_executor.h>
+
+#include <util/generic/algorithm.h>
+#include <util/generic/ymath.h>
+#include <util/memory/blob.h>
+#include <util/random/fast.h>
+#include <util/stream/file.h>
+#include <util/string/cast.h>
+#include <util/string/iterator.h>
+
+#include <limits>
+
+struct TModeQuantizeParams {
+    ui32 BlockSize = 100000;
+    ui32 SampleSize = 200000;
+    int BorderCount = 128;
+    EBorderSelectionType BorderType = EBorderSelectionType::GreedyLogSum;
+    ENanMode NanMode = ENanMode::Min;
+    ui64 RandomSeed = 0;
+
+    void BindParserOpts(NLastGetopt::TOpts& parser) {
+        parser.AddLongOption("block-size", "count of documents parsed and quantized at once")
+            .RequiredArgument("INT")
+            .StoreResult(&BlockSize);
+        parser.AddLongOption("sample-size", "count of randomly sampled documents used to select borders")
+            .RequiredArgument("INT")
+            .StoreResult(&SampleSize);
+        parser.AddLongOption('x', "border-count", "count of borders per float feature. Should be in range [1, 254]")
+            .RequiredArgument("int")
+            .StoreResult(&BorderCount);
+        parser.AddLongOption("feature-border-type",
+                             "Should be one of: Median, GreedyLogSum, UniformAndQuantiles, MinEntropy, MaxLogSum")
+            .RequiredArgument("border-type")
+            .Handler1T<TString>([&](const TString& type) {
+                BorderType = FromString<EBorderSelectionType>(type);
+            });
+        parser.AddLongOption("nan-mode", "Should be one of: {Min, Max, Forbidden}. Default: Min")
+            .RequiredArgument("nan-mode")
+            .Handler1T<TString>([&](const TString& nanMode) {
+                NanMode = FromString<ENanMode>(nanMode);
+            });
+        parser.AddLongOption('r', "random-seed", "random seed for documents sampling")
+            .RequiredArgument("count")
+            .StoreResult(&RandomSeed);
+    }
+};
+
+// Uniform sample of float feature values collected in one pass over the pool with reservoir sampling.
+// Memory usage doesn't depend on pool size: sample size is fixed and documents are sampled for all
+// features at once.
+class TFloatFeaturesSampler {
+public:
+    TFloatFeaturesSampler(size_t sampleSize, ui64 randomSeed)
+        : SampleSize(sampleSize)
+        , Rand(randomSeed)
+    {
+    }
+
+    void AddBlock(const TPool& block, NPar::TLocalExecutor* localExecutor) {
+        const int featureCount = block.Docs.GetEffectiveFactorCount();
+        if (DocCount == 0) {
+            Samples.resize(featureCount);
+            HasNans.resize(featureCount, false);
+            IsCatFeature.resize(featureCount, false);
+            for (int catFeatureIdx : block.CatFeatures) {
+                IsCatFeature[catFeatureIdx] = true;
+            }
+        }
+        CB_ENSURE(featureCount == Samples.ysize(), "All pool blocks should have the same feature count");
+
+        // [sampleDocIdx] -> (docIdx in block, sample slot)
+        TVector<std::pair<size_t, size_t>> sampledDocs;
+        const size_t blockDocCount = block.Docs.GetDocCount();
+        for (size_t docIdx = 0; docIdx < blockDocCount; ++docIdx, ++DocCount) {
+            if (DocCount < SampleSize) {
+                sampledDocs.emplace_back(docIdx, DocCount);
+            } else {
+                const size_t slot = Rand.Uniform(DocCount + 1);
+                if (slot < SampleSize) {
+                    sampledDocs.emplace_back(docIdx, slot);
+                }
+            }
+        }
+
+        localExecutor->ExecRange([&](int featureIdx) {
+            if (IsCatFeature[featureIdx]) {
+                return;
+            }
+            const auto& values = block.Docs.Factors[featureIdx];
+            HasNans[featureIdx] = HasNans[featureIdx] || AnyOf(values, IsNan);
+            auto& sample = Samples[featureIdx];
+            for (const auto& sampledDoc : sampledDocs) {
+                if (sampledDoc.second == sample.size()) {
+                    sample.push_back(values[sampledDoc.first]);
+                } else {
+                    sample[sampledDoc.second] = values[sampledDoc.first];
+                }
+            }
+        }, 0, featureCount, NPar::TLocalExecutor::WAIT_COMPLETE);
+    }
+
+    size_t GetDocCount() const {
+        return DocCount;
+    }
+
+    // Same borders as `GenerateBorders` selects for training, the sample is used instead of all documents.
+    // Nan values go to the first or the last bin, so borders of features with nans have a sentinel border.
+    void CalcBorders(const TModeQuantizeParams& params,
+                     NPar::TLocalExecutor* localExecutor,
+                     TVector<TVector<float>>* borders,
+                     TVector<ENanMode>* nanModes) {
+        const int featureCount = Samples.ysize();
+        borders->assign(featureCount, TVector<float>());
+        nanModes->assign(featureCount, ENanMode::Forbidden);
+        localExecutor->ExecRangeWithThrow([&](int featureIdx) {
+            if (IsCatFeature[featureIdx]) {
+                return;
+            }
+            TVector<float> values;
+            values.reserve(Samples[featureIdx].size());
+            for (float value : Samples[featureIdx]) {
+                if (!IsNan(value)) {
+                    values.push_back(value);
+                }
+            }
+            TVector<float>().swap(Samples[featureIdx]);
+
+            THashSet<float> borderSet = BestSplit(values, params.BorderCount, params.BorderType);
+            if (borderSet.has(-0.0f)) { // BestSplit might add negative zeros
+                borderSet.erase(-0.0f);
+                borderSet.insert(0.0f);
+            }
+            auto& featureBorders = (*borders)[featureIdx];
+            featureBorders.assign(borderSet.begin(), borderSet.end());
+            Sort(featureBorders.begin(), featureBorders.end());
+
+            if (HasNans[featureIdx]) {
+                CB_ENSURE(params.NanMode != ENanMode::Forbidden,
+                          "There are nan factors and nan values for float features are not allowed. Set nan_mode != Forbidden.");
+                if (params.NanMode == ENanMode::Min) {
+                    featureBorders.insert(featureBorders.begin(), std::numeric_limits<float>::lowest());
+                } else {
+                    featureBorders.push_back(std::numeric_limits<float>::max());
+                }
+                (*nanModes)[featureIdx] = params.NanMode;
+            }
+        }, 0, featureCount, NPar::TLocalExecutor::WAIT_COMPLETE);
+    }
+
+private:
+    size_t SampleSize;
+    TFastRng64 Rand;
+    size_t DocCount = 0;
+    TVector<TVector<float>> Samples; // [featureIdx][sampleDocIdx]
+    TVector<bool> IsCatFeature;
+    TVector<ui8> HasNans; // [featureIdx], not TVector<bool> because it is updated concurrently
+};
+
+template <typename T>
+static TBlob MakeChunkBlob(TConstArrayRef<T> values) {
+    flatbuffers::FlatBufferBuilder builder;
+    builder.Finish(NCB::NIdl::CreateTQuantizedFeatureChunk(
+        builder,
+        static_cast<NCB::NIdl::EBitsPerDocumentFeature>(sizeof(T) * 8),
+        builder.CreateVector(reinterpret_cast<const ui8*>(values.data()), sizeof(T) * values.size())));
+    return TBlob::Copy(builder.GetBufferPointer(), builder.GetSize());
+}
+
+// Accumulates quantized pool block by block, only quantized values are kept in memory.
+class TQuantizedPoolBuilder {
+public:
+    TQuantizedPoolBuilder(const TVector<TColumn>& columns,
+                          TVector<TVector<float>>&& borders,
+                          const TVector<ENanMode>& nanModes,
+                          const TVector<TString>& classNames)
+        : Borders(std::move(borders))
+        , NanModes(nanModes)
+    {
+        // Quantized pool column indices are expected to be contiguous, so columns which can't be stored
+        // are skipped and following columns are renumbered. Feature indices are not affected by that.
+        int featureIdx = 0;
+        int baselineIdx = 0;
+        for (const auto& column : columns) {
+            const EColumn columnType = column.Type;
+            if (!NCB::NQuantizationDetail::IsRequiredColumn(columnType) && columnType != EColumn::Categ) {
+                CB_ENSURE(!IsFactorColumn(columnType), "Features of type " << columnType << " are not supported");
+                MATRIXNET_WARNING_LOG << "Column of type " << columnType << " is not stored in quantized pool" << Endl;
+                continue;
+            }
+
+            const size_t columnIdx = Pool.ColumnTypes.size();
+            Pool.ColumnIndexToLocalIndex.emplace(columnIdx, columnIdx);
+            Pool.ColumnTypes.push_back(columnType);
+            Pool.Chunks.emplace_back();
+            if (columnType == EColumn::Categ) {
+                MATRIXNET_WARNING_LOG << "Categorical feature " << featureIdx << " is not supported in quantized pool, "
+                    << "it is stored without values and should be ignored in training" << Endl;
+                Pool.IgnoredColumnIndices.push_back(columnIdx);
+            } else if (columnType == EColumn::Num && !Borders[featureIdx].empty()) {
+                CB_ENSURE(Borders[featureIdx].size() < 256, "Feature " << featureIdx << " has too many borders: " << Borders[featureIdx].size());
+                NCB::NIdl::TFeatureQuantizationSchema featureSchema;
+                for (float border : Borders[featureIdx]) {
+                    featureSchema.AddBorders(border);
+                }
+                featureSchema.SetNanMode(NCB::NQuantizationSchemaDetail::NanModeToProto(nanModes[featureIdx]));
+                Pool.QuantizationSchema.MutableColumnIndexToSchema()->insert({columnIdx, std::move(featureSchema)});
+            }
+            SourceIndices.push_back(columnType == EColumn::Baseline ? baselineIdx : featureIdx);
+
+            featureIdx += static_cast<int>(IsFactorColumn(columnType));
+            baselineIdx += static_cast<int>(columnType == EColumn::Baseline);
+        }
+        for (const auto& className : classNames) {
+            Pool.QuantizationSchema.AddClassNames(className);
+        }
+    }
+
+    void AddBlock(const TPool& block, NPar::TLocalExecutor* localExecutor) {
+        const auto& docs = block.Docs;
+        const size_t blockDocCount = docs.GetDocCount();
+        TVector<TBlob> blockBlobs(Pool.ColumnTypes.size());
+        localExecutor->ExecRangeWithThrow([&](int columnIdx) {
+            const size_t sourceIdx = SourceIndices[columnIdx];
+            switch (Pool.ColumnTypes[columnIdx]) {
+                case EColumn::Num: {
+                    const auto& borders = Borders[sourceIdx];
+                    if (borders.empty()) {
+                        break;
+                    }
+                    const ENanMode nanMode = NanModes[sourceIdx];
+                    TVector<ui8> bins;
+                    bins.yresize(blockDocCount);
+                    for (size_t docIdx = 0; docIdx < blockDocCount; ++docIdx) {
+                        bins[docIdx] = NCB::Quantize(docs.Factors[sourceIdx][docIdx], borders, nanMode);
+                    }
+                    blockBlobs[columnIdx] = MakeChunkBlob<ui8>(bins);
+                    break;
+                }
+                case EColumn::Label: {
+                    blockBlobs[columnIdx] = MakeChunkBlob<float>(docs.Target);
+                    break;
+                }
+                case EColumn::Weight:
+                case EColumn::GroupWeight: {
+                    blockBlobs[columnIdx] = MakeChunkBlob<float>(docs.Weight);
+                    break;
+                }
+                case EColumn::Baseline: {
+                    blockBlobs[columnIdx] = MakeChunkBlob<double>(docs.Baseline[sourceIdx]);
+                    break;
+                }
+                case EColumn::DocId: {
+                    TVector<ui64> ids;
+                    ids.yresize(blockDocCount);
+                    for (size_t docIdx = 0; docIdx < blockDocCount; ++docIdx) {
+                        CB_ENSURE(TryFromString<ui64>(docs.Id[docIdx], ids[docIdx]),
+                                  "Document id " << docs.Id[docIdx] << " is not an unsigned integer, it can't be stored in quantized pool");
+                    }
+                    blockBlobs[columnIdx] = MakeChunkBlob<ui64>(ids);
+                    break;
+                }
+                case EColumn::GroupId: {
+                    blockBlobs[columnIdx] = MakeChunkBlob<TGroupId>(docs.QueryId);
+                    break;
+                }
+                case EColumn::SubgroupId: {
+                    blockBlobs[columnIdx] = MakeChunkBlob<TSubgroupId>(docs.SubgroupId);
+                    break;
+                }
+                default:
+                    break;
+            }
+        }, 0, blockBlobs.ysize(), NPar::TLocalExecutor::WAIT_COMPLETE);
+
+        for (size_t columnIdx = 0; columnIdx < blockBlobs.size(); ++columnIdx) {
+            if (blockBlobs[columnIdx].Empty()) {
+                continue;
+            }
+            Pool.Blobs.push_back(blockBlobs[columnIdx]);
+            Pool.Chunks[columnIdx].emplace_back(
+                Pool.DocumentCount,
+                blockDocCount,
+                flatbuffers::GetRoot<NCB::NIdl::TQuantizedFeatureChunk>(Pool.Blobs.back().AsCharPtr()));
+        }
+        Pool.DocumentCount += blockDocCount;
+    }
+
+    const NCB::TQuantizedPool& GetPool() const {
+        return Pool;
+    }
+
+private:
+    TVector<TVector<float>> Borders; // [featureIdx]
+    TVector<ENanMode> NanModes; // [featureIdx]
+    NCB::TQuantizedPool Pool;
+    TVector<size_t> SourceIndices; // [columnIdx] -> feature or baseline index in pool blocks
+};
+
+int mode_quantize(int argc, const char* argv[]) {
+    TAnalyticalModeCommonParams params;
+    TModeQuantizeParams quantizeParams;
+    bool verbose = false;
+
+    auto parser = NLastGetopt::TOpts();
+    parser.AddHelpOption();
+    BindDsvPoolFormatParams(&parser, &params.DsvPoolFormatParams);
+    parser.AddLongOption("input-path", "input path")
+        .DefaultValue("input.tsv")
+        .Handler1T<TStringBuf>([&](const TStringBuf& str) {
+            params.InputPath = NCB::TPathWithScheme(str, "dsv");
+        });
+    parser.AddLongOption('o', "output-path", "quantized pool path")
+        .StoreResult(&params.OutputPath)
+        .DefaultValue("pool.quantized");
+    parser.AddLongOption('T', "thread-count", "worker thread count (default: core count)")
+        .StoreResult(&params.ThreadCount);
+    parser.AddLongOption("class-names", "names for classes.")
+        .RequiredArgument("comma separated list of names")
+        .Handler1T<TString>([&](const TString& namesLine) {
+            for (const auto& t : StringSplitter(namesLine).Split(',')) {
+                params.ClassNames.push_back(FromString<TString>(t.Token()));
+            }
+        });
+    quantizeParams.BindParserOpts(parser);
+    parser.AddLongOption("verbose")
+        .SetFlag(&verbose)
+        .NoArgument();
+    parser.SetFreeArgsNum(0);
+    NLastGetopt::TOptsParseResult parserResult{&parser, argc, argv};
+
+    CB_ENSURE(params.InputPath.Scheme == "dsv", "Only dsv pools can be quantized");
+    CB_ENSURE(quantizeParams.BorderCount > 0 && quantizeParams.BorderCount < 255, "Border count should be in range [1, 254]");
+    CB_ENSURE(quantizeParams.BlockSize > 0, "Block size should be positive");
+    CB_ENSURE(quantizeParams.SampleSize > 0, "Sample size should be positive");
+
+    NPar::TLocalExecutor executor;
+    executor.RunAdditionalThreads(params.ThreadCount - 1);
+
+    // The pool is read twice: to sample float feature values and select borders and then to quantize it.
+    // Only one block of documents is parsed at a time, so the source pool is never fully materialized.
+    TFloatFeaturesSampler sampler(quantizeParams.SampleSize, quantizeParams.RandomSeed);
+    TVector<TColumn> columns;
+    if (!verbose) {
+        SetSilentLogingMode();
+    }
+    ReadAndProceedPoolInBlocks(params, quantizeParams.BlockSize, [&](const TPool& poolPart) {
+        if (columns.empty()) {
+            CB_ENSURE(poolPart.MetaInfo.ColumnsInfo.Defined(), "Pool has no columns description");
+            columns = poolPart.MetaInfo.ColumnsInfo->Columns;
+        }
+        sampler.AddBlock(poolPart, &executor);
+    }, &executor);
+    SetVerboseLogingMode();
+    CB_ENSURE(sampler.GetDocCount() > 0, "Pool is empty");
+    MATRIXNET_INFO_LOG << "Sampled " << Min<size_t>(sampler.GetDocCount(), quantizeParams.SampleSize)
+        << " of " << sampler.GetDocCount() << " documents" << Endl;
+
+    TVector<TVector<float>> borders;
+    TVector<ENanMode> nanModes;
+    sampler.CalcBorders(quantizeParams, &executor, &borders, &nanModes);
+    MATRIXNET_INFO_LOG << "Borders for float features generated" << Endl;
+
+    TQuantizedPoolBuilder builder(columns, std::move(borders), nanModes, params.ClassNames);
+    if (!verbose) {
+        SetSilentLogingMode();
+    }
+    ReadAndProceedPoolInBlocks(params, quantizeParams.BlockSize, [&](const TPool& poolPart) {
+        builder.AddBlock(poolPart, &executor);
+    }, &executor);
+    SetVerboseLogingMode();
+    CB_ENSURE(builder.GetPool().DocumentCount == sampler.GetDocCount(), "Pool has changed while it was quantized");
+
+    {
+        TOFStream output(params.OutputPath);
+        NCB::SaveQuantizedPool(builder.GetPool(), &output);
+    }
+    MATRIXNET_INFO_LOG << "Quantized pool saved to " << params.OutputPath << Endl;
+    return 0;
+}
@@ -591,9 +591,8 @@ void NCatboostCuda::ReadPool(
     // TODO(yazevnul): load data in multiple threads. One thread reads from disk, other adds chunk
     // to the `poolBuilder`
 
-    // TODO(yazevnul): load using `TFile::Pread` instead of mapping entire file; at least until we
-    // keep this interface where we are not using chunks directly
-
+    // Pool is mapped without precharging, every column is read from file when it is added to the
+    // builder and evicted right after that, so memory used by the mapping stays bounded by one column.
     NCB::TLoadQuantizedPoolParameters loadParameters;
     loadParameters.LockMemory = false;
     loadParameters.Precharge = false;
@@ -620,7 +619,9 @@ void NCatboostCuda::ReadPool(
         }
 
         const auto featureIndex = columnIndexToFeatureIndex.Value(columnIndex, 0);
+        NCB::AdviseSequentialColumnAccess(pool, localIndex);
         ::AddColumn(featureIndex, baselineIndex, columnType, pool.Chunks[localIndex], poolBuilder);
+        NCB::EvictColumn(pool, localIndex);
 
         baselineIndex += static_cast<size_t>(columnType == EColumn::Baseline);
     }
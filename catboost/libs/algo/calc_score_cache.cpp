@@ -6,6 +6,14 @@ bool IsSamplingPerTree(const NCatboostOptions::TObliviousTreeLearnerOptions& fit
     return fitParams.SamplingFrequency.Get() == ESamplingFrequency::PerTree;
 }
 
+bool AreStatsFromPrevTreeLevelReusable(const NCatboostOptions::TObliviousTreeLearnerOptions& fitParams, bool isPairwiseScoring) {
+    // TODO(nikitxskv): Pairwise scoring doesn't use statistics from previous tree level. Need to fix it.
+    if (isPairwiseScoring || !fitParams.DevScoreCalcStatsSubtraction.Get()) {
+        return false;
+    }
+    return IsSamplingPerTree(fitParams) || fitParams.BootstrapConfig->GetBootstrapType() == EBootstrapType::No;
+}
+
 TVector<TBucketStats, TPoolAllocator>& TBucketStatsCache::GetStats(const TSplitCandidate& split, int statsCount, bool* areStatsDirty) {
     TVector<TBucketStats, TPoolAllocator>* splitStats;
     with_lock(Lock) {
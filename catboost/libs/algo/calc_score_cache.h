@@ -13,6 +13,9 @@
 
 bool IsSamplingPerTree(const NCatboostOptions::TObliviousTreeLearnerOptions& fitParams);
 
+// Stats of the larger split side are parent minus sibling if documents sample is the same for all tree levels
+bool AreStatsFromPrevTreeLevelReusable(const NCatboostOptions::TObliviousTreeLearnerOptions& fitParams, bool isPairwiseScoring);
+
 template<typename TData, typename TAlloc>
 static inline TData* GetDataPtr(TVector<TData, TAlloc>& data, size_t offset = 0) {
     return data.empty() ? nullptr : data.data() + offset;
@@ -24,6 +24,7 @@ void BuildCvPools(
     // TODO(annaveronika): one split for all cv.
     CB_ENSURE(foldIdx >= 0 && foldIdx < foldCount);
     CB_ENSURE(learnPool->Docs.GetDocCount() > 1, "Not enough documents for cross validataion");
+    CB_ENSURE(learnPool->Docs.QuantizedFactors.empty(), "Cross validation is not supported for quantized pools");
 
     TRestorableFastRng64 rand(seed);
     TVector<ui64> permutation;
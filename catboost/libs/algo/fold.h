@@ -75,6 +75,18 @@ struct TFold {
         return GetCtrs(proj).at(proj);
     }
 
+    //! Mark ctr of projection as used on iteration, returns true if ctr values are already calculated
+    bool TouchCtr(const TProjection& proj, ui64 iteration) {
+        TOnlineCTR& ctr = GetCtrRef(proj);
+        ctr.LastUseIteration = iteration;
+        ++ctr.UseCount;
+        return !ctr.Feature.empty();
+    }
+
+    void EraseCtr(const TProjection& proj) {
+        GetCtrs(proj).erase(proj);
+    }
+
     void DropEmptyCTRs();
 
     const std::tuple<const TOnlineCTRHash&, const TOnlineCTRHash&> GetAllCtrs() const {
@@ -96,11 +108,6 @@ struct TFold {
         return BodyTailArr[0].Approx.ysize();
     }
 
-    void TrimOnlineCTR(size_t maxOnlineCTRFeatures) {
-        if (OnlineCTR.size() > maxOnlineCTRFeatures) {
-            OnlineCTR.clear();
-        }
-    }
 
     const TVector<float>& GetLearnWeights() const { return LearnWeights; }
 
@@ -120,9 +120,7 @@ static inline void BinarizeFloatFeature(int featureIdx,
                                         bool* seenNans) {
     size_t docCount = docSelector.GetDocCount();
     const TVector<float>& src = docStorage.Factors[featureIdx];
-    TVector<ui8>& hist = features->FloatHistograms[floatFeatureIdx];
-
-    hist.resize(docCount);
+    TVector<ui8> hist(docCount);
 
     ui8* histData = hist.data();
     const float* featureBorderData = borders.data();
@@ -144,6 +142,34 @@ static inline void BinarizeFloatFeature(int featureIdx,
     }
     , NPar::TLocalExecutor::TExecRangeParams(0, docCount).SetBlockSize(1000)
     , NPar::TLocalExecutor::WAIT_COMPLETE);
+
+    features->FloatHistograms[floatFeatureIdx] = PackBins(hist, TPackedBins::GetBitsPerValue(featureBorderSize), &localExecutor);
+}
+
+/// Take bins of already quantized feature from `quantizedFactor` into float feature `floatFeatureIdx` in `features`.
+/// Bins are moved without copying if all documents are selected and the pool may be cleared.
+static inline void TakeQuantizedFloatFeature(TQuantizedFactor* quantizedFactor,
+                                             const TVector<size_t>& selectedDocIndices,
+                                             bool clearPool,
+                                             NPar::TLocalExecutor& localExecutor,
+                                             int floatFeatureIdx,
+                                             TAllFeatures* features) {
+    TPackedBins& bins = quantizedFactor->Bins;
+    TPackedBins& dstBins = features->FloatHistograms[floatFeatureIdx];
+    if (!selectedDocIndices.empty()) {
+        TVector<ui8> hist(selectedDocIndices.size());
+        for (size_t i = 0; i < selectedDocIndices.size(); ++i) {
+            hist[i] = bins[selectedDocIndices[i]];
+        }
+        dstBins = PackBins(hist, bins.GetBitsPerValue(), &localExecutor);
+    } else if (clearPool) {
+        dstBins = std::move(bins);
+    } else {
+        dstBins = bins;
+    }
+    if (clearPool) {
+        bins = TPackedBins();
+    }
 }
 
 /// Allocate binarized data holders in `features`.
@@ -309,12 +335,22 @@ namespace {
                         }
                     } else {
                         int floatFeatureIdx = TypedFeatureIdx[featureIdx];
+                        TQuantizedFactor* quantizedFactor = docStorage->QuantizedFactors.FindPtr(featureIdx);
                         if (FloatFeatures[floatFeatureIdx].Borders.empty()) {
                             if (clearPool) {
                                 ClearVector(&docStorage->Factors[featureIdx]);
+                                if (quantizedFactor) {
+                                    quantizedFactor->Bins = TPackedBins();
+                                }
                             }
                             continue;
                         }
+                        if (quantizedFactor) {
+                            CB_ENSURE(quantizedFactor->Borders == FloatFeatures[floatFeatureIdx].Borders,
+                                      "Feature " << featureIdx << " is quantized with borders different from learn dataset ones");
+                            TakeQuantizedFloatFeature(quantizedFactor, selectedDocIndices, clearPool, LocalExecutor, floatFeatureIdx, features);
+                            continue;
+                        }
                         bool seenNans = false;
                         if (selectedDocIndices.empty()) {
                             BinarizeFloatFeature(featureIdx, *docStorage, TSelectAll(docStorage->GetDocCount()),
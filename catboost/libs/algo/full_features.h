@@ -2,6 +2,7 @@
 
 #include <catboost/libs/options/enums.h>
 #include <catboost/libs/data/pool.h>
+#include <catboost/libs/helpers/packed_bins.h>
 #include <catboost/libs/model/features.h>
 #include <library/binsaver/bin_saver.h>
 #include <library/threading/local_executor/local_executor.h>
@@ -12,8 +13,9 @@
 
 
 struct TAllFeatures {
-    TVector<TVector<ui8>> FloatHistograms; // [featureIdx][doc]
+    TVector<TPackedBins> FloatHistograms; // [featureIdx][doc]
     // FloatHistograms[featureIdx] might be empty if feature is const.
+    // Bins are packed by minimal bit count fitting feature border count.
     TVector<TVector<int>> CatFeaturesRemapped; // [featureIdx][doc]
     TVector<TVector<int>> OneHotValues; // [featureIdx][valueIdx]
     TVector<bool> IsOneHot;
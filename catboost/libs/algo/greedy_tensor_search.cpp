@@ -11,14 +11,86 @@
 
 #include <library/fast_log/fast_log.h>
 
+#include <util/generic/algorithm.h>
 #include <util/string/builder.h>
 #include <util/system/mem_info.h>
 
 constexpr size_t MAX_ONLINE_CTR_FEATURES = 50;
 
-void TrimOnlineCTRcache(const TVector<TFold*>& folds) {
-    for (auto& fold : folds) {
-        fold->TrimOnlineCTR(MAX_ONLINE_CTR_FEATURES);
+namespace {
+    struct TCachedCtr {
+        TFold* Fold;
+        TProjection Projection;
+        ui64 LastUseIteration;
+        ui64 UseCount;
+        size_t MemoryUsage;
+    };
+}
+
+static void AddCachedCtrs(const TOnlineCTRHash& ctrs, TFold* fold, TVector<TCachedCtr>* cachedCtrs) {
+    for (const auto& projCtr : ctrs) {
+        const TOnlineCTR& ctr = projCtr.second;
+        cachedCtrs->push_back({fold, projCtr.first, ctr.LastUseIteration, ctr.UseCount, ctr.GetMemoryUsage()});
+    }
+}
+
+void TrimOnlineCTRcache(const TVector<TFold*>& folds, TLearnContext* ctx) {
+    const TString& cacheSizeDescription = ctx->Params.SystemOptions->CpuOnlineCtrCacheSize;
+    const bool hasMemoryBudget = !cacheSizeDescription.empty();
+
+    // without memory budget only count of tree ctrs in every fold is limited
+    TVector<TCachedCtr> cachedCtrs;
+    THashMap<TFold*, size_t> treeCtrCount;
+    for (TFold* fold : folds) {
+        const auto& allCtrs = fold->GetAllCtrs();
+        if (hasMemoryBudget) {
+            AddCachedCtrs(std::get<0>(allCtrs), fold, &cachedCtrs);
+        }
+        AddCachedCtrs(std::get<1>(allCtrs), fold, &cachedCtrs);
+        treeCtrCount[fold] = std::get<1>(allCtrs).size();
+    }
+    // least recently used first, less frequently used first among equally recent
+    Sort(cachedCtrs.begin(), cachedCtrs.end(), [](const TCachedCtr& lhs, const TCachedCtr& rhs) {
+        return std::tie(lhs.LastUseIteration, lhs.UseCount) < std::tie(rhs.LastUseIteration, rhs.UseCount);
+    });
+
+    // ctrs used on current iteration are needed for tree being built
+    const ui64 currentIteration = ctx->LearnProgress.TreeStruct.size();
+    auto& stats = ctx->OnlineCtrCacheStats;
+    const ui64 evictedCtrsBefore = stats.EvictedCtrs;
+    const ui64 evictedBytesBefore = stats.EvictedBytes;
+    auto evictCtr = [&stats] (const TCachedCtr& ctr) {
+        ctr.Fold->EraseCtr(ctr.Projection);
+        ++stats.EvictedCtrs;
+        stats.EvictedBytes += ctr.MemoryUsage;
+    };
+    if (hasMemoryBudget) {
+        const ui64 memoryBudget = ParseMemorySizeDescription(cacheSizeDescription);
+        ui64 memoryUsage = 0;
+        for (const auto& ctr : cachedCtrs) {
+            memoryUsage += ctr.MemoryUsage;
+        }
+        for (const auto& ctr : cachedCtrs) {
+            if (memoryUsage <= memoryBudget || ctr.LastUseIteration == currentIteration) {
+                break;
+            }
+            if (ctr.MemoryUsage > 0) {
+                evictCtr(ctr);
+                memoryUsage -= ctr.MemoryUsage;
+            }
+        }
+    } else {
+        for (const auto& ctr : cachedCtrs) {
+            size_t& foldTreeCtrCount = treeCtrCount[ctr.Fold];
+            if (foldTreeCtrCount > MAX_ONLINE_CTR_FEATURES && ctr.LastUseIteration != currentIteration) {
+                evictCtr(ctr);
+                --foldTreeCtrCount;
+            }
+        }
+    }
+    if (stats.EvictedCtrs > evictedCtrsBefore) {
+        MATRIXNET_DEBUG_LOG << "Online ctr cache: evicted " << stats.EvictedCtrs - evictedCtrsBefore << " ctrs, "
+            << (stats.EvictedBytes - evictedBytesBefore) / (1024 * 1024) << " Mb" << Endl;
     }
 }
 
@@ -237,6 +309,31 @@ static void SelectCtrsToDropAfterCalc(size_t memoryLimit,
     }
 }
 
+// Estimate of unique values count of projection, the same as the one reserving rehash table for ctr computation
+static size_t EstimateUniqueValueCount(const TProjection& proj, const TAllFeatures& allFeatures, size_t learnSampleCount) {
+    size_t uniqueValueCount = 1;
+    for (auto cf : proj.CatFeatures) {
+        uniqueValueCount *= allFeatures.OneHotValues[cf].size();
+        if (uniqueValueCount > learnSampleCount) {
+            break;
+        }
+    }
+    return Min(uniqueValueCount, learnSampleCount);
+}
+
+// Relative cost of scoring candidate list in passes over documents: every candidate accumulates stats in one pass.
+// Online ctrs missing in cache are computed first, with a pass per candidate too, but with random access
+// to counters of unique values, which is slower for projections of higher cardinality.
+static double EstimateCandidateListCost(const TCandidatesInfoList& candidate, const TAllFeatures& allFeatures, TFold* fold) {
+    const double candidateCount = candidate.Candidates.size();
+    const auto& split = candidate.Candidates[0].SplitCandidate;
+    if (split.Type != ESplitType::OnlineCtr || !fold->GetCtrRef(split.Ctr.Projection).Feature.empty()) {
+        return candidateCount;
+    }
+    const size_t uniqueValueCount = EstimateUniqueValueCount(split.Ctr.Projection, allFeatures, fold->GetLearnSampleCount());
+    return candidateCount * (1 + FastLog2f(1 + uniqueValueCount));
+}
+
 static void CalcBestScore(const TDataset& learnData,
         const TDatasetPtrs& testDataPtrs,
         const TVector<int>& splitCounts,
@@ -249,42 +346,88 @@ static void CalcBestScore(const TDataset& learnData,
     CB_ENSURE(static_cast<ui32>(ctx->LocalExecutor.GetThreadCount()) == ctx->Params.SystemOptions->NumThreads - 1);
 
     TCandidateList& candList = *candidateList;
-    ctx->LocalExecutor.ExecRange([&](int id) {
+    const ui64 iteration = ctx->LearnProgress.TreeStruct.size();
+    for (const auto& candidate : candList) {
+        const auto& splitCandidate = candidate.Candidates[0].SplitCandidate;
+        if (splitCandidate.Type == ESplitType::OnlineCtr) {
+            ctx->OnlineCtrCacheStats.AddLookup(fold->TouchCtr(splitCandidate.Ctr.Projection, iteration));
+        }
+    }
+
+    // Candidate lists are scored in parallel and their candidates in nested parallel loops.
+    // Threads are shared between lists in proportion to their estimated cost, so document blocks of candidates
+    // of dominant lists, e.g. a high-cardinality ctr among many cheap features, are also processed in parallel.
+    // Blocks don't depend on threads count, so the model doesn't depend on it too.
+    const int threadCount = ctx->Params.SystemOptions->NumThreads;
+    TVector<double> candidateListCosts;
+    double totalCost = 0;
+    for (const auto& candidate : candList) {
+        candidateListCosts.push_back(EstimateCandidateListCost(candidate, learnData.AllFeatures, fold));
+        totalCost += candidateListCosts.back();
+    }
+    TBusyTimeCounter busyTime;
+    TVector<TDocBlocksParallelism> docBlocksParallelism;
+    for (int id = 0; id < candList.ysize(); ++id) {
+        const double threadShare = threadCount * candidateListCosts[id] / totalCost;
+        docBlocksParallelism.push_back({
+            Max(1, static_cast<int>(threadShare / candList[id].Candidates.ysize())),
+            &ctx->LocalExecutor,
+            &busyTime
+        });
+    }
+    // start the most expensive candidate lists first for better load balance
+    TVector<int> candidateListOrder(candList.ysize());
+    Iota(candidateListOrder.begin(), candidateListOrder.end(), 0);
+    StableSort(candidateListOrder.begin(), candidateListOrder.end(), [&candidateListCosts](int lhs, int rhs) {
+        return candidateListCosts[lhs] > candidateListCosts[rhs];
+    });
+
+    THPTimer wallTimer;
+    ctx->LocalExecutor.ExecRange([&](int orderIdx) {
+        const int id = candidateListOrder[orderIdx];
         auto& candidate = candList[id];
-        if (candidate.Candidates[0].SplitCandidate.Type == ESplitType::OnlineCtr) {
-            const auto& proj = candidate.Candidates[0].SplitCandidate.Ctr.Projection;
-            if (fold->GetCtrRef(proj).Feature.empty()) {
-                ComputeOnlineCTRs(learnData,
-                                  testDataPtrs,
-                                  *fold,
-                                  proj,
-                                  ctx,
-                                  &fold->GetCtrRef(proj));
+        busyTime.Measure([&]() {
+            if (candidate.Candidates[0].SplitCandidate.Type == ESplitType::OnlineCtr) {
+                const auto& proj = candidate.Candidates[0].SplitCandidate.Ctr.Projection;
+                if (fold->GetCtrRef(proj).Feature.empty()) {
+                    ComputeOnlineCTRs(learnData,
+                                      testDataPtrs,
+                                      *fold,
+                                      proj,
+                                      ctx,
+                                      &fold->GetCtrRef(proj));
+                }
             }
-        }
-        TVector<TVector<double>> allScores(candidate.Candidates.size());
-        ctx->LocalExecutor.ExecRange([&](int oneCandidate) {
-            if (candidate.Candidates[oneCandidate].SplitCandidate.Type == ESplitType::OnlineCtr) {
-                const auto& proj = candidate.Candidates[oneCandidate].SplitCandidate.Ctr.Projection;
-                Y_ASSERT(!fold->GetCtrRef(proj).Feature.empty());
+            TVector<TVector<double>> allScores(candidate.Candidates.size());
+            busyTime.Exclude([&]() {
+                ctx->LocalExecutor.ExecRange([&](int oneCandidate) {
+                    busyTime.Measure([&]() {
+                        if (candidate.Candidates[oneCandidate].SplitCandidate.Type == ESplitType::OnlineCtr) {
+                            const auto& proj = candidate.Candidates[oneCandidate].SplitCandidate.Ctr.Projection;
+                            Y_ASSERT(!fold->GetCtrRef(proj).Feature.empty());
+                        }
+                        allScores[oneCandidate] = GetScores(CalcScore(learnData.AllFeatures,
+                                                    splitCounts,
+                                                    fold->GetAllCtrs(),
+                                                    ctx->SampledDocs,
+                                                    ctx->SmallestSplitSideDocs,
+                                                    *fold,
+                                                    ctx->Params,
+                                                    candidate.Candidates[oneCandidate].SplitCandidate,
+                                                    currentDepth,
+                                                    &ctx->PrevTreeLevelStats,
+                                                    docBlocksParallelism[id]));
+                    });
+                }, NPar::TLocalExecutor::TExecRangeParams(0, candidate.Candidates.ysize())
+                 , NPar::TLocalExecutor::WAIT_COMPLETE);
+            });
+            if (candidate.Candidates[0].SplitCandidate.Type == ESplitType::OnlineCtr && candidate.ShouldDropCtrAfterCalc) {
+                fold->GetCtrRef(candidate.Candidates[0].SplitCandidate.Ctr.Projection).Feature.clear();
             }
-            allScores[oneCandidate] = GetScores(CalcScore(learnData.AllFeatures,
-                                        splitCounts,
-                                        fold->GetAllCtrs(),
-                                        ctx->SampledDocs,
-                                        ctx->SmallestSplitSideDocs,
-                                        *fold,
-                                        ctx->Params,
-                                        candidate.Candidates[oneCandidate].SplitCandidate,
-                                        currentDepth,
-                                        &ctx->PrevTreeLevelStats));
-        }, NPar::TLocalExecutor::TExecRangeParams(0, candidate.Candidates.ysize())
-         , NPar::TLocalExecutor::WAIT_COMPLETE);
-        if (candidate.Candidates[0].SplitCandidate.Type == ESplitType::OnlineCtr && candidate.ShouldDropCtrAfterCalc) {
-            fold->GetCtrRef(candidate.Candidates[0].SplitCandidate.Ctr.Projection).Feature.clear();
-        }
-        SetBestScore(randSeed + id, allScores, scoreStDev, &candidate.Candidates);
+            SetBestScore(randSeed + id, allScores, scoreStDev, &candidate.Candidates);
+        });
     }, 0, candList.ysize(), NPar::TLocalExecutor::WAIT_COMPLETE);
+    ctx->Profile.AddThreadUtilization(busyTime.GetBusyTime(), wallTimer.Passed(), threadCount);
 }
 
 void GreedyTensorSearch(const TDataset& learnData,
@@ -296,7 +439,7 @@ void GreedyTensorSearch(const TDataset& learnData,
                         TLearnContext* ctx,
                         TSplitTree* resSplitTree) {
     TSplitTree currentSplitTree;
-    TrimOnlineCTRcache({fold});
+    TrimOnlineCTRcache({fold}, ctx);
 
     int learnSampleCount = learnData.GetSampleCount();
     int testSampleCount = GetSampleCount(testDataPtrs);
@@ -307,13 +450,20 @@ void GreedyTensorSearch(const TDataset& learnData,
         MapTensorSearchStart(ctx);
     }
 
-    const bool isSamplingPerTree = IsSamplingPerTree(ctx->Params.ObliviousTreeOptions);
+    const bool isPairwiseScoring = IsPairwiseScoring(ctx->Params.LossFunctionDescription->GetLossFunction());
+    // Distributed workers decide on stats reuse by sampling frequency only
+    const bool areStatsReusable = ctx->Params.SystemOptions->IsSingleHost()
+        && AreStatsFromPrevTreeLevelReusable(ctx->Params.ObliviousTreeOptions, isPairwiseScoring);
+    // Sample without bootstrap doesn't depend on tree level, so it is taken once per tree when stats are reused
+    const bool isSamplingPerTree = IsSamplingPerTree(ctx->Params.ObliviousTreeOptions) || areStatsReusable;
     if (isSamplingPerTree) {
         if (!ctx->Params.SystemOptions->IsSingleHost()) {
             MapBootstrap(ctx);
         } else {
             Bootstrap(ctx->Params, indices, fold, &ctx->SampledDocs, &ctx->LocalExecutor, &ctx->Rand);
         }
+    }
+    if (areStatsReusable) {
         ctx->PrevTreeLevelStats.GarbageCollect();
     }
 
@@ -394,7 +544,9 @@ void GreedyTensorSearch(const TDataset& learnData,
         auto bestSplit = TSplit(bestSplitCandidate->SplitCandidate, bestSplitCandidate->BestBinBorderId);
         if (bestSplit.Type == ESplitType::OnlineCtr) {
             const auto& proj = bestSplit.Ctr.Projection;
-            if (fold->GetCtrRef(proj).Feature.empty()) {
+            const bool isCtrCached = fold->TouchCtr(proj, ctx->LearnProgress.TreeStruct.size());
+            ctx->OnlineCtrCacheStats.AddLookup(isCtrCached);
+            if (!isCtrCached) {
                 ComputeOnlineCTRs(learnData,
                                   testDataPtrs,
                                   *fold,
@@ -409,8 +561,7 @@ void GreedyTensorSearch(const TDataset& learnData,
             SetPermutedIndices(bestSplit, learnData.AllFeatures, curDepth + 1, *fold, &indices, &ctx->LocalExecutor);
             if (isSamplingPerTree) {
                 ctx->SampledDocs.UpdateIndices(indices, &ctx->LocalExecutor);
-                // TODO(nikitxskv): Pairwise scoring doesn't use statistics from previous tree level. Need to fix it.
-                if (!IsPairwiseScoring(ctx->Params.LossFunctionDescription->GetLossFunction())) {
+                if (areStatsReusable) {
                     ctx->SmallestSplitSideDocs.SelectSmallestSplitSide(curDepth + 1, ctx->SampledDocs, &ctx->LocalExecutor);
                 }
             }
@@ -6,7 +6,8 @@
 
 #include <util/generic/vector.h>
 
-void TrimOnlineCTRcache(const TVector<TFold*>& folds);
+// Evict least recently used online ctrs of folds to fit online ctr cache limits
+void TrimOnlineCTRcache(const TVector<TFold*>& folds, TLearnContext* ctx);
 
 void GreedyTensorSearch(const TDataset& learnData,
                         const TDatasetPtrs& testDataPtrs,
@@ -74,6 +74,21 @@ void GenerateBorders(const TPool& pool, TLearnContext* ctx, TVector<TFloatFeatur
             return;
         }
 
+        if (const TQuantizedFactor* quantizedFactor = docStorage.QuantizedFactors.FindPtr(floatFeatureIdx)) {
+            // Borders of quantized features are fixed by their quantization, nan values are in the first or the last bin
+            CB_ENSURE(quantizedFactor->NanMode == ENanMode::Forbidden || quantizedFactor->NanMode == nanMode,
+                      "Feature " << floatFeatureIdx << " is quantized with nan mode " << quantizedFactor->NanMode
+                      << " but nan_mode " << nanMode << " is used for training");
+            floatFeature.Borders = quantizedFactor->Borders;
+            floatFeature.HasNans = quantizedFactor->NanMode != ENanMode::Forbidden;
+            if (floatFeature.HasNans) {
+                floatFeature.NanValueTreatment = nanMode == ENanMode::Min
+                    ? NCatBoostFbs::ENanValueTreatment_AsFalse
+                    : NCatBoostFbs::ENanValueTreatment_AsTrue;
+            }
+            return;
+        }
+
         TVector<float> vals;
         vals.reserve(samplesToBuildBorders);
         for (size_t i = 0; i < samplesToBuildBorders; ++i) {
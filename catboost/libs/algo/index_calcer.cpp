@@ -23,7 +23,7 @@ static inline ui8 GetFeatureSplitIdx(const TSplit& split) {
     return split.BinBorder;
 }
 
-static inline const TVector<ui8>& GetFloatHistogram(const TSplit& split, const TAllFeatures& features) {
+static inline const TPackedBins& GetFloatHistogram(const TSplit& split, const TAllFeatures& features) {
     return features.FloatHistograms[split.FeatureIdx];
 }
 
@@ -31,8 +31,9 @@ static inline const TVector<int>& GetRemappedCatFeatures(const TSplit& split, co
     return features.CatFeaturesRemapped[split.FeatureIdx];
 }
 
-template <typename TCount, bool (*CmpOp)(TCount, TCount), int vectorWidth>
-void BuildIndicesKernel(const size_t* permutation, const TCount* histogram, TCount value, int level, TIndexType* indices) {
+// THistogram is pointer to bucket values or TPackedBins
+template <typename TCount, bool (*CmpOp)(TCount, TCount), int vectorWidth, typename THistogram>
+void BuildIndicesKernel(const size_t* permutation, const THistogram& histogram, TCount value, int level, TIndexType* indices) {
     Y_ASSERT(vectorWidth == 4);
     const int perm0 = permutation[0];
     const int perm1 = permutation[1];
@@ -52,11 +53,11 @@ void BuildIndicesKernel(const size_t* permutation, const TCount* histogram, TCou
     indices[3] = idx3 + CmpOp(hist3, value) * level;
 }
 
-template <typename TCount, bool (*CmpOp)(TCount, TCount)>
+template <typename TCount, bool (*CmpOp)(TCount, TCount), typename THistogram>
 void OfflineCtrBlock(const NPar::TLocalExecutor::TExecRangeParams& params,
                      int blockIdx,
                      const TFold& fold,
-                     const TCount* histogram,
+                     const THistogram& histogram,
                      TCount value,
                      int level,
                      TIndexType* indices) {
@@ -90,7 +91,7 @@ void SetPermutedIndices(const TSplit& split,
     TIndexType* indicesData = indices->data();
     if (split.Type == ESplitType::FloatFeature) {
         localExecutor->ExecRange([&](int blockIdx) {
-            OfflineCtrBlock<ui8, IsTrueHistogram>(blockParams, blockIdx, fold, GetFloatHistogram(split, features).data(),
+            OfflineCtrBlock<ui8, IsTrueHistogram>(blockParams, blockIdx, fold, GetFloatHistogram(split, features),
                                                   GetFeatureSplitIdx(split), splitWeight, indicesData);
         }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
     } else if (split.Type == ESplitType::OnlineCtr) {
@@ -165,7 +166,7 @@ static void BuildIndicesForLearn(const TSplitTree& tree,
             const int splitWeight = 1 << splitIdx;
             if (split.Type == ESplitType::FloatFeature) {
                 OfflineCtrBlock<ui8, IsTrueHistogram>(learnBlockParams, blockIdx, fold,
-                    GetFloatHistogram(split, learnData.AllFeatures).data(),
+                    GetFloatHistogram(split, learnData.AllFeatures),
                     GetFeatureSplitIdx(split), splitWeight, indices);
             } else if (split.Type == ESplitType::OnlineCtr) {
                 const TOnlineCTR& splitOnlineCtr = *onlineCtrs[splitIdx];
@@ -202,9 +203,9 @@ static void BuildIndicesForTest(const TSplitTree& tree,
             const int splitWeight = 1 << splitIdx;
             if (split.Type == ESplitType::FloatFeature) {
                 const ui8 featureSplitIdx = GetFeatureSplitIdx(split);
-                const ui8* floatHistogramData = GetFloatHistogram(split, testData.AllFeatures).data();
+                const TPackedBins& floatHistogram = GetFloatHistogram(split, testData.AllFeatures);
                 NPar::TLocalExecutor::BlockedLoopBody(tailBlockParams, [&](int doc) {
-                    tailIndices[doc] += IsTrueHistogram(floatHistogramData[doc], featureSplitIdx) * splitWeight;
+                    tailIndices[doc] += IsTrueHistogram(floatHistogram[doc], featureSplitIdx) * splitWeight;
                 })(blockIdx);
             } else if (split.Type == ESplitType::OnlineCtr) {
                 const TOnlineCTR& splitOnlineCtr = *onlineCtrs[splitIdx];
@@ -1,5 +1,41 @@
 #include "index_hash_calcer.h"
 
+// smaller blocks are not worth parallel processing
+static constexpr size_t MinParallelBlockSize = 1 << 16;
+
+static int GetParallelBlockCount(size_t size, NPar::TLocalExecutor* localExecutor) {
+    return Max<size_t>(1, Min<size_t>(localExecutor->GetThreadCount() + 1, size / MinParallelBlockSize));
+}
+
+void CalcHashes(const TProjection& proj,
+                const TAllFeatures& allFeatures,
+                size_t offset,
+                const TVector<size_t>* learnPermutation,
+                bool calculateExactCatHashes,
+                ui64* begin,
+                ui64* end,
+                NPar::TLocalExecutor* localExecutor) {
+    const size_t sampleCount = end - begin;
+    if (sampleCount == 0) {
+        return;
+    }
+    if (learnPermutation != nullptr) {
+        Y_VERIFY(offset == 0);
+        Y_VERIFY(sampleCount == learnPermutation->size());
+    }
+    NPar::TLocalExecutor::TExecRangeParams blockParams(0, sampleCount);
+    blockParams.SetBlockCount(GetParallelBlockCount(sampleCount, localExecutor));
+    localExecutor->ExecRange([&](int blockId) {
+        const size_t blockStart = blockId * blockParams.GetBlockSize();
+        const size_t blockEnd = Min<size_t>(sampleCount, blockStart + blockParams.GetBlockSize());
+        if (learnPermutation != nullptr) {
+            CalcPermutedHashes(proj, allFeatures, 0, learnPermutation->data() + blockStart, calculateExactCatHashes, begin + blockStart, begin + blockEnd);
+        } else {
+            CalcPermutedHashes(proj, allFeatures, offset + blockStart, nullptr, calculateExactCatHashes, begin + blockStart, begin + blockEnd);
+        }
+    }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+}
+
 /// Compute reindexHash and reindex hash values in range [begin,end).
 size_t ComputeReindexHash(ui64 topSize,
                           TDenseHash<ui64, ui32>* reindexHashPtr,
@@ -74,3 +110,53 @@ size_t UpdateReindexHash(TDenseHash<ui64, ui32>* reindexHashPtr, ui64* begin, ui
     }
     return reindexHash.Size();
 }
+
+size_t UpdateReindexHash(TDenseHash<ui64, ui32>* reindexHashPtr, ui64* begin, ui64* end, NPar::TLocalExecutor* localExecutor) {
+    const size_t sampleCount = end - begin;
+    const int blockCount = GetParallelBlockCount(sampleCount, localExecutor);
+    if (blockCount == 1) {
+        return UpdateReindexHash(reindexHashPtr, begin, end);
+    }
+    auto& reindexHash = *reindexHashPtr;
+    const auto& constReindexHash = reindexHash;
+    NPar::TLocalExecutor::TExecRangeParams blockParams(0, sampleCount);
+    blockParams.SetBlockCount(blockCount);
+    // hash values missing in reindexHash in order of first occurrence in block
+    TVector<TVector<ui64>> blockNewHashes(blockParams.GetBlockCount());
+    localExecutor->ExecRange([&](int blockId) {
+        const size_t blockStart = blockId * blockParams.GetBlockSize();
+        const size_t blockEnd = Min<size_t>(sampleCount, blockStart + blockParams.GetBlockSize());
+        TDenseHash<ui64, ui32> blockHashes;
+        auto& newHashes = blockNewHashes[blockId];
+        for (const ui64* hash = begin + blockStart; hash != begin + blockEnd; ++hash) {
+            if (constReindexHash.FindPtr(*hash) == nullptr && blockHashes.emplace(*hash, 0).second) {
+                newHashes.push_back(*hash);
+            }
+        }
+    }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+    ui32 counter = reindexHash.Size();
+    for (const auto& newHashes : blockNewHashes) {
+        for (const ui64 hash : newHashes) {
+            if (reindexHash.emplace(hash, counter).second) {
+                ++counter;
+            }
+        }
+    }
+    localExecutor->ExecRange([&](int blockId) {
+        const size_t blockStart = blockId * blockParams.GetBlockSize();
+        const size_t blockEnd = Min<size_t>(sampleCount, blockStart + blockParams.GetBlockSize());
+        for (ui64* hash = begin + blockStart; hash != begin + blockEnd; ++hash) {
+            *hash = *constReindexHash.FindPtr(*hash);
+        }
+    }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+    return reindexHash.Size();
+}
+
+size_t ComputeReindexHash(ui64 topSize, TDenseHash<ui64, ui32>* reindexHashPtr, ui64* begin, ui64* end, NPar::TLocalExecutor* localExecutor) {
+    // with topSize limit indices depend on frequencies of all hash values, so only unlimited case is parallel
+    if (topSize > static_cast<ui64>(end - begin)) {
+        Y_ASSERT(reindexHashPtr->Size() == 0);
+        return UpdateReindexHash(reindexHashPtr, begin, end, localExecutor);
+    }
+    return ComputeReindexHash(topSize, reindexHashPtr, begin, end);
+}
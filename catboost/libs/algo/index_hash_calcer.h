@@ -6,59 +6,45 @@
 #include <catboost/libs/helpers/clear_array.h>
 
 #include <library/containers/dense_hash/dense_hash.h>
+#include <library/threading/local_executor/local_executor.h>
 
 /// Calculate document hashes into range [begin,end) for CTR bucket identification.
 /// @param proj - Projection delivering the feature ids to hash
 /// @param allFeatures - Values of features to hash
 /// @param offset - Begin from this offset when accessing `allFeatures`
-/// @param learnPermutation - Use this permutation when accessing `allFeatures`
+/// @param permutation - Indices of documents in `allFeatures` for hashes [begin,end) or nullptr
 /// @param calculateExactCatHashes - Hash original cat features (true) or one-hot-encoded (false)
 /// @param begin, @param end - Result range
-inline void CalcHashes(const TProjection& proj,
-                       const TAllFeatures& allFeatures,
-                       size_t offset,
-                       const TVector<size_t>* learnPermutation,
-                       bool calculateExactCatHashes,
-                       ui64* begin,
-                       ui64* end) {
+inline void CalcPermutedHashes(const TProjection& proj,
+                               const TAllFeatures& allFeatures,
+                               size_t offset,
+                               const size_t* permutation,
+                               bool calculateExactCatHashes,
+                               ui64* begin,
+                               ui64* end) {
     const size_t sampleCount = end - begin;
-    if (sampleCount == 0) {
-        return;
-    }
-    if (learnPermutation != nullptr) {
-        Y_VERIFY(offset == 0);
-        Y_VERIFY(sampleCount == learnPermutation->size());
-    }
-
     ui64* hashArr = begin;
     if (calculateExactCatHashes) {
-        TVector<int> exactValues;
         for (const int featureIdx : proj.CatFeatures) {
             const int* featureValues = offset + allFeatures.CatFeaturesRemapped[featureIdx].data();
             // Calculate hashes for model CTR table
-            exactValues.resize(sampleCount);
             auto& ohv = allFeatures.OneHotValues[featureIdx];
-            for (size_t i = 0; i < sampleCount; ++i) {
-                exactValues[i] = ohv[featureValues[i]];
-            }
-            if (learnPermutation != nullptr) {
-                const auto& perm = *learnPermutation;
+            if (permutation != nullptr) {
                 for (size_t i = 0; i < sampleCount; ++i) {
-                    hashArr[i] = CalcHash(hashArr[i], (ui64)exactValues[perm[i]]);
+                    hashArr[i] = CalcHash(hashArr[i], (ui64)ohv[featureValues[permutation[i]]]);
                 }
             } else {
                 for (size_t i = 0; i < sampleCount; ++i) {
-                    hashArr[i] = CalcHash(hashArr[i], (ui64)exactValues[i]);
+                    hashArr[i] = CalcHash(hashArr[i], (ui64)ohv[featureValues[i]]);
                 }
             }
         }
     } else {
         for (const int featureIdx : proj.CatFeatures) {
             const int* featureValues = offset + allFeatures.CatFeaturesRemapped[featureIdx].data();
-            if (learnPermutation != nullptr) {
-                const auto& perm = *learnPermutation;
+            if (permutation != nullptr) {
                 for (size_t i = 0; i < sampleCount; ++i) {
-                    hashArr[i] = CalcHash(hashArr[i], (ui64)featureValues[perm[i]] + 1);
+                    hashArr[i] = CalcHash(hashArr[i], (ui64)featureValues[permutation[i]] + 1);
                 }
             } else {
                 for (size_t i = 0; i < sampleCount; ++i) {
@@ -69,16 +55,15 @@ inline void CalcHashes(const TProjection& proj,
     }
 
     for (const TBinFeature& feature : proj.BinFeatures) {
-        const ui8* featureValues = offset + allFeatures.FloatHistograms[feature.FloatFeature].data();
-        if (learnPermutation != nullptr) {
-            const auto& perm = *learnPermutation;
+        const TPackedBins& featureValues = allFeatures.FloatHistograms[feature.FloatFeature];
+        if (permutation != nullptr) {
             for (size_t i = 0; i < sampleCount; ++i) {
-                const bool isTrueFeature = IsTrueHistogram(featureValues[perm[i]], feature.SplitIdx);
+                const bool isTrueFeature = IsTrueHistogram(featureValues[offset + permutation[i]], feature.SplitIdx);
                 hashArr[i] = CalcHash(hashArr[i], (ui64)isTrueFeature);
             }
         } else {
             for (size_t i = 0; i < sampleCount; ++i) {
-                const bool isTrueFeature = IsTrueHistogram(featureValues[i], feature.SplitIdx);
+                const bool isTrueFeature = IsTrueHistogram(featureValues[offset + i], feature.SplitIdx);
                 hashArr[i] = CalcHash(hashArr[i], (ui64)isTrueFeature);
             }
         }
@@ -86,10 +71,9 @@ inline void CalcHashes(const TProjection& proj,
 
     for (const TOneHotSplit& feature : proj.OneHotFeatures) {
         const int* featureValues = offset + allFeatures.CatFeaturesRemapped[feature.CatFeatureIdx].data();
-        if (learnPermutation != nullptr) {
-            const auto& perm = *learnPermutation;
+        if (permutation != nullptr) {
             for (size_t i = 0; i < sampleCount; ++i) {
-                const bool isTrueFeature = IsTrueOneHotFeature(featureValues[perm[i]], feature.Value);
+                const bool isTrueFeature = IsTrueOneHotFeature(featureValues[permutation[i]], feature.Value);
                 hashArr[i] = CalcHash(hashArr[i], (ui64)isTrueFeature);
             }
         } else {
@@ -101,6 +85,41 @@ inline void CalcHashes(const TProjection& proj,
     }
 }
 
+/// Calculate document hashes into range [begin,end) for CTR bucket identification.
+/// @param proj - Projection delivering the feature ids to hash
+/// @param allFeatures - Values of features to hash
+/// @param offset - Begin from this offset when accessing `allFeatures`
+/// @param learnPermutation - Use this permutation when accessing `allFeatures`
+/// @param calculateExactCatHashes - Hash original cat features (true) or one-hot-encoded (false)
+/// @param begin, @param end - Result range
+inline void CalcHashes(const TProjection& proj,
+                       const TAllFeatures& allFeatures,
+                       size_t offset,
+                       const TVector<size_t>* learnPermutation,
+                       bool calculateExactCatHashes,
+                       ui64* begin,
+                       ui64* end) {
+    const size_t sampleCount = end - begin;
+    if (sampleCount == 0) {
+        return;
+    }
+    if (learnPermutation != nullptr) {
+        Y_VERIFY(offset == 0);
+        Y_VERIFY(sampleCount == learnPermutation->size());
+    }
+    CalcPermutedHashes(proj, allFeatures, offset, learnPermutation ? learnPermutation->data() : nullptr, calculateExactCatHashes, begin, end);
+}
+
+/// Same as CalcHashes, blocks of documents are hashed in parallel.
+void CalcHashes(const TProjection& proj,
+                const TAllFeatures& allFeatures,
+                size_t offset,
+                const TVector<size_t>* learnPermutation,
+                bool calculateExactCatHashes,
+                ui64* begin,
+                ui64* end,
+                NPar::TLocalExecutor* localExecutor);
+
 /// Compute reindexHash and reindex hash values in range [begin,end).
 /// After reindex, hash values belong to [0, reindexHash.Size()].
 /// If reindexHash would become larger than topSize, keep only topSize most
@@ -112,3 +131,10 @@ size_t ComputeReindexHash(ui64 topSize, TDenseHash<ui64, ui32>* reindexHashPtr,
 /// If a hash value is not present in reindexHash, then update reindexHash for that value.
 /// @return the size of updated reindexHash.
 size_t UpdateReindexHash(TDenseHash<ui64, ui32>* reindexHashPtr, ui64* begin, ui64* end);
+
+/// Same as UpdateReindexHash, new hash values of document blocks are collected in parallel
+/// and get the same indices as in sequential update.
+size_t UpdateReindexHash(TDenseHash<ui64, ui32>* reindexHashPtr, ui64* begin, ui64* end, NPar::TLocalExecutor* localExecutor);
+
+/// Same as ComputeReindexHash, uses parallel UpdateReindexHash if all hash values fit into topSize.
+size_t ComputeReindexHash(ui64 topSize, TDenseHash<ui64, ui32>* reindexHashPtr, ui64* begin, ui64* end, NPar::TLocalExecutor* localExecutor);
@@ -51,6 +51,18 @@ static ui32 CalcMatrixCheckSum(ui32 init, const TVector<TVector<T>>& matrix) {
     return checkSum;
 }
 
+// check sum of unpacked bins, so it doesn't depend on packing
+static ui32 CalcMatrixCheckSum(ui32 init, const TVector<TPackedBins>& matrix) {
+    ui32 checkSum = init;
+    TVector<ui8> row;
+    for (const auto& packedRow : matrix) {
+        row.yresize(packedRow.size());
+        packedRow.Unpack(0, packedRow.size(), row.data());
+        checkSum = Crc32cExtend(checkSum, row.data(), row.size() * sizeof(ui8));
+    }
+    return checkSum;
+}
+
 static ui32 CalcFeaturesCheckSum(const TAllFeatures& allFeatures) {
     ui32 checkSum = 0;
     checkSum = CalcMatrixCheckSum(checkSum, allFeatures.FloatHistograms);
@@ -6,6 +6,7 @@
 
 #include <catboost/libs/model/model.h>
 #include <util/generic/utility.h>
+#include <util/system/align.h>
 #include <util/thread/singleton.h>
 
 struct TCtrCalcer {
@@ -22,37 +23,22 @@ struct TCtrCalcer {
     static inline TArrayRef<TCtrMeanHistory> GetCtrMeanHistoryArr(size_t maxCount) {
         return TArrayRef<TCtrMeanHistory>(FastTlsSingleton<TCtrCalcer>()->Alloc<TCtrMeanHistory>(maxCount), maxCount);
     }
-    static inline TArrayRef<TCtrHistory> GetCtrHistoryArr(size_t maxCount) {
-        return TArrayRef<TCtrHistory>(FastTlsSingleton<TCtrCalcer>()->Alloc<TCtrHistory>(maxCount), maxCount);
-    }
-    static inline int* GetCtrArrTotal(size_t maxCount) {
-        return FastTlsSingleton<TCtrCalcer>()->Alloc<int>(maxCount);
-    }
 
 private:
     TVector<char> Storage;
 };
 
-struct TBucketsView {
-    size_t MaxElem = 0;
-    size_t BorderCount = 0;
-    int* Data = 0;
-    int* BucketData = 0;
-    TBucketsView(size_t maxElem, size_t borderCount)
-        : MaxElem(maxElem)
-        , BorderCount(borderCount) {
-        Data = FastTlsSingleton<TCtrCalcer>()->Alloc<int>(MaxElem * (BorderCount + 1));
-        BucketData = Data + MaxElem;
-    }
-    inline int& GetTotal(size_t i) {
-        Y_ASSERT(i < MaxElem);
-        return *(Data + i);
-    }
-    inline TArrayRef<int> GetBorders(size_t i) {
-        Y_ASSERT(i < MaxElem);
-        return TArrayRef<int>(BucketData + BorderCount * i, BorderCount);
+size_t TOnlineCTR::GetMemoryUsage() const {
+    size_t memoryUsage = 0;
+    for (const auto& ctr : Feature) {
+        for (size_t y = 0; y < ctr.GetYSize(); ++y) {
+            for (size_t x = 0; x < ctr.GetXSize(); ++x) {
+                memoryUsage += ctr[y][x].GetMemoryUsage();
+            }
+        }
     }
-};
+    return memoryUsage;
+}
 
 void CalcNormalization(const TVector<float>& priors, TVector<float>* shift, TVector<float>* norm) {
     shift->yresize(priors.size());
@@ -76,6 +62,9 @@ static void UpdateGoodCount(int curCount, ECtrType ctrType, int* goodCount) {
     }
 }
 
+// smaller blocks of documents are not worth parallel processing
+static constexpr size_t MinParallelCtrBlockSize = 1 << 15;
+
 namespace {
     // Blocked 2-stage calculation director
     class TBlockedCalcer {
@@ -95,6 +84,92 @@ namespace {
     private:
         const int BlockSize;
     };
+
+    // Contiguous blocks of documents [DocBegin, DocEnd) for parallel processing.
+    // Inner block bounds are multiples of DocBlockAlignment, so blocks of packed ctr values don't share bytes.
+    class TDocBlocks {
+    public:
+        static constexpr size_t DocBlockAlignment = 8;
+
+        TDocBlocks(size_t docBegin, size_t docEnd, size_t minBlockSize, NPar::TLocalExecutor* localExecutor)
+            : DocBegin(docBegin)
+            , DocEnd(docEnd)
+            , AlignedDocBegin(AlignDown(docBegin, DocBlockAlignment)) {
+            const size_t docCount = docEnd - docBegin;
+            const size_t threadCount = localExecutor->GetThreadCount() + 1;
+            const size_t blockCount = Max<size_t>(1, Min<size_t>(threadCount, docCount / minBlockSize));
+            BlockSize = AlignUp((docEnd - AlignedDocBegin + blockCount - 1) / blockCount, DocBlockAlignment);
+            BlockCount = docCount > 0 ? (docEnd - AlignedDocBegin + BlockSize - 1) / BlockSize : 0;
+        }
+
+        int GetBlockCount() const {
+            return BlockCount;
+        }
+
+        // calcBlock(blockIdx, blockStart, blockEnd) is called for all blocks in parallel
+        template <typename TCalcBlock>
+        void Exec(NPar::TLocalExecutor* localExecutor, TCalcBlock calcBlock) const {
+            localExecutor->ExecRange([&](int blockIdx) {
+                const size_t alignedBlockStart = AlignedDocBegin + blockIdx * BlockSize;
+                calcBlock(blockIdx, Max(DocBegin, alignedBlockStart), Min(DocEnd, alignedBlockStart + BlockSize));
+            }, 0, BlockCount, NPar::TLocalExecutor::WAIT_COMPLETE);
+        }
+
+    private:
+        size_t DocBegin;
+        size_t DocEnd;
+        size_t AlignedDocBegin;
+        size_t BlockSize;
+        int BlockCount;
+    };
+}
+
+/// Online ctr of learn documents depends on per leaf int counters of preceding documents.
+/// calcDocs(counters, docBegin, docEnd, isLearn) calculates ctrs reading counters and updates them for learn documents,
+/// addLearnDoc(counters, docId) only updates counters.
+/// Learn blocks are processed in parallel: counters of each block start from totals of all preceding blocks,
+/// so results are the same as in sequential pass. Test documents read counters of all learn documents.
+template <typename TAddLearnDoc, typename TCalcDocs>
+static void CalcOnlineCTRByBlocks(size_t learnSampleCount,
+                                  size_t totalSampleCount,
+                                  size_t countersSize,
+                                  TAddLearnDoc addLearnDoc,
+                                  TCalcDocs calcDocs,
+                                  NPar::TLocalExecutor* localExecutor) {
+    // counters of all blocks are summed, so block should contain more documents than counters
+    const TDocBlocks learnBlocks(0, learnSampleCount, Max(MinParallelCtrBlockSize, countersSize), localExecutor);
+    const int learnBlockCount = learnBlocks.GetBlockCount();
+    TVector<TVector<int>> blockCounters(Max(1, learnBlockCount), TVector<int>(countersSize, 0));
+    if (learnBlockCount > 1) {
+        // counters of block are accumulated in place of the next block ones, last block counters are not needed
+        learnBlocks.Exec(localExecutor, [&](int blockIdx, size_t blockStart, size_t blockEnd) {
+            if (blockIdx + 1 < learnBlockCount) {
+                int* counters = blockCounters[blockIdx + 1].data();
+                for (size_t docId = blockStart; docId < blockEnd; ++docId) {
+                    addLearnDoc(counters, docId);
+                }
+            }
+        });
+        const TDocBlocks counterBlocks(0, countersSize, MinParallelCtrBlockSize, localExecutor);
+        counterBlocks.Exec(localExecutor, [&](int, size_t counterStart, size_t counterEnd) {
+            for (int blockIdx = 1; blockIdx < learnBlockCount; ++blockIdx) {
+                const int* prevCounters = blockCounters[blockIdx - 1].data();
+                int* counters = blockCounters[blockIdx].data();
+                for (size_t i = counterStart; i < counterEnd; ++i) {
+                    counters[i] += prevCounters[i];
+                }
+            }
+        });
+    }
+    learnBlocks.Exec(localExecutor, [&](int blockIdx, size_t blockStart, size_t blockEnd) {
+        calcDocs(blockCounters[blockIdx].data(), blockStart, blockEnd, /*isLearn*/ true);
+    });
+    // after learn pass counters of the last block are totals of all learn documents
+    int* learnCounters = blockCounters.back().data();
+    const TDocBlocks testBlocks(learnSampleCount, totalSampleCount, MinParallelCtrBlockSize, localExecutor);
+    testBlocks.Exec(localExecutor, [&](int, size_t blockStart, size_t blockEnd) {
+        calcDocs(learnCounters, blockStart, blockEnd, /*isLearn*/ false);
+    });
 }
 
 static void CalcOnlineCTRClasses(const TVector<size_t>& testOffsets,
@@ -105,58 +180,66 @@ static void CalcOnlineCTRClasses(const TVector<size_t>& testOffsets,
                                  const TVector<float>& priors,
                                  int ctrBorderCount,
                                  ECtrType ctrType,
-                                 TArray2D<TVector<ui8>>* feature) {
+                                 NPar::TLocalExecutor* localExecutor,
+                                 TArray2D<TPackedBins>* feature) {
     TVector<float> shift;
     TVector<float> norm;
     CalcNormalization(priors, &shift, &norm);
 
     const int blockSize = (1000 + targetBorderCount - 1) / targetBorderCount + 100; // ensure blocks have reasonable size
-    TVector<int> totalCountByDoc(blockSize);
-    TVector<TVector<int>> goodCountByBorderByDoc(targetBorderCount, TVector<int>(blockSize));
-    TBucketsView bv(leafCount, targetClassesCount);
+    // counters of leaf: total count followed by count of each target class
+    const size_t leafCountersSize = targetClassesCount + 1;
 
-    auto calcGoodCounts = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-            const auto elemId = enumeratedCatFeatures[docOffset + docId];
+    auto addLearnDoc = [&](int* counters, size_t docId) {
+        int* leafCounters = counters + enumeratedCatFeatures[docId] * leafCountersSize;
+        ++leafCounters[1 + permutedTargetClass[docId]];
+        ++leafCounters[0];
+    };
 
-            int goodCount = totalCountByDoc[docId - blockStart] = bv.GetTotal(elemId);
-            auto bordersData = bv.GetBorders(elemId);
-            for (int border = 0; border < targetBorderCount; ++border) {
-                UpdateGoodCount(bordersData[border], ctrType, &goodCount);
-                goodCountByBorderByDoc[border][docId - blockStart] = goodCount;
-            }
+    auto calcDocs = [&](int* counters, size_t docBegin, size_t docEnd, bool isLearn) {
+        TVector<int> totalCountByDoc(blockSize);
+        TVector<ui8> ctrValues(blockSize);
+        TVector<TVector<int>> goodCountByBorderByDoc(targetBorderCount, TVector<int>(blockSize));
 
-            if (docOffset == 0) {
-                ++bordersData[permutedTargetClass[docId]];
-                ++bv.GetTotal(elemId);
+        auto calcGoodCounts = [&](int blockStart, int nextBlockStart, int docOffset) {
+            for (int docId = blockStart; docId < nextBlockStart; ++docId) {
+                int* leafCounters = counters + enumeratedCatFeatures[docOffset + docId] * leafCountersSize;
+
+                int goodCount = totalCountByDoc[docId - blockStart] = leafCounters[0];
+                const int* bordersData = leafCounters + 1;
+                for (int border = 0; border < targetBorderCount; ++border) {
+                    UpdateGoodCount(bordersData[border], ctrType, &goodCount);
+                    goodCountByBorderByDoc[border][docId - blockStart] = goodCount;
+                }
+
+                if (isLearn) {
+                    ++leafCounters[1 + permutedTargetClass[docOffset + docId]];
+                    ++leafCounters[0];
+                }
             }
-        }
-    };
+        };
 
-    auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int border = 0; border < targetBorderCount; ++border) {
-            for (int prior = 0; prior < priors.ysize(); ++prior) {
-                const float priorX = priors[prior];
-                const float shiftX = shift[prior];
-                const float normX = norm[prior];
-                const int* goodCountData = goodCountByBorderByDoc[border].data();
-                ui8* featureData = docOffset + (*feature)[border][prior].data();
-                for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-                    featureData[docId] = CalcCTR(goodCountData[docId - blockStart], totalCountByDoc[docId - blockStart],
-                                                 priorX, shiftX, normX, ctrBorderCount);
+        auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
+            for (int border = 0; border < targetBorderCount; ++border) {
+                for (int prior = 0; prior < priors.ysize(); ++prior) {
+                    const float priorX = priors[prior];
+                    const float shiftX = shift[prior];
+                    const float normX = norm[prior];
+                    const int* goodCountData = goodCountByBorderByDoc[border].data();
+                    for (int docId = blockStart; docId < nextBlockStart; ++docId) {
+                        ctrValues[docId - blockStart] = CalcCTR(goodCountData[docId - blockStart], totalCountByDoc[docId - blockStart],
+                                                                priorX, shiftX, normX, ctrBorderCount);
+                    }
+                    (*feature)[border][prior].PackAt(docOffset + blockStart, MakeArrayRef(ctrValues.data(), nextBlockStart - blockStart));
                 }
             }
-        }
+        };
+
+        TBlockedCalcer calcer(blockSize);
+        calcer.Calc(calcGoodCounts, calcCTRs, docBegin, docEnd - docBegin);
     };
 
-    TBlockedCalcer calcer(blockSize);
-    const size_t learnSampleCount = testOffsets[0];
-    calcer.Calc(calcGoodCounts, calcCTRs, 0, learnSampleCount);
-    for (size_t docOffset = learnSampleCount, testIdx = 0; testIdx < testOffsets.size() - 1; ++testIdx) {
-        const size_t testSampleCount = testOffsets[testIdx + 1] - testOffsets[testIdx];
-        calcer.Calc(calcGoodCounts, calcCTRs, docOffset, testSampleCount);
-        docOffset += testSampleCount;
-    }
+    CalcOnlineCTRByBlocks(testOffsets[0], testOffsets.back(), leafCount * leafCountersSize, addLearnDoc, calcDocs, localExecutor);
 }
 
 static void CalcOnlineCTRSimple(const TVector<size_t>& testOffsets,
@@ -165,48 +248,52 @@ static void CalcOnlineCTRSimple(const TVector<size_t>& testOffsets,
                                 const TVector<int>& permutedTargetClass,
                                 const TVector<float>& priors,
                                 int ctrBorderCount,
-                                TArray2D<TVector<ui8>>* feature) {
+                                NPar::TLocalExecutor* localExecutor,
+                                TArray2D<TPackedBins>* feature) {
     TVector<float> shift;
     TVector<float> norm;
     CalcNormalization(priors, &shift, &norm);
 
     const int blockSize = 1000;
-    auto ctrArrSimple = TCtrCalcer::GetCtrHistoryArr(leafCount + blockSize);
-    auto totalCount = reinterpret_cast<int*>(ctrArrSimple.data() + leafCount);
-    auto goodCount = totalCount + blockSize;
-
-    auto calcGoodCount = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-            TCtrHistory& elem = ctrArrSimple[enumeratedCatFeatures[docOffset + docId]];
-            goodCount[docId - blockStart] = elem.N[1];
-            totalCount[docId - blockStart] = elem.N[0] + elem.N[1];
-            if (docOffset == 0) {
-                ++elem.N[permutedTargetClass[docId]];
-            }
-        }
+
+    auto addLearnDoc = [&](int* counters, size_t docId) {
+        ++counters[enumeratedCatFeatures[docId] * SIMPLE_CLASSES_COUNT + permutedTargetClass[docId]];
     };
 
-    auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int prior = 0; prior < priors.ysize(); ++prior) {
-            const float priorX = priors[prior];
-            const float shiftX = shift[prior];
-            const float normX = norm[prior];
-            ui8* featureData = docOffset + (*feature)[0][prior].data();
+    auto calcDocs = [&](int* counters, size_t docBegin, size_t docEnd, bool isLearn) {
+        TVector<int> totalCount(blockSize);
+        TVector<int> goodCount(blockSize);
+        TVector<ui8> ctrValues(blockSize);
+
+        auto calcGoodCount = [&](int blockStart, int nextBlockStart, int docOffset) {
             for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-                featureData[docId] = CalcCTR(goodCount[docId - blockStart], totalCount[docId - blockStart],
-                                             priorX, shiftX, normX, ctrBorderCount);
+                int* elem = counters + enumeratedCatFeatures[docOffset + docId] * SIMPLE_CLASSES_COUNT;
+                goodCount[docId - blockStart] = elem[1];
+                totalCount[docId - blockStart] = elem[0] + elem[1];
+                if (isLearn) {
+                    ++elem[permutedTargetClass[docOffset + docId]];
+                }
             }
-        }
+        };
+
+        auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
+            for (int prior = 0; prior < priors.ysize(); ++prior) {
+                const float priorX = priors[prior];
+                const float shiftX = shift[prior];
+                const float normX = norm[prior];
+                for (int docId = blockStart; docId < nextBlockStart; ++docId) {
+                    ctrValues[docId - blockStart] = CalcCTR(goodCount[docId - blockStart], totalCount[docId - blockStart],
+                                                            priorX, shiftX, normX, ctrBorderCount);
+                }
+                (*feature)[0][prior].PackAt(docOffset + blockStart, MakeArrayRef(ctrValues.data(), nextBlockStart - blockStart));
+            }
+        };
+
+        TBlockedCalcer calcer(blockSize);
+        calcer.Calc(calcGoodCount, calcCTRs, docBegin, docEnd - docBegin);
     };
 
-    TBlockedCalcer calcer(blockSize);
-    const size_t learnSampleCount = testOffsets[0];
-    calcer.Calc(calcGoodCount, calcCTRs, 0, learnSampleCount);
-    for (size_t docOffset = learnSampleCount, testIdx = 0; testIdx < testOffsets.size() - 1; ++testIdx) {
-        const size_t testSampleCount = testOffsets[testIdx + 1] - testOffsets[testIdx];
-        calcer.Calc(calcGoodCount, calcCTRs, docOffset, testSampleCount);
-        docOffset += testSampleCount;
-    }
+    CalcOnlineCTRByBlocks(testOffsets[0], testOffsets.back(), leafCount * SIMPLE_CLASSES_COUNT, addLearnDoc, calcDocs, localExecutor);
 }
 
 static void CalcOnlineCTRMean(const TVector<size_t>& testOffsets,
@@ -216,48 +303,55 @@ static void CalcOnlineCTRMean(const TVector<size_t>& testOffsets,
                               int targetBorderCount,
                               const TVector<float>& priors,
                               int ctrBorderCount,
-                              TArray2D<TVector<ui8>>* feature) {
+                              NPar::TLocalExecutor* localExecutor,
+                              TArray2D<TPackedBins>* feature) {
     TVector<float> shift;
     TVector<float> norm;
     CalcNormalization(priors, &shift, &norm);
 
     const int blockSize = 1000;
-    TVector<float> sum(blockSize);
-    TVector<int> count(blockSize);
     auto ctrArrMean = TCtrCalcer::GetCtrMeanHistoryArr(leafCount);
 
-    auto calcCount = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-            TCtrMeanHistory& elem = ctrArrMean[enumeratedCatFeatures[docOffset + docId]];
-            sum[docId - blockStart] = elem.Sum;
-            count[docId - blockStart] = elem.Count;
-            if (docOffset == 0) {
-                elem.Add(static_cast<float>(permutedTargetClass[docId]) / targetBorderCount);
-            }
-        }
-    };
+    auto calcDocs = [&](size_t docBegin, size_t docEnd, bool isLearn) {
+        TVector<float> sum(blockSize);
+        TVector<int> count(blockSize);
+        TVector<ui8> ctrValues(blockSize);
 
-    auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int prior = 0; prior < priors.ysize(); ++prior) {
-            const float priorX = priors[prior];
-            const float shiftX = shift[prior];
-            const float normX = norm[prior];
-            ui8* featureData = docOffset + (*feature)[0][prior].data();
+        auto calcCount = [&](int blockStart, int nextBlockStart, int docOffset) {
             for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-                featureData[docId] = CalcCTR(sum[docId - blockStart], count[docId - blockStart],
-                                             priorX, shiftX, normX, ctrBorderCount);
+                TCtrMeanHistory& elem = ctrArrMean[enumeratedCatFeatures[docOffset + docId]];
+                sum[docId - blockStart] = elem.Sum;
+                count[docId - blockStart] = elem.Count;
+                if (isLearn) {
+                    elem.Add(static_cast<float>(permutedTargetClass[docOffset + docId]) / targetBorderCount);
+                }
             }
-        }
+        };
+
+        auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
+            for (int prior = 0; prior < priors.ysize(); ++prior) {
+                const float priorX = priors[prior];
+                const float shiftX = shift[prior];
+                const float normX = norm[prior];
+                for (int docId = blockStart; docId < nextBlockStart; ++docId) {
+                    ctrValues[docId - blockStart] = CalcCTR(sum[docId - blockStart], count[docId - blockStart],
+                                                            priorX, shiftX, normX, ctrBorderCount);
+                }
+                (*feature)[0][prior].PackAt(docOffset + blockStart, MakeArrayRef(ctrValues.data(), nextBlockStart - blockStart));
+            }
+        };
+
+        TBlockedCalcer calcer(blockSize);
+        calcer.Calc(calcCount, calcCTRs, docBegin, docEnd - docBegin);
     };
 
-    TBlockedCalcer calcer(blockSize);
+    // float sums are accumulated in document order to keep results exact, so only test documents are parallel
     const size_t learnSampleCount = testOffsets[0];
-    calcer.Calc(calcCount, calcCTRs, 0, learnSampleCount);
-    for (size_t docOffset = learnSampleCount, testIdx = 0; testIdx < testOffsets.size() - 1; ++testIdx) {
-        const size_t testSampleCount = testOffsets[testIdx + 1] - testOffsets[testIdx];
-        calcer.Calc(calcCount, calcCTRs, docOffset, testSampleCount);
-        docOffset += testSampleCount;
-    }
+    calcDocs(0, learnSampleCount, /*isLearn*/ true);
+    const TDocBlocks testBlocks(learnSampleCount, testOffsets.back(), MinParallelCtrBlockSize, localExecutor);
+    testBlocks.Exec(localExecutor, [&](int, size_t blockStart, size_t blockEnd) {
+        calcDocs(blockStart, blockEnd, /*isLearn*/ false);
+    });
 }
 
 static void CalcOnlineCTRCounter(const TVector<size_t>& testOffsets,
@@ -266,40 +360,44 @@ static void CalcOnlineCTRCounter(const TVector<size_t>& testOffsets,
                                  int denominator,
                                  const TVector<float>& priors,
                                  int ctrBorderCount,
-                                 TArray2D<TVector<ui8>>* feature) {
+                                 NPar::TLocalExecutor* localExecutor,
+                                 TArray2D<TPackedBins>* feature) {
     TVector<float> shift;
     TVector<float> norm;
     CalcNormalization(priors, &shift, &norm);
 
     const int blockSize = 1000;
-    auto ctrTotal = TCtrCalcer::GetCtrArrTotal(blockSize);
-    auto calcTotal = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-            const auto elemId = enumeratedCatFeatures[docOffset + docId];
-            ctrTotal[docId - blockStart] = counterCTRTotal[elemId];
-        }
-    };
-
-    auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int prior = 0; prior < priors.ysize(); ++prior) {
-            const float priorX = priors[prior];
-            const float shiftX = shift[prior];
-            const float normX = norm[prior];
-            ui8* featureData = docOffset + (*feature)[0][prior].data();
+    auto calcDocs = [&](size_t docBegin, size_t docEnd) {
+        TVector<int> ctrTotal(blockSize);
+        TVector<ui8> ctrValues(blockSize);
+        auto calcTotal = [&](int blockStart, int nextBlockStart, int docOffset) {
             for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-                featureData[docId] = CalcCTR(ctrTotal[docId - blockStart], denominator, priorX, shiftX, normX, ctrBorderCount);
+                const auto elemId = enumeratedCatFeatures[docOffset + docId];
+                ctrTotal[docId - blockStart] = counterCTRTotal[elemId];
             }
-        }
+        };
+
+        auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
+            for (int prior = 0; prior < priors.ysize(); ++prior) {
+                const float priorX = priors[prior];
+                const float shiftX = shift[prior];
+                const float normX = norm[prior];
+                for (int docId = blockStart; docId < nextBlockStart; ++docId) {
+                    ctrValues[docId - blockStart] = CalcCTR(ctrTotal[docId - blockStart], denominator, priorX, shiftX, normX, ctrBorderCount);
+                }
+                (*feature)[0][prior].PackAt(docOffset + blockStart, MakeArrayRef(ctrValues.data(), nextBlockStart - blockStart));
+            }
+        };
+
+        TBlockedCalcer calcer(blockSize);
+        calcer.Calc(calcTotal, calcCTRs, docBegin, docEnd - docBegin);
     };
 
-    TBlockedCalcer calcer(blockSize);
-    const size_t learnSampleCount = testOffsets[0];
-    calcer.Calc(calcTotal, calcCTRs, 0, learnSampleCount);
-    for (size_t docOffset = learnSampleCount, testIdx = 0; testIdx < testOffsets.size() - 1; ++testIdx) {
-        const size_t testSampleCount = testOffsets[testIdx + 1] - testOffsets[testIdx];
-        calcer.Calc(calcTotal, calcCTRs, docOffset, testSampleCount);
-        docOffset += testSampleCount;
-    }
+    // counters are computed beforehand, so learn and test documents are independent
+    const TDocBlocks blocks(0, testOffsets.back(), MinParallelCtrBlockSize, localExecutor);
+    blocks.Exec(localExecutor, [&](int, size_t blockStart, size_t blockEnd) {
+        calcDocs(blockStart, blockEnd);
+    });
 }
 
 static inline void CountOnlineCTRTotal(const TVector<ui64>& hashArr, int sampleCount, TVector<int>* counterCTRTotal) {
@@ -313,8 +411,9 @@ void ComputeOnlineCTRs(const TDataset& learnData,
                        const TDatasetPtrs& testDataPtrs,
                        const TFold& fold,
                        const TProjection& proj,
-                       const TLearnContext* ctx,
+                       TLearnContext* ctx,
                        TOnlineCTR* dst) {
+    NPar::TLocalExecutor* localExecutor = &ctx->LocalExecutor;
     const TCtrHelper& ctrHelper = ctx->CtrsHelper;
     const auto& ctrInfo = ctrHelper.GetCtrInfo(proj);
     dst->Feature.resize(ctrInfo.size());
@@ -334,9 +433,12 @@ void ComputeOnlineCTRs(const TDataset& learnData,
         if (learnSampleCount > 0) {
             const int* featureValues = learnData.AllFeatures.CatFeaturesRemapped[proj.CatFeatures[0]].data();
             const auto* permutation = fold.LearnPermutation.data();
-            for (size_t i = 0; i < learnSampleCount; ++i) {
-                hashArr[i] = ((ui64)featureValues[permutation[i]]) + 1;
-            }
+            const TDocBlocks learnBlocks(0, learnSampleCount, MinParallelCtrBlockSize, localExecutor);
+            learnBlocks.Exec(localExecutor, [&](int, size_t blockStart, size_t blockEnd) {
+                for (size_t i = blockStart; i < blockEnd; ++i) {
+                    hashArr[i] = ((ui64)featureValues[permutation[i]]) + 1;
+                }
+            });
         }
         for (size_t docOffset = learnSampleCount, testIdx = 0; docOffset < totalSampleCount && testIdx < testDataPtrs.size(); ++testIdx) {
             const size_t testSampleCount = testDataPtrs[testIdx]->GetSampleCount();
@@ -349,10 +451,10 @@ void ComputeOnlineCTRs(const TDataset& learnData,
         rehashHashTlsVal.Get().MakeEmpty(learnData.AllFeatures.OneHotValues[proj.CatFeatures[0]].size());
     } else {
         Clear(&hashArr, totalSampleCount);
-        CalcHashes(proj, learnData.AllFeatures, 0, &fold.LearnPermutation, false, hashArr.begin(), hashArr.begin() + learnSampleCount);
+        CalcHashes(proj, learnData.AllFeatures, 0, &fold.LearnPermutation, false, hashArr.begin(), hashArr.begin() + learnSampleCount, localExecutor);
         for (size_t docOffset = learnSampleCount, testIdx = 0; docOffset < totalSampleCount && testIdx < testDataPtrs.size(); ++testIdx) {
             const size_t testSampleCount = testDataPtrs[testIdx]->GetSampleCount();
-            CalcHashes(proj, testDataPtrs[testIdx]->AllFeatures, 0, nullptr, false, hashArr.begin() + docOffset, hashArr.begin() + docOffset + testSampleCount);
+            CalcHashes(proj, testDataPtrs[testIdx]->AllFeatures, 0, nullptr, false, hashArr.begin() + docOffset, hashArr.begin() + docOffset + testSampleCount, localExecutor);
             docOffset += testSampleCount;
         }
         size_t approxBucketsCount = 1;
@@ -368,10 +470,10 @@ void ComputeOnlineCTRs(const TDataset& learnData,
     if (proj.IsSingleCatFeature() && ctx->Params.CatFeatureParams->StoreAllSimpleCtrs) {
         topSize = Max<ui64>();
     }
-    auto leafCount = ComputeReindexHash(topSize, rehashHashTlsVal.GetPtr(), hashArr.begin(), hashArr.begin() + learnSampleCount);
+    auto leafCount = ComputeReindexHash(topSize, rehashHashTlsVal.GetPtr(), hashArr.begin(), hashArr.begin() + learnSampleCount, localExecutor);
     for (size_t docOffset = learnSampleCount, testIdx = 0; docOffset < totalSampleCount && testIdx < testDataPtrs.size(); ++testIdx) {
         const size_t testSampleCount = testDataPtrs[testIdx]->GetSampleCount();
-        leafCount = UpdateReindexHash(rehashHashTlsVal.GetPtr(), hashArr.begin() + docOffset, hashArr.begin() + docOffset + testSampleCount);
+        leafCount = UpdateReindexHash(rehashHashTlsVal.GetPtr(), hashArr.begin() + docOffset, hashArr.begin() + docOffset + testSampleCount, localExecutor);
         docOffset += testSampleCount;
     }
     dst->FeatureValueCount = leafCount;
@@ -393,11 +495,13 @@ void ComputeOnlineCTRs(const TDataset& learnData,
         const ui32 targetBorderCount = GetTargetBorderCount(ctrInfo[ctrIdx], targetClassesCount);
         const ui32 ctrBorderCount = ctrInfo[ctrIdx].BorderCount;
         const auto& priors = ctrInfo[ctrIdx].Priors;
-        dst->Feature[ctrIdx].SetSizes(priors.size(), targetBorderCount);
-
+        // ctr values are calculated by blocks of documents and packed by minimal bit count fitting [0, ctrBorderCount]
+        const ui32 bitsPerValue = TPackedBins::GetBitsPerValue(ctrBorderCount);
+        TArray2D<TPackedBins>& ctrValues = dst->Feature[ctrIdx];
+        ctrValues.SetSizes(priors.size(), targetBorderCount);
         for (ui32 border = 0; border < targetBorderCount; ++border) {
             for (int prior = 0; prior < priors.ysize(); ++prior) {
-                Clear(&dst->Feature[ctrIdx][border][prior], totalSampleCount);
+                ctrValues[border][prior] = TPackedBins(totalSampleCount, bitsPerValue);
             }
         }
 
@@ -409,7 +513,8 @@ void ComputeOnlineCTRs(const TDataset& learnData,
                 fold.LearnTargetClass[classifierId],
                 priors,
                 ctrBorderCount,
-                &dst->Feature[ctrIdx]);
+                localExecutor,
+                &ctrValues);
 
         } else if (ctrType == ECtrType::BinarizedTargetMeanValue) {
             CalcOnlineCTRMean(
@@ -420,7 +525,8 @@ void ComputeOnlineCTRs(const TDataset& learnData,
                 targetClassesCount - 1,
                 priors,
                 ctrBorderCount,
-                &dst->Feature[ctrIdx]);
+                localExecutor,
+                &ctrValues);
 
         } else if (ctrType == ECtrType::Buckets ||
                    (ctrType == ECtrType::Borders && targetClassesCount > SIMPLE_CLASSES_COUNT)) {
@@ -434,7 +540,8 @@ void ComputeOnlineCTRs(const TDataset& learnData,
                 priors,
                 ctrBorderCount,
                 ctrType,
-                &dst->Feature[ctrIdx]);
+                localExecutor,
+                &ctrValues);
         } else {
             Y_ASSERT(ctrType == ECtrType::Counter);
             CalcOnlineCTRCounter(
@@ -444,7 +551,8 @@ void ComputeOnlineCTRs(const TDataset& learnData,
                 counterCTRDenominator,
                 priors,
                 ctrBorderCount,
-                &dst->Feature[ctrIdx]);
+                localExecutor,
+                &ctrValues);
         }
     }
 }
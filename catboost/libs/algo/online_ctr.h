@@ -5,6 +5,8 @@
 #include "target_classifier.h"
 #include "dataset.h"
 
+#include <catboost/libs/helpers/packed_bins.h>
+
 
 struct TFold;
 
@@ -12,8 +14,28 @@ const int SIMPLE_CLASSES_COUNT = 2;
 
 
 struct TOnlineCTR {
-    TVector<TArray2D<TVector<ui8>>> Feature; // Feature[ctrIdx][classIdx][priorIdx][docIdx]
+    TVector<TArray2D<TPackedBins>> Feature; // Feature[ctrIdx][classIdx][priorIdx][docIdx]
     size_t FeatureValueCount = 0;
+    // online ctr cache bookkeeping, see TrimOnlineCTRcache
+    ui64 LastUseIteration = 0;
+    ui64 UseCount = 0;
+
+    size_t GetMemoryUsage() const;
+};
+
+struct TOnlineCtrCacheStats {
+    ui64 Hits = 0;
+    ui64 Misses = 0;
+    ui64 EvictedCtrs = 0;
+    ui64 EvictedBytes = 0;
+
+    void AddLookup(bool isHit) {
+        ++(isHit ? Hits : Misses);
+    }
+
+    double GetHitRate() const {
+        return Hits + Misses > 0 ? static_cast<double>(Hits) / (Hits + Misses) : 0.0;
+    }
 };
 
 using TOnlineCTRHash = THashMap<TProjection, TOnlineCTR>;
@@ -32,7 +54,7 @@ void ComputeOnlineCTRs(const TDataset& learnData,
                        const TDatasetPtrs& testDataPtrs,
                        const TFold& fold,
                        const TProjection& proj,
-                       const TLearnContext* ctx,
+                       TLearnContext* ctx,
                        TOnlineCTR* dst);
 
 class TCtrValueTable;
@@ -21,6 +21,84 @@ int GetSplitCount(const TVector<int>& splitsCount,
     }
 }
 
+// Blocks should be large enough for the partial stats overhead to be negligible
+static const int MinDocBlockSize = 1 << 14;
+
+static int GetDocBlockSize(int statsCount) {
+    return Max(MinDocBlockSize, statsCount);
+}
+
+template<typename TFunc>
+static void MeasureBusyTime(TBusyTimeCounter* busyTime, TFunc&& func) {
+    if (busyTime != nullptr) {
+        busyTime->Measure(func);
+    } else {
+        func();
+    }
+}
+
+// Same as CalcStatsKernel, but documents are split into blocks of docBlockSize,
+// blocks are processed by waves of up to ThreadCount blocks in parallel
+template<typename TFullIndexType, typename TIsCaching>
+static void CalcStatsOnDocBlocks(const TIsCaching& isCaching,
+        const TVector<TFullIndexType>& singleIdx,
+        const TCalcScoreFold& fold,
+        bool isPlainMode,
+        const TStatsIndexer& indexer,
+        int depth,
+        const TCalcScoreFold::TBodyTail& bt,
+        int dim,
+        int docBlockSize,
+        const TDocBlocksParallelism& docBlocksParallelism,
+        TBucketStats* stats) {
+    const int blockStatsCount = indexer.CalcSize(depth);
+    const auto statsRange = GetCalculatedStatsRange(isCaching, indexer, depth);
+    const int docCount = bt.TailFinish;
+    const int docBlockCount = (docCount + docBlockSize - 1) / docBlockSize;
+    const int waveSize = docBlocksParallelism.LocalExecutor != nullptr
+        ? Max(1, Min(docBlocksParallelism.ThreadCount, docBlockCount))
+        : 1;
+
+    // the first block sums up directly into stats
+    TVector<TBucketStats> waveStats;
+    waveStats.yresize(waveSize * blockStatsCount);
+    for (int waveStart = 0; waveStart < docBlockCount; waveStart += waveSize) {
+        const int waveEnd = Min(docBlockCount, waveStart + waveSize);
+        const auto getBlockStats = [&](int blockIdx) -> TBucketStats* {
+            return blockIdx == 0 ? stats : waveStats.data() + (blockIdx - waveStart) * blockStatsCount;
+        };
+        const auto calcBlockStats = [&](int blockIdx) {
+            MeasureBusyTime(docBlocksParallelism.BusyTime, [&]() {
+                TBucketStats* blockStats = getBlockStats(blockIdx);
+                Fill(blockStats + statsRange.first, blockStats + statsRange.second, TBucketStats{0, 0, 0, 0});
+                const int docBegin = blockIdx * docBlockSize;
+                AddDocRangeStats(singleIdx, fold, isPlainMode, bt, dim, docBegin, Min(docCount, docBegin + docBlockSize), blockStats);
+            });
+        };
+        const auto calcWaveStats = [&]() {
+            if (waveEnd - waveStart == 1) {
+                calcBlockStats(waveStart);
+            } else {
+                docBlocksParallelism.LocalExecutor->ExecRange(calcBlockStats, waveStart, waveEnd, NPar::TLocalExecutor::WAIT_COMPLETE);
+            }
+        };
+        if (docBlocksParallelism.BusyTime != nullptr) {
+            docBlocksParallelism.BusyTime->Exclude(calcWaveStats);
+        } else {
+            calcWaveStats();
+        }
+        for (int blockIdx = Max(1, waveStart); blockIdx < waveEnd; ++blockIdx) {
+            const TBucketStats* blockStats = getBlockStats(blockIdx);
+            for (int statIdx = statsRange.first; statIdx < statsRange.second; ++statIdx) {
+                stats[statIdx].Add(blockStats[statIdx]);
+            }
+        }
+    }
+    if (isCaching) {
+        FixUpStats(depth, indexer, fold.SmallestSplitSideValue, stats);
+    }
+}
+
 template<typename TFullIndexType, typename TIsCaching>
 static TVector<TScoreBin> CalcScoreImpl(const TIsCaching& isCaching,
         const TVector<TFullIndexType>& singleIdx,
@@ -34,10 +112,12 @@ static TVector<TScoreBin> CalcScoreImpl(const TIsCaching& isCaching,
         const TStatsIndexer& indexer,
         int depth,
         int splitStatsCount,
+        const TDocBlocksParallelism& docBlocksParallelism,
         TBucketStats* splitStats) {
     Y_ASSERT(!isCaching || depth > 0);
     const int approxDimension = fold.GetApproxDimension();
     const int leafCount = 1 << depth;
+    const int docBlockSize = GetDocBlockSize(indexer.CalcSize(depth));
     TVector<TScoreBin> scoreBins(indexer.BucketCount);
     for (int bodyTailIdx = 0; bodyTailIdx < fold.GetBodyTailCount(); ++bodyTailIdx) {
         const auto& bt = fold.BodyTailArr[bodyTailIdx];
@@ -59,7 +139,11 @@ static TVector<TScoreBin> CalcScoreImpl(const TIsCaching& isCaching,
                 );
             } else {
                 TBucketStats* stats = splitStats + (bodyTailIdx * approxDimension + dim) * splitStatsCount;
-                CalcStatsKernel(isCaching, singleIdx, fold, isPlainMode, indexer, depth, bt, dim, stats);
+                if (bt.TailFinish > docBlockSize) {
+                    CalcStatsOnDocBlocks(isCaching, singleIdx, fold, isPlainMode, indexer, depth, bt, dim, docBlockSize, docBlocksParallelism, stats);
+                } else {
+                    CalcStatsKernel(isCaching, singleIdx, fold, isPlainMode, indexer, depth, bt, dim, stats);
+                }
                 if (isPlainMode) {
                     UpdateScoreBin(stats, leafCount, indexer, splitType, l2Regularizer, /*isPlainMode=*/std::true_type(), sumAllWeights, docCount, &scoreBins);
                 } else {
@@ -80,7 +164,8 @@ TVector<TScoreBin> CalcScore(const TAllFeatures& af,
                           const NCatboostOptions::TCatBoostOptions& fitParams,
                           const TSplitCandidate& split,
                           int depth,
-                          TBucketStatsCache* statsFromPrevTree) {
+                          TBucketStatsCache* statsFromPrevTree,
+                          const TDocBlocksParallelism& docBlocksParallelism) {
     const int bucketCount = GetSplitCount(splitsCount, af.OneHotValues, split) + 1;
     const TStatsIndexer indexer(bucketCount);
     const int bucketIndexBits = GetValueBitCount(bucketCount) + depth + 1;
@@ -93,22 +178,21 @@ TVector<TScoreBin> CalcScore(const TAllFeatures& af,
         if (bucketIndexBits <= 8) {
             TVector<ui8> singleIdx;
             BuildSingleIndex(fold, af, allCtrs, split, indexer, &singleIdx);
-            return CalcScoreImpl(isCaching, singleIdx, fold, initialFold, isPlainMode, isPairwiseScoring, l2Regularizer, pairwiseBucketWeightPriorReg, split.Type, indexer, depth, splitStatsCount, GetDataPtr(*splitStats));
+            return CalcScoreImpl(isCaching, singleIdx, fold, initialFold, isPlainMode, isPairwiseScoring, l2Regularizer, pairwiseBucketWeightPriorReg, split.Type, indexer, depth, splitStatsCount, docBlocksParallelism, GetDataPtr(*splitStats));
         } else if (bucketIndexBits <= 16) {
             TVector<ui16> singleIdx;
             BuildSingleIndex(fold, af, allCtrs, split, indexer, &singleIdx);
-            return CalcScoreImpl(isCaching, singleIdx, fold, initialFold, isPlainMode, isPairwiseScoring, l2Regularizer, pairwiseBucketWeightPriorReg, split.Type, indexer, depth, splitStatsCount, GetDataPtr(*splitStats));
+            return CalcScoreImpl(isCaching, singleIdx, fold, initialFold, isPlainMode, isPairwiseScoring, l2Regularizer, pairwiseBucketWeightPriorReg, split.Type, indexer, depth, splitStatsCount, docBlocksParallelism, GetDataPtr(*splitStats));
         } else if (bucketIndexBits <= 32) {
             TVector<ui32> singleIdx;
             BuildSingleIndex(fold, af, allCtrs, split, indexer, &singleIdx);
-            return CalcScoreImpl(isCaching, singleIdx, fold, initialFold, isPlainMode, isPairwiseScoring, l2Regularizer, pairwiseBucketWeightPriorReg, split.Type, indexer, depth, splitStatsCount, GetDataPtr(*splitStats));
+            return CalcScoreImpl(isCaching, singleIdx, fold, initialFold, isPlainMode, isPairwiseScoring, l2Regularizer, pairwiseBucketWeightPriorReg, split.Type, indexer, depth, splitStatsCount, docBlocksParallelism, GetDataPtr(*splitStats));
         }
         CB_ENSURE(false, "too deep or too much splitsCount for score calculation");
     };
     const auto& treeOptions = fitParams.ObliviousTreeOptions.Get();
 
-    // Pairwise scoring doesn't use statistics from previous tree level
-    if (!IsSamplingPerTree(treeOptions) || isPairwiseScoring) {
+    if (!AreStatsFromPrevTreeLevelReusable(treeOptions, isPairwiseScoring)) {
         TVector<TBucketStats> scratchSplitStats;
         const int splitStatsCount = indexer.CalcSize(depth);
         const int statsCount = splitStatsCount;
@@ -11,6 +11,8 @@
 #include <library/threading/local_executor/local_executor.h>
 
 #include <util/generic/vector.h>
+#include <util/system/atomic.h>
+#include <util/system/hp_timer.h>
 
 // TODO(annaveronika): Currently this file has a bunch of structures and helper functions that are used for score calculation
 // in local and distributed modes. This file needs to be refactored.
@@ -49,6 +51,46 @@ inline TVector<double> GetScores(const TVector<TScoreBin>& scoreBin) {
     return scores;
 }
 
+// Sum of times threads spent in measured work, used to calculate thread utilization.
+class TBusyTimeCounter {
+public:
+    template<typename TFunc>
+    void Measure(TFunc&& func) {
+        THPTimer timer;
+        func();
+        Add(timer.Passed());
+    }
+
+    // For waiting on parallel work inside a measured one, the parallel parts are measured on their own
+    template<typename TFunc>
+    void Exclude(TFunc&& func) {
+        THPTimer timer;
+        func();
+        Add(-timer.Passed());
+    }
+
+    double GetBusyTime() const {
+        return AtomicGet(BusyMicroseconds) * 1e-6;
+    }
+
+private:
+    void Add(double time) {
+        AtomicAdd(BusyMicroseconds, static_cast<TAtomicBase>(time * 1e6));
+    }
+
+private:
+    TAtomic BusyMicroseconds = 0;
+};
+
+// Bucket stats of a large split candidate are accumulated on document blocks of size depending on stats count only.
+// Up to ThreadCount blocks are processed in parallel and their stats are summed up in blocks order,
+// so the result doesn't depend on ThreadCount.
+struct TDocBlocksParallelism {
+    int ThreadCount = 1;
+    NPar::TLocalExecutor* LocalExecutor = nullptr;
+    TBusyTimeCounter* BusyTime = nullptr; // optional
+};
+
 // Function that calculates score statistics for each split of a split candidate (candidate is a feature == all splits of this feature).
 // This function does all the work - it calculates sums in buckets, gets real sums for splits and builds TScoreBin-s from that.
 TVector<TScoreBin> CalcScore(
@@ -62,7 +104,8 @@ TVector<TScoreBin> CalcScore(
     const NCatboostOptions::TCatBoostOptions& fitParams,
     const TSplitCandidate& split,
     int depth,
-    TBucketStatsCache* statsFromPrevTree);
+    TBucketStatsCache* statsFromPrevTree,
+    const TDocBlocksParallelism& docBlocksParallelism = TDocBlocksParallelism());
 
 // Statistics (sums for score calculation) are stored in an array. This class helps navigating in this array.
 struct TStatsIndexer {
@@ -87,10 +130,11 @@ inline const TOnlineCTR& GetCtr(const std::tuple<const TOnlineCTRHash&, const TO
 
 // Helper function for calculating index of leaf for each document given a new split.
 // Calculates indices when a permutation is given.
-template<typename TBucketIndexType, typename TFullIndexType>
+// TBucketIndex is TVector of bucket indexes or TPackedBins
+template<typename TBucketIndex, typename TFullIndexType>
 inline void SetSingleIndex(const TCalcScoreFold& fold,
                            const TStatsIndexer& indexer,
-                           const TVector<TBucketIndexType>& bucketIndex,
+                           const TBucketIndex& bucketIndex,
                            const size_t* docPermutation,
                            TVector<TFullIndexType>* singleIdx) {
     const size_t docCount = fold.GetDocCount();
@@ -158,15 +202,15 @@ inline void UpdateWeighted(const TVector<TFullIndexType>& singleIdx, const doubl
 
 // Update not bootstraped sums on [docBegin, docEnd) in a bucket
 template<typename TFullIndexType>
-inline void UpdateDeltaCount(const TVector<TFullIndexType>& singleIdx, const double* derivatives, const float* learnWeights, int docCount, TBucketStats* stats) {
+inline void UpdateDeltaCount(const TVector<TFullIndexType>& singleIdx, const double* derivatives, const float* learnWeights, int docBegin, int docEnd, TBucketStats* stats) {
     if (learnWeights == nullptr) {
-        for (int doc = 0; doc < docCount; ++doc) {
+        for (int doc = docBegin; doc < docEnd; ++doc) {
             TBucketStats& leafStats = stats[singleIdx[doc]];
             leafStats.SumDelta += derivatives[doc];
             leafStats.Count += 1;
         }
     } else {
-        for (int doc = 0; doc < docCount; ++doc) {
+        for (int doc = docBegin; doc < docEnd; ++doc) {
             TBucketStats& leafStats = stats[singleIdx[doc]];
             leafStats.SumDelta += derivatives[doc];
             leafStats.Count += learnWeights[doc];
@@ -264,6 +308,36 @@ inline void FixUpStats(int depth, const TStatsIndexer& indexer, bool selectedSpl
     }
 }
 
+// Range of stats filled by CalcStatsKernel, only the new half is calculated when caching
+template<typename TIsCaching>
+inline std::pair<int, int> GetCalculatedStatsRange(const TIsCaching& isCaching, const TStatsIndexer& indexer, int depth) {
+    Y_ASSERT(!isCaching || depth > 0);
+    return {isCaching ? indexer.CalcSize(depth - 1) : 0, indexer.CalcSize(depth)};
+}
+
+// Add sums of documents [docBegin, docEnd) of a body tail to bucket stats
+template<typename TFullIndexType>
+inline void AddDocRangeStats(const TVector<TFullIndexType>& singleIdx,
+                             const TCalcScoreFold& fold,
+                             bool isPlainMode,
+                             const TCalcScoreFold::TBodyTail& bt,
+                             int dim,
+                             int docBegin,
+                             int docEnd,
+                             TBucketStats* stats) {
+    const bool hasPairwiseWeights = !bt.PairwiseWeights.empty();
+    const float* weightsData = hasPairwiseWeights ? GetDataPtr(bt.PairwiseWeights) : GetDataPtr(fold.LearnWeights);
+    const float* sampleWeightsData = hasPairwiseWeights ? GetDataPtr(bt.SamplePairwiseWeights) : GetDataPtr(fold.SampleWeights);
+    const int bodyFinish = bt.BodyFinish;
+    const int tailFinish = bt.TailFinish;
+    if (isPlainMode) {
+        UpdateWeighted(singleIdx, GetDataPtr(bt.SampleWeightedDerivatives[dim]), sampleWeightsData, docBegin, Min(docEnd, tailFinish), stats);
+    } else {
+        UpdateDeltaCount(singleIdx, GetDataPtr(bt.WeightedDerivatives[dim]), weightsData, docBegin, Min(docEnd, bodyFinish), stats);
+        UpdateWeighted(singleIdx, GetDataPtr(bt.SampleWeightedDerivatives[dim]), sampleWeightsData, Max(docBegin, bodyFinish), Min(docEnd, tailFinish), stats);
+    }
+}
+
 template<typename TFullIndexType, typename TIsCaching>
 inline void CalcStatsKernel(const TIsCaching& isCaching,
                             const TVector<TFullIndexType>& singleIdx,
@@ -274,22 +348,9 @@ inline void CalcStatsKernel(const TIsCaching& isCaching,
                             const TCalcScoreFold::TBodyTail& bt,
                             int dim,
                             TBucketStats* stats) {
-    Y_ASSERT(!isCaching || depth > 0);
-    if (isCaching) {
-        Fill(stats + indexer.CalcSize(depth - 1), stats + indexer.CalcSize(depth), TBucketStats{0, 0, 0, 0});
-    } else {
-        Fill(stats, stats + indexer.CalcSize(depth), TBucketStats{0, 0, 0, 0});
-    }
-
-    const bool hasPairwiseWeights = !bt.PairwiseWeights.empty();
-    const float* weightsData = hasPairwiseWeights ? GetDataPtr(bt.PairwiseWeights) : GetDataPtr(fold.LearnWeights);
-    const float* sampleWeightsData = hasPairwiseWeights ? GetDataPtr(bt.SamplePairwiseWeights) : GetDataPtr(fold.SampleWeights);
-    if (isPlainMode) {
-        UpdateWeighted(singleIdx, GetDataPtr(bt.SampleWeightedDerivatives[dim]), sampleWeightsData, 0, bt.TailFinish, stats);
-    } else {
-        UpdateDeltaCount(singleIdx, GetDataPtr(bt.WeightedDerivatives[dim]), weightsData, bt.BodyFinish, stats);
-        UpdateWeighted(singleIdx, GetDataPtr(bt.SampleWeightedDerivatives[dim]), sampleWeightsData, bt.BodyFinish, bt.TailFinish, stats);
-    }
+    const auto statsRange = GetCalculatedStatsRange(isCaching, indexer, depth);
+    Fill(stats + statsRange.first, stats + statsRange.second, TBucketStats{0, 0, 0, 0});
+    AddDocRangeStats(singleIdx, fold, isPlainMode, bt, dim, 0, bt.TailFinish, stats);
     if (isCaching) {
         FixUpStats(depth, indexer, fold.SmallestSplitSideValue, stats);
     }
@@ -201,8 +201,6 @@ void TrainOneIter(const TDataset& learnData, const TDatasetPtrs& testDataPtrs, T
             trainFolds.push_back(&ctx->LearnProgress.Folds[foldId]);
         }
 
-        TrimOnlineCTRcache(trainFolds);
-        TrimOnlineCTRcache({ &ctx->LearnProgress.AveragingFold });
         {
             TVector<TFold*> allFolds = trainFolds;
             allFolds.push_back(&ctx->LearnProgress.AveragingFold);
@@ -218,7 +216,7 @@ void TrainOneIter(const TDataset& learnData, const TDatasetPtrs& testDataPtrs, T
                 }
             };
 
-            TVector<TLocalJobData> parallelJobsData;
+            TVector<std::pair<TFold*, TProjection>> ctrsToCalc;
             THashSet<TProjection> seenProjections;
             for (const auto& split : bestSplitTree.Splits) {
                 if (split.Type != ESplitType::OnlineCtr) {
@@ -230,12 +228,22 @@ void TrainOneIter(const TDataset& learnData, const TDatasetPtrs& testDataPtrs, T
                     continue;
                 }
                 for (auto* foldPtr : allFolds) {
-                    if (!foldPtr->GetCtrs(proj).has(proj) || foldPtr->GetCtr(proj).Feature.empty()) {
-                        parallelJobsData.emplace_back(TLocalJobData{ &learnData, testDataPtrs, proj, foldPtr, &foldPtr->GetCtrRef(proj) });
+                    const bool isCtrCached = foldPtr->TouchCtr(proj, currentIteration);
+                    ctx->OnlineCtrCacheStats.AddLookup(isCtrCached);
+                    if (!isCtrCached) {
+                        ctrsToCalc.emplace_back(foldPtr, proj);
                     }
                 }
                 seenProjections.insert(proj);
             }
+            // ctrs of current tree are the most recently used, so they are kept
+            TrimOnlineCTRcache(allFolds, ctx);
+
+            TVector<TLocalJobData> parallelJobsData;
+            for (const auto& foldAndProj : ctrsToCalc) {
+                TFold* foldPtr = foldAndProj.first;
+                parallelJobsData.emplace_back(TLocalJobData{ &learnData, testDataPtrs, foldAndProj.second, foldPtr, &foldPtr->GetCtrRef(foldAndProj.second) });
+            }
 
             ctx->LocalExecutor.ExecRange([&](int taskId){
                 parallelJobsData[taskId].DoTask(ctx);
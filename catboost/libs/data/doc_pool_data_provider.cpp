@@ -1,6 +1,7 @@
 
 #include "doc_pool_data_provider.h"
 
+#include "dsv_parser.h"
 #include "load_data.h"
 #include "load_helpers.h"
 
@@ -74,10 +75,10 @@ namespace NCB {
     {
     }
 
-    float TTargetConverter::operator()(const TString& word) const {
+    float TTargetConverter::operator()(TStringBuf word) const {
         if (ClassNames.empty()) {
             CB_ENSURE(!IsNanValue(word), "NaN not supported for target");
-            return FromString<float>(word);
+            return ParseFloat(word);
         }
 
         for (int classIndex = 0; classIndex < ClassNames.ysize(); ++classIndex) {
@@ -86,7 +87,7 @@ namespace NCB {
             }
         }
 
-        CB_ENSURE(false, "Unknown class name: " + word);
+        CB_ENSURE(false, "Unknown class name: " << word);
         return UNDEFINED_CLASS;
     }
 
@@ -277,22 +278,25 @@ namespace NCB {
 
         auto& columnsDescription = PoolMetaInfo.ColumnsInfo->Columns;
 
-        auto parseBlock = [&](TString& line, int lineIdx) {
+        auto parseLine = [&](TString& line, int lineIdx) {
             ui32 featureId = 0;
             ui32 baselineIdx = 0;
-            TVector<float> features;
-            features.yresize(PoolMetaInfo.FeatureCount);
 
+            // fields are parsed in place and written straight to the builder
             int tokenCount = 0;
-            TVector<TStringBuf> tokens = StringSplitter(line).Split(FieldDelimiter).ToList<TStringBuf>();
-            for (const auto& token : tokens) {
+            TDsvLineTokenizer tokenizer(line, FieldDelimiter);
+            TStringBuf token;
+            while (tokenizer.Next(&token)) {
+                CB_ENSURE(tokenCount < columnsDescription.ysize(), "wrong columns number in pool line " <<
+                          AsyncRowProcessor.GetLinesProcessed() + lineIdx + 1 << ": expected " << columnsDescription.ysize()
+                          << ", found " << tokenCount + 1 + tokenizer.CountRest());
                 switch (columnsDescription[tokenCount].Type) {
                     case EColumn::Categ: {
                         if (!FeatureIgnored[featureId]) {
                             if (IsNanValue(token)) {
-                                features[featureId] = poolBuilder->GetCatFeatureValue("nan");
+                                poolBuilder->AddCatFeature(lineIdx, featureId, AsStringBuf("nan"));
                             } else {
-                                features[featureId] = poolBuilder->GetCatFeatureValue(token);
+                                poolBuilder->AddCatFeature(lineIdx, featureId, token);
                             }
                         }
                         ++featureId;
@@ -301,7 +305,7 @@ namespace NCB {
                     case EColumn::Num: {
                         if (!FeatureIgnored[featureId]) {
                             float val;
-                            if (!TryFromString<float>(token, val)) {
+                            if (!TryParseFloat(token, &val)) {
                                 if (IsNanValue(token)) {
                                     val = std::numeric_limits<float>::quiet_NaN();
                                 } else if (token.length() == 0) {
@@ -313,19 +317,19 @@ namespace NCB {
                                         << " that cannot be parsed as float. Try correcting column description file.");
                                 }
                             }
-                            features[featureId] = val == 0.0f ? 0.0f : val; // remove negative zeros
+                            poolBuilder->AddFloatFeature(lineIdx, featureId, val == 0.0f ? 0.0f : val); // remove negative zeros
                         }
                         ++featureId;
                         break;
                     }
                     case EColumn::Label: {
                         CB_ENSURE(token.length() != 0, "empty values not supported for Label. Label should be float.");
-                        poolBuilder->AddTarget(lineIdx, ConvertTarget(FromString<TString>(token)));
+                        poolBuilder->AddTarget(lineIdx, ConvertTarget(token));
                         break;
                     }
                     case EColumn::Weight: {
                         CB_ENSURE(token.length() != 0, "empty values not supported for weight");
-                        poolBuilder->AddWeight(lineIdx, FromString<float>(token));
+                        poolBuilder->AddWeight(lineIdx, ParseFloat(token));
                         break;
                     }
                     case EColumn::Auxiliary: {
@@ -338,7 +342,7 @@ namespace NCB {
                     }
                     case EColumn::GroupWeight: {
                         CB_ENSURE(token.length() != 0, "empty values not supported for GroupWeight");
-                        poolBuilder->AddWeight(lineIdx, FromString<float>(token));
+                        poolBuilder->AddWeight(lineIdx, ParseFloat(token));
                         break;
                     }
                     case EColumn::SubgroupId: {
@@ -348,7 +352,7 @@ namespace NCB {
                     }
                     case EColumn::Baseline: {
                         CB_ENSURE(token.length() != 0, "empty values not supported for Baseline");
-                        poolBuilder->AddBaseline(lineIdx, baselineIdx, FromString<double>(token));
+                        poolBuilder->AddBaseline(lineIdx, baselineIdx, ParseDouble(token));
                         ++baselineIdx;
                         break;
                     }
@@ -368,12 +372,11 @@ namespace NCB {
                 }
                 ++tokenCount;
             }
-            poolBuilder->AddAllFloatFeatures(lineIdx, features);
             CB_ENSURE(tokenCount == columnsDescription.ysize(), "wrong columns number in pool line " <<
                       AsyncRowProcessor.GetLinesProcessed() + lineIdx + 1 << ": expected " << columnsDescription.ysize() << ", found " << tokenCount);
         };
 
-        AsyncRowProcessor.ProcessBlock(parseBlock);
+        AsyncRowProcessor.ProcessBlock(parseLine);
     }
 
     namespace {
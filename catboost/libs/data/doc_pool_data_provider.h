@@ -12,6 +12,7 @@
 
 #include <library/threading/local_executor/local_executor.h>
 
+#include <util/generic/strbuf.h>
 #include <util/generic/string.h>
 #include <util/generic/vector.h>
 
@@ -60,7 +61,7 @@ namespace NCB {
 
         explicit TTargetConverter(const TVector<TString>& classNames);
 
-        float operator()(const TString& word) const;
+        float operator()(TStringBuf word) const;
 
     private:
         TVector<TString> ClassNames;
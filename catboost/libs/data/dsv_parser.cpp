@@ -0,0 +1,126 @@
+#include "dsv_parser.h"
+
+#include <util/generic/utility.h>
+#include <util/generic/ylimits.h>
+#include <util/string/cast.h>
+
+
+namespace NCB {
+
+    // Powers of 10 exactly representable in double
+    static const double ExactPowersOf10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+        1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    static const int MaxExactPowerOf10 = 22;
+    static const ui64 MaxExactMantissa = ui64(1) << 53;
+
+    static inline bool IsDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // Accumulate digits into mantissa, returns false on overflow
+    static inline bool ParseDigits(const char** pos, const char* end, ui64* mantissa, int* digitCount) {
+        const ui64 maxMantissaBeforeDigit = (Max<ui64>() - 9) / 10;
+        for (; *pos != end && IsDigit(**pos); ++*pos) {
+            if (*mantissa > maxMantissaBeforeDigit) {
+                return false;
+            }
+            *mantissa = *mantissa * 10 + (**pos - '0');
+            ++*digitCount;
+        }
+        return true;
+    }
+
+    /*
+     * [-]digits[.digits][(e|E)[+|-]digits] with mantissa <= 2^53 and decimal exponent in [-22, 22].
+     * Both mantissa and power of 10 are exact doubles, so one multiplication or division is correctly rounded
+     * and gives the same result as the generic parser (Clinger's fast path).
+     */
+    static bool TryParseDoubleFastPath(TStringBuf token, double* value) {
+        const char* pos = token.data();
+        const char* end = token.data() + token.size();
+
+        const bool isNegative = pos != end && *pos == '-';
+        if (isNegative) {
+            ++pos;
+        }
+
+        ui64 mantissa = 0;
+        int integerDigitCount = 0;
+        if (!ParseDigits(&pos, end, &mantissa, &integerDigitCount) || integerDigitCount == 0) {
+            return false;
+        }
+        int exponent = 0;
+        if (pos != end && *pos == '.') {
+            ++pos;
+            int fractionDigitCount = 0;
+            if (!ParseDigits(&pos, end, &mantissa, &fractionDigitCount) || fractionDigitCount == 0) {
+                return false;
+            }
+            exponent -= fractionDigitCount;
+        }
+        if (pos != end && (*pos == 'e' || *pos == 'E')) {
+            ++pos;
+            const bool isExponentNegative = pos != end && *pos == '-';
+            if (pos != end && (*pos == '-' || *pos == '+')) {
+                ++pos;
+            }
+            int explicitExponent = 0;
+            int exponentDigitCount = 0;
+            for (; pos != end && IsDigit(*pos) && exponentDigitCount < 4; ++pos, ++exponentDigitCount) {
+                explicitExponent = explicitExponent * 10 + (*pos - '0');
+            }
+            if (exponentDigitCount == 0) {
+                return false;
+            }
+            exponent += isExponentNegative ? -explicitExponent : explicitExponent;
+        }
+        if (pos != end || mantissa > MaxExactMantissa) {
+            return false;
+        }
+
+        double result = static_cast<double>(mantissa);
+        if (mantissa != 0) {
+            if (exponent < -MaxExactPowerOf10 || exponent > MaxExactPowerOf10) {
+                return false;
+            }
+            if (exponent < 0) {
+                result /= ExactPowersOf10[-exponent];
+            } else {
+                result *= ExactPowersOf10[exponent];
+            }
+        }
+        *value = isNegative ? -result : result;
+        return true;
+    }
+
+    bool TryParseDouble(TStringBuf token, double* value) {
+        return TryParseDoubleFastPath(token, value) || TryFromString<double>(token, *value);
+    }
+
+    bool TryParseFloat(TStringBuf token, float* value) {
+        double doubleValue;
+        if (TryParseDoubleFastPath(token, &doubleValue)) {
+            *value = static_cast<float>(doubleValue); // TryFromString<float> rounds parsed double the same way
+            return true;
+        }
+        return TryFromString<float>(token, *value);
+    }
+
+    double ParseDouble(TStringBuf token) {
+        double value;
+        if (TryParseDoubleFastPath(token, &value)) {
+            return value;
+        }
+        return FromString<double>(token);
+    }
+
+    float ParseFloat(TStringBuf token) {
+        double value;
+        if (TryParseDoubleFastPath(token, &value)) {
+            return static_cast<float>(value);
+        }
+        return FromString<float>(token);
+    }
+}
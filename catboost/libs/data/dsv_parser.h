@@ -0,0 +1,69 @@
+#pragma once
+
+#include <util/generic/strbuf.h>
+
+#include <cstring>
+
+
+namespace NCB {
+
+    /*
+     * Splits a line into fields in place, same fields as StringSplitter(line).Split(delimiter) gives.
+     * Delimiters are found with memchr that is vectorized in libc.
+     */
+    class TDsvLineTokenizer {
+    public:
+        TDsvLineTokenizer(TStringBuf line, char delimiter)
+            : Rest(line)
+            , Delimiter(delimiter)
+        {}
+
+        bool Next(TStringBuf* token) {
+            if (Finished) {
+                return false;
+            }
+            const char* delimiterPos = static_cast<const char*>(memchr(Rest.data(), Delimiter, Rest.size()));
+            if (delimiterPos == nullptr) {
+                *token = Rest;
+                Finished = true;
+            } else {
+                *token = TStringBuf(Rest.data(), delimiterPos);
+                Rest = TStringBuf(delimiterPos + 1, Rest.data() + Rest.size());
+            }
+            return true;
+        }
+
+        // number of fields not returned yet
+        size_t CountRest() const {
+            if (Finished) {
+                return 0;
+            }
+            size_t count = 1;
+            for (const char* pos = Rest.data(), *end = Rest.data() + Rest.size();
+                 (pos = static_cast<const char*>(memchr(pos, Delimiter, end - pos))) != nullptr;
+                 ++pos)
+            {
+                ++count;
+            }
+            return count;
+        }
+
+    private:
+        TStringBuf Rest;
+        char Delimiter;
+        bool Finished = false;
+    };
+
+    /*
+     * Same results as TryFromString<double> and TryFromString<float>.
+     * Plain decimal values with mantissa up to 2^53 and small exponent are converted without the generic parser.
+     */
+    bool TryParseDouble(TStringBuf token, double* value);
+
+    bool TryParseFloat(TStringBuf token, float* value);
+
+    // throws the same exception as FromString if value can't be parsed
+    double ParseDouble(TStringBuf token);
+
+    float ParseFloat(TStringBuf token);
+}
@@ -1,6 +1,8 @@
 #include "load_data.h"
 
 #include "doc_pool_data_provider.h"
+#include "pool_cache.h"
+#include "quantized_pool_loader.h"
 
 #include <catboost/libs/helpers/exception.h>
 
@@ -162,6 +164,28 @@ namespace NCB {
         const TVector<TString>& classNames,
         TPool* pool
     ) {
+        if (poolPath.Scheme == "quantized") {
+            NPar::TLocalExecutor localExecutor;
+            localExecutor.RunAdditionalThreads(threadCount - 1);
+            if (verbose) {
+                SetVerboseLogingMode();
+            } else {
+                SetSilentLogingMode();
+            }
+            ReadQuantizedPool(poolPath, pairsFilePath, ignoredFeatures, &localExecutor, pool);
+            SetVerboseLogingMode();
+            return;
+        }
+
+        const bool usePoolCache = dsvPoolFormatParams.UsePoolCache && poolPath.Scheme == "dsv";
+        TPoolCacheKey poolCacheKey;
+        if (usePoolCache) {
+            poolCacheKey = MakePoolCacheKey(poolPath, pairsFilePath, dsvPoolFormatParams, ignoredFeatures, classNames);
+            if (TryLoadPoolCache(GetPoolCachePath(poolPath), poolCacheKey, pool)) {
+                return;
+            }
+        }
+
         NPar::TLocalExecutor localExecutor;
         localExecutor.RunAdditionalThreads(threadCount - 1);
         TPoolBuilder builder(localExecutor, pool);
@@ -175,6 +199,15 @@ namespace NCB {
             &localExecutor,
             &builder
         );
+
+        if (usePoolCache) {
+            const TString cachePath = GetPoolCachePath(poolPath);
+            try {
+                SavePoolCache(cachePath, poolCacheKey, *pool);
+            } catch (const yexception& e) {
+                MATRIXNET_WARNING_LOG << "Can't save pool cache " << cachePath << ": " << e.what() << Endl;
+            }
+        }
     }
 
     void ReadPool(
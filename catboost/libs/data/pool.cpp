@@ -8,6 +8,8 @@ static TDocumentStorage SliceDocumentStorage(
         CB_ENSURE(rowIndex < docs.GetDocCount(), "Pool doesn't have a row with index " << rowIndex);
     }
 
+    CB_ENSURE(docs.QuantizedFactors.empty(), "Slicing pools with quantized features is not supported");
+
     TDocumentStorage slicedDocs;
     slicedDocs.Resize(rowIndices.size(), docs.GetEffectiveFactorCount());
 
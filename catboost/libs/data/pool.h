@@ -5,6 +5,8 @@
 #include <catboost/libs/data_types/pair.h>
 #include <catboost/libs/helpers/exception.h>
 #include <catboost/libs/cat_feature/cat_feature.h>
+#include <catboost/libs/helpers/packed_bins.h>
+#include <catboost/libs/options/enums.h>
 
 #include <util/string/cast.h>
 #include <util/random/fast.h>
@@ -66,8 +68,20 @@ struct TDocInfo {
     }
 };
 
+// Float feature loaded already quantized, e.g. from a quantized pool
+struct TQuantizedFactor {
+    TVector<float> Borders;
+    ENanMode NanMode = ENanMode::Min;
+    TPackedBins Bins; // [docIdx], empty if there are no borders
+
+    bool operator==(const TQuantizedFactor& other) const {
+        return std::tie(Borders, NanMode, Bins) == std::tie(other.Borders, other.NanMode, other.Bins);
+    }
+};
+
 struct TDocumentStorage {
     TVector<TVector<float>> Factors; // [factorIdx][docIdx]
+    THashMap<int, TQuantizedFactor> QuantizedFactors; // [factorIdx], Factors[factorIdx] of these are empty
     TVector<TVector<double>> Baseline; // [dim][docIdx]
     TVector<float> Target; // [docIdx]
     TVector<float> Weight; // [docIdx]
@@ -103,8 +117,8 @@ struct TDocumentStorage {
             }
         }
         return areFactorsEqual && (
-            std::tie(Baseline, Target, Weight, Id, QueryId, SubgroupId, Timestamp) ==
-            std::tie(other.Baseline, other.Target, other.Weight, other.Id, other.QueryId, other.SubgroupId, other.Timestamp)
+            std::tie(QuantizedFactors, Baseline, Target, Weight, Id, QueryId, SubgroupId, Timestamp) ==
+            std::tie(other.QuantizedFactors, other.Baseline, other.Target, other.Weight, other.Id, other.QueryId, other.SubgroupId, other.Timestamp)
         );
     }
 
@@ -114,6 +128,7 @@ struct TDocumentStorage {
 
     inline void Swap(TDocumentStorage& other) {
         Factors.swap(other.Factors);
+        QuantizedFactors.swap(other.QuantizedFactors);
         Baseline.swap(other.Baseline);
         Target.swap(other.Target);
         Weight.swap(other.Weight);
@@ -124,6 +139,7 @@ struct TDocumentStorage {
     }
 
     inline void SwapDoc(size_t doc1Idx, size_t doc2Idx) {
+        Y_ASSERT(QuantizedFactors.empty());
         for (int factorIdx = 0; factorIdx < GetEffectiveFactorCount(); ++factorIdx) {
             DoSwap(Factors[factorIdx][doc1Idx], Factors[factorIdx][doc2Idx]);
         }
@@ -145,6 +161,7 @@ struct TDocumentStorage {
     inline void AssignDoc(int destinationIdx, const TDocumentStorage& sourceDocs, int sourceIdx) {
         Y_ASSERT(GetEffectiveFactorCount() == sourceDocs.GetEffectiveFactorCount());
         Y_ASSERT(GetBaselineDimension() == sourceDocs.GetBaselineDimension());
+        Y_ASSERT(sourceDocs.QuantizedFactors.empty());
         for (int factorIdx = 0; factorIdx < GetEffectiveFactorCount(); ++factorIdx) {
             Factors[factorIdx][destinationIdx] = sourceDocs.Factors[factorIdx][sourceIdx];
         }
@@ -192,6 +209,7 @@ struct TDocumentStorage {
             factor.clear();
             factor.shrink_to_fit();
         }
+        QuantizedFactors.clear();
         for (auto& dim : Baseline) {
             dim.clear();
             dim.shrink_to_fit();
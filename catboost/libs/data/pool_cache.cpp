@@ -0,0 +1,214 @@
+#include "pool_cache.h"
+
+#include <catboost/libs/logging/logging.h>
+
+#include <util/digest/city.h>
+#include <util/generic/guid.h>
+#include <util/generic/yexception.h>
+#include <util/stream/file.h>
+#include <util/stream/mem.h>
+#include <util/stream/str.h>
+#include <util/system/filemap.h>
+#include <util/system/fs.h>
+#include <util/system/fstat.h>
+#include <util/ysaveload.h>
+
+
+namespace NCB {
+
+    static const ui64 PoolCacheMagic = 0x48434143504243ull; // "CBPCACH"
+    static const ui32 PoolCacheVersion = 1;
+
+    static void GetFileSizeAndMTime(const TPathWithScheme& path, ui64* size, i64* mTime) {
+        if (!path.Inited()) {
+            return;
+        }
+        const TFileStat stat(path.Path);
+        *size = stat.Size;
+        *mTime = stat.MTime;
+    }
+
+    TPoolCacheKey MakePoolCacheKey(const TPathWithScheme& poolPath,
+                                   const TPathWithScheme& pairsFilePath,
+                                   const NCatboostOptions::TDsvPoolFormatParams& dsvPoolFormatParams,
+                                   const TVector<int>& ignoredFeatures,
+                                   const TVector<TString>& classNames) {
+        TPoolCacheKey key;
+        GetFileSizeAndMTime(poolPath, &key.PoolFileSize, &key.PoolFileMTime);
+        GetFileSizeAndMTime(pairsFilePath, &key.PairsFileSize, &key.PairsFileMTime);
+
+        TStringStream loadParams;
+        const auto& cdFilePath = dsvPoolFormatParams.CdFilePath;
+        if (cdFilePath.Inited() && (cdFilePath.Scheme.empty() || cdFilePath.Scheme == "file")) {
+            ::Save(&loadParams, TIFStream(cdFilePath.Path).ReadAll());
+        } else {
+            ::SaveMany(&loadParams, cdFilePath.Scheme, cdFilePath.Path);
+        }
+        ::SaveMany(
+            &loadParams,
+            dsvPoolFormatParams.Format.Delimiter,
+            dsvPoolFormatParams.Format.HasHeader,
+            ignoredFeatures,
+            classNames
+        );
+        key.LoadParamsHash = CityHash64(loadParams.Str());
+        return key;
+    }
+
+    TString GetPoolCachePath(const TPathWithScheme& poolPath) {
+        return poolPath.Path + ".cbcache";
+    }
+
+    static void SaveMetaInfo(IOutputStream* out, const TPoolMetaInfo& metaInfo) {
+        ::SaveMany(
+            out,
+            metaInfo.FeatureCount,
+            metaInfo.BaselineCount,
+            metaInfo.HasGroupId,
+            metaInfo.HasGroupWeight,
+            metaInfo.HasSubgroupIds,
+            metaInfo.HasDocIds,
+            metaInfo.HasWeights,
+            metaInfo.HasTimestamp
+        );
+        ::Save(out, metaInfo.ColumnsInfo.Defined());
+        if (metaInfo.ColumnsInfo.Defined()) {
+            const auto& columns = metaInfo.ColumnsInfo->Columns;
+            ::Save(out, static_cast<ui64>(columns.size()));
+            for (const auto& column : columns) {
+                ::SaveMany(out, column.Type, column.Id);
+            }
+        }
+    }
+
+    static void LoadMetaInfo(IInputStream* in, TPoolMetaInfo* metaInfo) {
+        ::LoadMany(
+            in,
+            metaInfo->FeatureCount,
+            metaInfo->BaselineCount,
+            metaInfo->HasGroupId,
+            metaInfo->HasGroupWeight,
+            metaInfo->HasSubgroupIds,
+            metaInfo->HasDocIds,
+            metaInfo->HasWeights,
+            metaInfo->HasTimestamp
+        );
+        bool hasColumnsInfo;
+        ::Load(in, hasColumnsInfo);
+        metaInfo->ColumnsInfo.Clear();
+        if (hasColumnsInfo) {
+            ui64 columnCount;
+            ::Load(in, columnCount);
+            TVector<TColumn> columns(columnCount);
+            for (auto& column : columns) {
+                ::LoadMany(in, column.Type, column.Id);
+            }
+            metaInfo->ColumnsInfo = TPoolColumnsMetaInfo{std::move(columns)};
+        }
+    }
+
+    static void SavePairs(IOutputStream* out, const TVector<TPair>& pairs) {
+        ::Save(out, static_cast<ui64>(pairs.size()));
+        for (const auto& pair : pairs) {
+            ::SaveMany(out, pair.WinnerId, pair.LoserId, pair.Weight);
+        }
+    }
+
+    static void LoadPairs(IInputStream* in, TVector<TPair>* pairs) {
+        ui64 pairCount;
+        ::Load(in, pairCount);
+        pairs->resize(pairCount);
+        for (auto& pair : *pairs) {
+            ::LoadMany(in, pair.WinnerId, pair.LoserId, pair.Weight);
+        }
+    }
+
+    bool TryLoadPoolCache(const TString& cachePath, const TPoolCacheKey& key, TPool* pool) {
+        if (!NFs::Exists(cachePath)) {
+            return false;
+        }
+        try {
+            TFileMap cacheMap(cachePath);
+            cacheMap.Map(0, cacheMap.Length());
+            cacheMap.SetSequential();
+            TMemoryInput in(cacheMap.Ptr(), cacheMap.MappedSize());
+
+            ui64 magic;
+            ui32 version;
+            TPoolCacheKey cacheKey;
+            ::LoadMany(&in, magic, version);
+            if (magic != PoolCacheMagic || version != PoolCacheVersion) {
+                MATRIXNET_INFO_LOG << "Pool cache " << cachePath << " has unsupported format, ignoring it" << Endl;
+                return false;
+            }
+            ::Load(&in, cacheKey);
+            if (!(cacheKey == key)) {
+                MATRIXNET_INFO_LOG << "Pool cache " << cachePath << " is outdated, ignoring it" << Endl;
+                return false;
+            }
+
+            TPool cachedPool;
+            LoadMetaInfo(&in, &cachedPool.MetaInfo);
+            ::LoadMany(&in, cachedPool.CatFeatures, cachedPool.FeatureId, cachedPool.CatFeaturesHashToString);
+            LoadPairs(&in, &cachedPool.Pairs);
+
+            auto& docs = cachedPool.Docs;
+            ::LoadMany(
+                &in,
+                docs.Factors,
+                docs.Baseline,
+                docs.Target,
+                docs.Weight,
+                docs.Id,
+                docs.QueryId,
+                docs.SubgroupId,
+                docs.Timestamp
+            );
+            CB_ENSURE(in.Exhausted(), "unexpected data after the end of pool");
+
+            pool->Swap(cachedPool);
+        } catch (const std::exception& e) {
+            // corrupted sizes make vectors fail to allocate, so cache is ignored on any error
+            MATRIXNET_WARNING_LOG << "Can't load pool cache " << cachePath << ": " << e.what() << Endl;
+            return false;
+        }
+        MATRIXNET_INFO_LOG << "Pool is loaded from cache " << cachePath << Endl;
+        return true;
+    }
+
+    void SavePoolCache(const TString& cachePath, const TPoolCacheKey& key, const TPool& pool) {
+        // Unique name so concurrent runs sharing the cache dir never write the same file,
+        // readers see either no cache or a complete one after the rename
+        const TString tmpCachePath = cachePath + "." + CreateGuidAsString() + ".tmp";
+        try {
+            TOFStream out(tmpCachePath);
+            ::SaveMany(&out, PoolCacheMagic, PoolCacheVersion, key);
+
+            SaveMetaInfo(&out, pool.MetaInfo);
+            ::SaveMany(&out, pool.CatFeatures, pool.FeatureId, pool.CatFeaturesHashToString);
+            SavePairs(&out, pool.Pairs);
+
+            const auto& docs = pool.Docs;
+            ::SaveMany(
+                &out,
+                docs.Factors,
+                docs.Baseline,
+                docs.Target,
+                docs.Weight,
+                docs.Id,
+                docs.QueryId,
+                docs.SubgroupId,
+                docs.Timestamp
+            );
+            out.Finish();
+        } catch (...) {
+            NFs::Remove(tmpCachePath);
+            throw;
+        }
+        const bool isRenamed = NFs::Rename(tmpCachePath, cachePath);
+        if (!isRenamed) {
+            NFs::Remove(tmpCachePath);
+        }
+        CB_ENSURE(isRenamed, "Can't rename " << tmpCachePath << " to " << cachePath);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "pool.h"
+
+#include <catboost/libs/data_util/path_with_scheme.h>
+#include <catboost/libs/options/load_options.h>
+
+#include <util/generic/string.h>
+#include <util/generic/vector.h>
+#include <util/system/types.h>
+
+
+namespace NCB {
+
+    /*
+     * Identifies the source of a binary pool cache: sizes and modification times of the pool and pairs files
+     * and a hash of everything else that changes the loaded pool (column description contents, dsv format,
+     * ignored features and class names).
+     * Modification time has a second resolution, a rewrite with the same size within a second is not detected.
+     */
+    struct TPoolCacheKey {
+        ui64 PoolFileSize = 0;
+        i64 PoolFileMTime = 0;
+        ui64 PairsFileSize = 0;
+        i64 PairsFileMTime = 0;
+        ui64 LoadParamsHash = 0;
+
+        bool operator==(const TPoolCacheKey& rhs) const {
+            return std::tie(PoolFileSize, PoolFileMTime, PairsFileSize, PairsFileMTime, LoadParamsHash) ==
+                std::tie(rhs.PoolFileSize, rhs.PoolFileMTime, rhs.PairsFileSize, rhs.PairsFileMTime, rhs.LoadParamsHash);
+        }
+
+        Y_SAVELOAD_DEFINE(PoolFileSize, PoolFileMTime, PairsFileSize, PairsFileMTime, LoadParamsHash);
+    };
+
+    TPoolCacheKey MakePoolCacheKey(const TPathWithScheme& poolPath,
+                                   const TPathWithScheme& pairsFilePath, // can be uninited
+                                   const NCatboostOptions::TDsvPoolFormatParams& dsvPoolFormatParams,
+                                   const TVector<int>& ignoredFeatures,
+                                   const TVector<TString>& classNames);
+
+    // cache file is stored next to the pool file
+    TString GetPoolCachePath(const TPathWithScheme& poolPath);
+
+    /*
+     * Cache stores TDocumentStorage columns as contiguous arrays, so loading is a memory map of the file
+     * and a sequential copy of every column.
+     * @return false if the cache is absent, has another key or can't be read
+     */
+    bool TryLoadPoolCache(const TString& cachePath, const TPoolCacheKey& key, TPool* pool);
+
+    // Writes to a temporary file that is renamed to cachePath, so a concurrent reader never sees a partial cache
+    void SavePoolCache(const TString& cachePath, const TPoolCacheKey& key, const TPool& pool);
+}
@@ -0,0 +1,201 @@
+#include "quantized_pool_loader.h"
+
+#include "doc_pool_data_provider.h"
+
+#include <catboost/idl/pool/flat/quantized_chunk_t.fbs.h>
+#include <catboost/libs/column_description/column.h>
+#include <catboost/libs/helpers/exception.h>
+#include <catboost/libs/logging/logging.h>
+#include <catboost/libs/quantization_schema/detail.h>
+#include <catboost/libs/quantized_pool/pool.h>
+#include <catboost/libs/quantized_pool/serialization.h>
+
+#include <util/generic/algorithm.h>
+#include <util/generic/array_ref.h>
+#include <util/generic/is_in.h>
+#include <util/generic/mem_copy.h>
+#include <util/system/types.h>
+#include <util/system/unaligned_mem.h>
+
+
+namespace NCB {
+
+    using TChunks = TConstArrayRef<TQuantizedPool::TChunkDescription>;
+
+    static TPoolMetaInfo GetPoolMetaInfo(const TQuantizedPool& quantizedPool) {
+        TPoolMetaInfo metaInfo;
+        metaInfo.FeatureCount = 0;
+        metaInfo.BaselineCount = 0;
+        for (const auto columnType : quantizedPool.ColumnTypes) {
+            metaInfo.FeatureCount += static_cast<ui32>(IsFactorColumn(columnType));
+            metaInfo.BaselineCount += static_cast<ui32>(columnType == EColumn::Baseline);
+            metaInfo.HasGroupId |= columnType == EColumn::GroupId;
+            metaInfo.HasGroupWeight |= columnType == EColumn::GroupWeight;
+            metaInfo.HasSubgroupIds |= columnType == EColumn::SubgroupId;
+            metaInfo.HasDocIds |= columnType == EColumn::DocId;
+            metaInfo.HasWeights |= columnType == EColumn::Weight;
+            metaInfo.HasTimestamp |= columnType == EColumn::Timestamp;
+        }
+        return metaInfo;
+    }
+
+    template <typename T, typename TAddValue>
+    static void ForEachChunkValue(TChunks chunks, size_t docCount, const TAddValue& addValue) {
+        for (const auto& descriptor : chunks) {
+            CB_ENSURE(static_cast<size_t>(descriptor.Chunk->BitsPerDocument()) == sizeof(T) * 8);
+            TUnalignedMemoryIterator<T> it(
+                descriptor.Chunk->Quants()->data(),
+                descriptor.Chunk->Quants()->size());
+            for (size_t docIdx = descriptor.DocumentOffset; !it.AtEnd(); it.Next(), ++docIdx) {
+                CB_ENSURE(docIdx < docCount, "Chunk is out of pool document range");
+                addValue(docIdx, it.Cur());
+            }
+        }
+    }
+
+    static TPackedBins ReadQuantizedBins(TChunks chunks,
+                                         size_t docCount,
+                                         size_t borderCount,
+                                         NPar::TLocalExecutor* localExecutor) {
+        TVector<ui8> hist(docCount);
+        for (const auto& descriptor : chunks) {
+            CB_ENSURE(static_cast<size_t>(descriptor.Chunk->BitsPerDocument()) == sizeof(ui8) * 8);
+            const auto* quants = descriptor.Chunk->Quants();
+            CB_ENSURE(descriptor.DocumentOffset + quants->size() <= docCount, "Chunk is out of pool document range");
+            MemCopy(hist.data() + descriptor.DocumentOffset, quants->data(), quants->size());
+        }
+        CB_ENSURE(AllOf(hist, [borderCount] (ui8 bin) { return bin <= borderCount; }), "Bin is out of feature borders range");
+        return PackBins(hist, TPackedBins::GetBitsPerValue(borderCount), localExecutor);
+    }
+
+    static void AddColumn(const TQuantizedPool& quantizedPool,
+                          size_t columnIdx,
+                          int featureIdx,
+                          int baselineIdx,
+                          bool isIgnoredFeature,
+                          NPar::TLocalExecutor* localExecutor,
+                          TPool* pool) {
+        const auto localIdx = quantizedPool.ColumnIndexToLocalIndex.at(columnIdx);
+        const auto columnType = quantizedPool.ColumnTypes[localIdx];
+        const TChunks chunks = quantizedPool.Chunks[localIdx];
+        const size_t docCount = quantizedPool.DocumentCount;
+        auto& docs = pool->Docs;
+
+        switch (columnType) {
+            case EColumn::Num: {
+                auto& quantizedFactor = docs.QuantizedFactors[featureIdx];
+                const auto& columnIndexToSchema = quantizedPool.QuantizationSchema.GetColumnIndexToSchema();
+                const auto it = columnIndexToSchema.find(columnIdx);
+                if (isIgnoredFeature || it == columnIndexToSchema.end() || it->second.GetBorders().empty()) {
+                    // const or ignored feature, it will have no borders and no nan values
+                    quantizedFactor.NanMode = ENanMode::Forbidden;
+                    break;
+                }
+                quantizedFactor.Borders.assign(it->second.GetBorders().begin(), it->second.GetBorders().end());
+                quantizedFactor.NanMode = NQuantizationSchemaDetail::NanModeFromProto(it->second.GetNanMode());
+                quantizedFactor.Bins = ReadQuantizedBins(chunks, docCount, quantizedFactor.Borders.size(), localExecutor);
+                break;
+            }
+            case EColumn::Categ: {
+                // categorical features are not quantized yet, they are kept only to be ignored like in dsv pools
+                CB_ENSURE(chunks.empty(), "Categorical features in quantized pools are not supported yet");
+                pool->CatFeatures.push_back(featureIdx);
+                docs.Factors[featureIdx].resize(docCount);
+                break;
+            }
+            case EColumn::Sparse: {
+                CB_ENSURE(chunks.empty(), "Sparse features are not supported");
+                docs.QuantizedFactors[featureIdx].NanMode = ENanMode::Forbidden;
+                break;
+            }
+            case EColumn::Label: {
+                ForEachChunkValue<float>(chunks, docCount, [&docs] (size_t docIdx, float value) {
+                    docs.Target[docIdx] = value;
+                });
+                break;
+            }
+            case EColumn::Weight:
+            case EColumn::GroupWeight: {
+                ForEachChunkValue<float>(chunks, docCount, [&docs] (size_t docIdx, float value) {
+                    docs.Weight[docIdx] = value;
+                });
+                break;
+            }
+            case EColumn::Baseline: {
+                ForEachChunkValue<double>(chunks, docCount, [&docs, baselineIdx] (size_t docIdx, double value) {
+                    docs.Baseline[baselineIdx][docIdx] = value;
+                });
+                break;
+            }
+            case EColumn::DocId: {
+                ForEachChunkValue<ui64>(chunks, docCount, [&docs] (size_t docIdx, ui64 value) {
+                    docs.Id[docIdx] = ToString(value);
+                });
+                break;
+            }
+            case EColumn::GroupId: {
+                ForEachChunkValue<ui64>(chunks, docCount, [&docs] (size_t docIdx, ui64 value) {
+                    docs.QueryId[docIdx] = value;
+                });
+                break;
+            }
+            case EColumn::SubgroupId: {
+                ForEachChunkValue<ui32>(chunks, docCount, [&docs] (size_t docIdx, ui32 value) {
+                    docs.SubgroupId[docIdx] = value;
+                });
+                break;
+            }
+            case EColumn::Auxiliary:
+            case EColumn::Timestamp:
+            case EColumn::Prediction: {
+                CB_ENSURE(chunks.empty(), "Unexpected column type " << columnType);
+                break;
+            }
+        }
+    }
+
+    void ReadQuantizedPool(const TPathWithScheme& poolPath,
+                           const TPathWithScheme& pairsFilePath,
+                           const TVector<int>& ignoredFeatures,
+                           NPar::TLocalExecutor* localExecutor,
+                           TPool* pool) {
+        TLoadQuantizedPoolParameters loadParameters;
+        loadParameters.LockMemory = false;
+        loadParameters.Precharge = false;
+        const auto quantizedPool = LoadQuantizedPool(poolPath.Path, loadParameters);
+
+        const TPoolMetaInfo metaInfo = GetPoolMetaInfo(quantizedPool);
+        const size_t docCount = quantizedPool.DocumentCount;
+        pool->Docs.Resize(docCount, /*featureCount*/ 0, metaInfo.BaselineCount, metaInfo.HasGroupId, metaInfo.HasSubgroupIds);
+        pool->Docs.Factors.resize(metaInfo.FeatureCount);
+        pool->FeatureId.assign(metaInfo.FeatureCount, TString());
+        pool->MetaInfo = metaInfo;
+
+        int featureIdx = 0;
+        int baselineIdx = 0;
+        for (size_t columnIdx = 0; columnIdx < quantizedPool.ColumnTypes.size(); ++columnIdx) {
+            const auto localIdx = quantizedPool.ColumnIndexToLocalIndex.at(columnIdx);
+            const auto columnType = quantizedPool.ColumnTypes[localIdx];
+            const bool isIgnoredInTraining = IsIn(ignoredFeatures, featureIdx);
+            const bool isIgnoredFeature = IsIn(quantizedPool.IgnoredColumnIndices, columnIdx) || isIgnoredInTraining;
+            CB_ENSURE(columnType != EColumn::Categ || isIgnoredInTraining,
+                      "Categorical feature " << featureIdx << " has no values in quantized pool, it should be ignored in training");
+
+            AdviseSequentialColumnAccess(quantizedPool, localIdx);
+            AddColumn(quantizedPool, columnIdx, featureIdx, baselineIdx, isIgnoredFeature, localExecutor, pool);
+            EvictColumn(quantizedPool, localIdx);
+
+            featureIdx += static_cast<int>(IsFactorColumn(columnType));
+            baselineIdx += static_cast<int>(columnType == EColumn::Baseline);
+        }
+
+        if (pairsFilePath.Inited()) {
+            pool->Pairs = ReadPairs(pairsFilePath, docCount);
+            if (metaInfo.HasGroupWeight) {
+                WeightPairs(pool->Docs.Weight, &pool->Pairs);
+            }
+        }
+
+        MATRIXNET_INFO_LOG << "Quantized pool sizes: " << docCount << " " << metaInfo.FeatureCount << Endl;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "pool.h"
+
+#include <catboost/libs/data_util/path_with_scheme.h>
+
+#include <library/threading/local_executor/local_executor.h>
+
+#include <util/generic/vector.h>
+
+
+namespace NCB {
+
+    /*
+     * Load pool saved by `SaveQuantizedPool` for CPU training.
+     * Numeric features are stored in `Docs.QuantizedFactors` with borders from the pool quantization schema,
+     * raw float values are not materialized. Columns are read from file mapping one by one and evicted after that.
+     * Categorical features have no values in quantized pools, so all of them should be in `ignoredFeatures`.
+     */
+    void ReadQuantizedPool(const TPathWithScheme& poolPath,
+                           const TPathWithScheme& pairsFilePath, // can be uninited
+                           const TVector<int>& ignoredFeatures,
+                           NPar::TLocalExecutor* localExecutor,
+                           TPool* pool);
+}
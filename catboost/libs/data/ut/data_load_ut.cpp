@@ -1,4 +1,10 @@
 #include <catboost/libs/data/load_data.h>
+#include <catboost/libs/data/pool_cache.h>
+#include <catboost/libs/quantized_pool/pool.h>
+#include <catboost/libs/quantized_pool/serialization.h>
+#include <catboost/idl/pool/flat/quantized_chunk_t.fbs.h>
+
+#include <contrib/libs/flatbuffers/include/flatbuffers/flatbuffers.h>
 
 #include <library/threading/local_executor/local_executor.h>
 
@@ -8,6 +14,9 @@
 #include <util/random/fast.h>
 #include <util/generic/guid.h>
 #include <util/stream/file.h>
+#include <util/stream/str.h>
+#include <util/system/fs.h>
+#include <util/ysaveload.h>
 
 using namespace std;
 using namespace NCB;
@@ -58,4 +67,128 @@ Y_UNIT_TEST_SUITE(TDataLoadTest) {
             }
         }
     }
+
+    Y_UNIT_TEST(TestPoolCache) {
+        const TString poolFileName = "cached_pool.tsv";
+        const TString cdFileName = "cached_pool.cd";
+        {
+            TOFStream writer(poolFileName);
+            writer << "1\tq1\t0.5\ta\n";
+            writer << "0\tq1\t-1.25\tb\n";
+            writer << "1\tq2\t3\ta\n";
+        }
+        {
+            TOFStream writer(cdFileName);
+            writer << "0\tTarget\n1\tGroupId\n3\tCateg\n";
+        }
+        NCatboostOptions::TDsvPoolFormatParams dsvPoolFormatParams;
+        dsvPoolFormatParams.CdFilePath = TPathWithScheme(cdFileName, "file");
+        dsvPoolFormatParams.UsePoolCache = true;
+        const TPathWithScheme poolPath(poolFileName, "dsv");
+        const TString cachePath = GetPoolCachePath(poolPath);
+        NFs::Remove(cachePath);
+
+        TPool pool;
+        ReadPool(poolPath, TPathWithScheme(), dsvPoolFormatParams, /*ignoredFeatures*/ {}, 2, false, TVector<TString>(), &pool);
+        UNIT_ASSERT(NFs::Exists(cachePath));
+
+        TPool cachedPool;
+        const TPoolCacheKey key = MakePoolCacheKey(poolPath, TPathWithScheme(), dsvPoolFormatParams, {}, {});
+        UNIT_ASSERT(TryLoadPoolCache(cachePath, key, &cachedPool));
+        UNIT_ASSERT(cachedPool == pool);
+        UNIT_ASSERT(cachedPool.Docs.QueryId == pool.Docs.QueryId);
+        UNIT_ASSERT_VALUES_EQUAL(cachedPool.MetaInfo.FeatureCount, pool.MetaInfo.FeatureCount);
+        UNIT_ASSERT(cachedPool.MetaInfo.HasGroupId);
+        UNIT_ASSERT_VALUES_EQUAL(cachedPool.MetaInfo.ColumnsInfo->Columns.size(), 4);
+
+        TPool loadedAgainPool;
+        ReadPool(poolPath, TPathWithScheme(), dsvPoolFormatParams, /*ignoredFeatures*/ {}, 2, false, TVector<TString>(), &loadedAgainPool);
+        UNIT_ASSERT(loadedAgainPool == pool);
+
+        const TPoolCacheKey otherKey = MakePoolCacheKey(poolPath, TPathWithScheme(), dsvPoolFormatParams, /*ignoredFeatures*/ {0}, {});
+        TPool outdatedPool;
+        UNIT_ASSERT(!TryLoadPoolCache(cachePath, otherKey, &outdatedPool));
+
+        // sizes in corrupted cache are huge, so vectors can't be allocated
+        {
+            TStringStream header;
+            ::SaveMany(&header, ui64(0), ui32(0), key); // magic, version and key
+            TString cache = TIFStream(cachePath).ReadAll();
+            UNIT_ASSERT(header.Size() < cache.size());
+            char* cacheData = cache.begin();
+            std::fill(cacheData + header.Size(), cacheData + cache.size(), '\xff');
+            TOFStream(cachePath).Write(cache);
+        }
+        TPool corruptedPool;
+        UNIT_ASSERT(!TryLoadPoolCache(cachePath, key, &corruptedPool));
+    }
+
+    Y_UNIT_TEST(TestReadQuantizedPool) {
+        static const ui8 bins[] = {2, 0, 3};
+        static const float labels[] = {1, 0, 1};
+        TVector<TBlob> blobs;
+        {
+            flatbuffers::FlatBufferBuilder builder;
+            builder.Finish(NCB::NIdl::CreateTQuantizedFeatureChunk(
+                builder,
+                NCB::NIdl::EBitsPerDocumentFeature_BPDF_8,
+                builder.CreateVector(bins, Y_ARRAY_SIZE(bins))));
+            blobs.push_back(TBlob::Copy(builder.GetBufferPointer(), builder.GetSize()));
+        }
+        {
+            flatbuffers::FlatBufferBuilder builder;
+            builder.Finish(NCB::NIdl::CreateTQuantizedFeatureChunk(
+                builder,
+                NCB::NIdl::EBitsPerDocumentFeature_BPDF_32,
+                builder.CreateVector(reinterpret_cast<const ui8*>(labels), sizeof(labels))));
+            blobs.push_back(TBlob::Copy(builder.GetBufferPointer(), builder.GetSize()));
+        }
+
+        NCB::TQuantizedPool quantizedPool;
+        quantizedPool.Blobs = std::move(blobs);
+        quantizedPool.ColumnIndexToLocalIndex.emplace(0, 0);
+        quantizedPool.ColumnIndexToLocalIndex.emplace(1, 1);
+        // constant feature has neither quantization schema nor chunks
+        quantizedPool.ColumnIndexToLocalIndex.emplace(2, 2);
+        quantizedPool.ColumnTypes = {EColumn::Num, EColumn::Label, EColumn::Num};
+        quantizedPool.DocumentCount = 3;
+        {
+            NCB::NIdl::TFeatureQuantizationSchema featureSchema;
+            featureSchema.AddBorders(0.25);
+            featureSchema.AddBorders(0.5);
+            featureSchema.AddBorders(0.75);
+            quantizedPool.QuantizationSchema.MutableColumnIndexToSchema()->insert({0, std::move(featureSchema)});
+        }
+        for (const auto& blob : quantizedPool.Blobs) {
+            TVector<NCB::TQuantizedPool::TChunkDescription> chunks;
+            chunks.emplace_back(0, 3, flatbuffers::GetRoot<NCB::NIdl::TQuantizedFeatureChunk>(blob.AsCharPtr()));
+            quantizedPool.Chunks.push_back(std::move(chunks));
+        }
+        quantizedPool.Chunks.emplace_back();
+
+        const TString poolFileName = "quantized_pool.bin";
+        {
+            TOFStream output(poolFileName);
+            NCB::SaveQuantizedPool(quantizedPool, &output);
+        }
+
+        TPool pool;
+        ReadPool(TPathWithScheme(poolFileName, "quantized"), TPathWithScheme(), NCatboostOptions::TDsvPoolFormatParams(), /*ignoredFeatures*/ {}, 2, false, TVector<TString>(), &pool);
+
+        UNIT_ASSERT_VALUES_EQUAL(pool.Docs.GetDocCount(), 3);
+        UNIT_ASSERT_VALUES_EQUAL(pool.Docs.GetEffectiveFactorCount(), 2);
+        UNIT_ASSERT(pool.Docs.Factors[0].empty());
+        const auto& quantizedFactor = pool.Docs.QuantizedFactors.at(0);
+        UNIT_ASSERT(quantizedFactor.Borders == TVector<float>({0.25f, 0.5f, 0.75f}));
+        // nan mode of constant feature matches any nan_mode of training
+        const auto& constFactor = pool.Docs.QuantizedFactors.at(1);
+        UNIT_ASSERT(constFactor.Borders.empty());
+        UNIT_ASSERT_EQUAL(constFactor.NanMode, ENanMode::Forbidden);
+        UNIT_ASSERT_VALUES_EQUAL(constFactor.Bins.size(), 0);
+        UNIT_ASSERT_VALUES_EQUAL(quantizedFactor.Bins.size(), 3);
+        for (size_t docIdx = 0; docIdx < Y_ARRAY_SIZE(bins); ++docIdx) {
+            UNIT_ASSERT_VALUES_EQUAL(quantizedFactor.Bins[docIdx], bins[docIdx]);
+            UNIT_ASSERT_VALUES_EQUAL(pool.Docs.Target[docIdx], labels[docIdx]);
+        }
+    }
 }
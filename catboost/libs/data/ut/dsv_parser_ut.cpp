@@ -0,0 +1,67 @@
+#include <catboost/libs/data/dsv_parser.h>
+
+#include <library/unittest/registar.h>
+
+#include <util/generic/vector.h>
+#include <util/random/fast.h>
+#include <util/string/cast.h>
+#include <util/string/iterator.h>
+#include <util/string/split.h>
+
+#include <cstring>
+
+using namespace NCB;
+
+Y_UNIT_TEST_SUITE(TDsvParserTest) {
+    Y_UNIT_TEST(TestTokenizer) {
+        const TStringBuf lines[] = {"", "a", "a\tb", "\t", "a\t\tb\t", "\t\tlast"};
+        for (const auto& line : lines) {
+            const TVector<TStringBuf> expected = StringSplitter(line).Split('\t').ToList<TStringBuf>();
+            TDsvLineTokenizer tokenizer(line, '\t');
+            UNIT_ASSERT_VALUES_EQUAL(tokenizer.CountRest(), expected.size());
+            TVector<TStringBuf> tokens;
+            TStringBuf token;
+            while (tokenizer.Next(&token)) {
+                tokens.push_back(token);
+            }
+            UNIT_ASSERT_EQUAL(tokens, expected);
+        }
+    }
+
+    Y_UNIT_TEST(TestParseSameAsFromString) {
+        const TStringBuf values[] = {
+            "0", "-0", "1", "0.1", "-3.25", "123456789.123456789", "1e10", "1.5E-7", "2e+22", "1e23",
+            "9007199254740993", "0.30000000000000004", "nan", "inf", "-inf", "", "-", "1.", ".5", "1e", "0x1p3", " 1", "1 ", "abc"
+        };
+        for (const auto& value : values) {
+            double parsedDouble = 0;
+            double expectedDouble = 0;
+            const bool isDoubleParsed = TryParseDouble(value, &parsedDouble);
+            UNIT_ASSERT_VALUES_EQUAL(isDoubleParsed, TryFromString<double>(value, expectedDouble));
+            if (isDoubleParsed) {
+                UNIT_ASSERT(memcmp(&parsedDouble, &expectedDouble, sizeof(double)) == 0 || (parsedDouble != parsedDouble && expectedDouble != expectedDouble));
+            }
+            float parsedFloat = 0;
+            float expectedFloat = 0;
+            const bool isFloatParsed = TryParseFloat(value, &parsedFloat);
+            UNIT_ASSERT_VALUES_EQUAL(isFloatParsed, TryFromString<float>(value, expectedFloat));
+            if (isFloatParsed) {
+                UNIT_ASSERT(memcmp(&parsedFloat, &expectedFloat, sizeof(float)) == 0 || (parsedFloat != parsedFloat && expectedFloat != expectedFloat));
+            }
+        }
+    }
+
+    Y_UNIT_TEST(TestParseRandomValues) {
+        TReallyFastRng32 rng(0);
+        for (int i = 0; i < 100000; ++i) {
+            const TString value = ToString((rng.GenRandReal1() - 0.5) * (1 << rng.Uniform(30)));
+            UNIT_ASSERT_VALUES_EQUAL(ParseFloat(value), FromString<float>(value));
+            UNIT_ASSERT_VALUES_EQUAL(ParseDouble(value), FromString<double>(value));
+        }
+    }
+
+    Y_UNIT_TEST(TestParseError) {
+        UNIT_ASSERT_EXCEPTION(ParseFloat("1,5"), TFromStringException);
+        UNIT_ASSERT_EXCEPTION(ParseDouble(""), TFromStringException);
+    }
+}
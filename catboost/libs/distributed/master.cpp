@@ -29,6 +29,25 @@ static TVector<TVector<TData>> GetWorkerPart(const TVector<TVector<TData>>& mast
     return workerPart;
 }
 
+static TVector<TPackedBins> GetWorkerPart(const TVector<TPackedBins>& masterTable, const std::pair<size_t, size_t>& part) {
+    TVector<TPackedBins> workerPart;
+    workerPart.reserve(masterTable.ysize());
+    TVector<ui8> values;
+    for (const auto& masterColumn : masterTable) {
+        const size_t columnSize = masterColumn.size();
+        if (part.first >= columnSize) {
+            workerPart.emplace_back();
+            continue;
+        }
+        const size_t partSize = Min(part.second, columnSize) - part.first;
+        values.yresize(partSize);
+        masterColumn.Unpack(part.first, part.first + partSize, values.data());
+        workerPart.emplace_back(partSize, masterColumn.GetBitsPerValue());
+        workerPart.back().Pack(values.data(), 0, partSize);
+    }
+    return workerPart;
+}
+
 static TAllFeatures GetWorkerPart(const TAllFeatures& allFeatures, const std::pair<size_t, size_t>& part) {
     TAllFeatures workerPart;
     workerPart.FloatHistograms = GetWorkerPart(allFeatures.FloatHistograms, part);
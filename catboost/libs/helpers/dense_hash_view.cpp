@@ -1 +1,97 @@
 #include "dense_hash_view.h"
+
+#include <util/random/fast.h>
+
+namespace NCatboost {
+    namespace {
+        constexpr size_t CuckooMaxKickCount = 500;
+        constexpr double CuckooMaxLoadFactor = 0.8;
+
+        bool TryPlaceToGroup(TBucketGroup* group, ui64 hash, ui32 indexValue) {
+            for (size_t slot = 0; slot < TBucketGroup::SlotCount; ++slot) {
+                if (group->Hashes[slot] == TBucket::InvalidHashValue) {
+                    group->Hashes[slot] = hash;
+                    group->IndexValues[slot] = indexValue;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool TryBuildCuckooIndex(TConstArrayRef<TBucket> buckets, TBucketGroups* groups) {
+            const ui64 groupMask = groups->size() - 1;
+            TBucketGroup emptyGroup;
+            std::fill(std::begin(emptyGroup.Hashes), std::end(emptyGroup.Hashes), TBucket::InvalidHashValue);
+            std::fill(std::begin(emptyGroup.IndexValues), std::end(emptyGroup.IndexValues), TCuckooIndexHashView::NotFoundIndex);
+            emptyGroup.HasDisplacedHashes = 0;
+            std::fill(groups->begin(), groups->end(), emptyGroup);
+            TFastRng64 rng(groups->size());
+            for (const auto& bucket : buckets) {
+                if (bucket.Hash == TBucket::InvalidHashValue) {
+                    continue;
+                }
+                ui64 hash = bucket.Hash;
+                ui32 indexValue = bucket.IndexValue;
+                bool placed = false;
+                for (size_t kick = 0; kick < CuckooMaxKickCount && !placed; ++kick) {
+                    const ui64 firstGroupIdx = TCuckooIndexHashView::GetFirstGroupIdx(hash, groupMask);
+                    const ui64 secondGroupIdx = TCuckooIndexHashView::GetSecondGroupIdx(hash, groupMask);
+                    placed = TryPlaceToGroup(&(*groups)[firstGroupIdx], hash, indexValue) ||
+                             TryPlaceToGroup(&(*groups)[secondGroupIdx], hash, indexValue);
+                    if (!placed) {
+                        // both groups are full: evict random slot, evicted hash moves to its other group
+                        auto& group = (*groups)[rng.Uniform(2) ? firstGroupIdx : secondGroupIdx];
+                        const size_t slot = rng.Uniform(TBucketGroup::SlotCount);
+                        std::swap(group.Hashes[slot], hash);
+                        std::swap(group.IndexValues[slot], indexValue);
+                    }
+                }
+                if (!placed) {
+                    return false;
+                }
+            }
+            for (ui64 groupIdx = 0; groupIdx <= groupMask; ++groupIdx) {
+                for (size_t slot = 0; slot < TBucketGroup::SlotCount; ++slot) {
+                    const ui64 hash = (*groups)[groupIdx].Hashes[slot];
+                    const ui64 firstGroupIdx = TCuckooIndexHashView::GetFirstGroupIdx(hash, groupMask);
+                    if (hash != TBucket::InvalidHashValue && firstGroupIdx != groupIdx) {
+                        (*groups)[firstGroupIdx].HasDisplacedHashes = 1;
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    TBucketGroups BuildCuckooIndex(TConstArrayRef<TBucket> buckets) {
+        size_t valueCount = 0;
+        for (const auto& bucket : buckets) {
+            valueCount += bucket.Hash != TBucket::InvalidHashValue;
+        }
+        size_t groupCount = FastClp2(static_cast<size_t>(valueCount / (TBucketGroup::SlotCount * CuckooMaxLoadFactor)) + 1);
+        TBucketGroups groups(groupCount);
+        while (!TryBuildCuckooIndex(buckets, &groups)) {
+            groups.resize(groups.size() * 2);
+        }
+        return groups;
+    }
+
+    TVector<TBucket> BuildLinearProbingIndex(TConstArrayRef<TBucketGroup> groups) {
+        size_t valueCount = 0;
+        for (const auto& group : groups) {
+            for (size_t slot = 0; slot < TBucketGroup::SlotCount; ++slot) {
+                valueCount += group.Hashes[slot] != TBucket::InvalidHashValue;
+            }
+        }
+        TVector<TBucket> buckets(TDenseIndexHashBuilder::GetProperBucketsCount(valueCount));
+        TDenseIndexHashBuilder builder(buckets);
+        for (const auto& group : groups) {
+            for (size_t slot = 0; slot < TBucketGroup::SlotCount; ++slot) {
+                if (group.Hashes[slot] != TBucket::InvalidHashValue) {
+                    builder.SetIndex(group.Hashes[slot], group.IndexValues[slot]);
+                }
+            }
+        }
+        return buckets;
+    }
+}
@@ -1,7 +1,13 @@
 #pragma once
 
 #include <util/generic/array_ref.h>
+#include <util/generic/vector.h>
 #include <util/digest/numeric.h>
+#include <util/system/align.h>
+#include <util/system/compiler.h>
+
+#include <cstring>
+#include <new>
 
 namespace NCatboost {
 
@@ -43,14 +49,184 @@ namespace NCatboost {
             return NotFoundIndex;
         }
 
+        //! Count of lookups ahead whose home buckets are prefetched by GetIndexes
+        static constexpr size_t PrefetchDistance = 16;
+
+        /**
+         * Batched GetIndex: result[i] = GetIndex(hashes[i]).
+         * Home buckets are prefetched PrefetchDistance lookups ahead, so cache misses of independent lookups
+         * overlap instead of being paid one by one, which dominates lookup time for tables larger than cache.
+         */
+        void GetIndexes(TConstArrayRef<ui64> hashes, TArrayRef<ui32> result) const {
+            Y_ASSERT(hashes.size() <= result.size());
+            const size_t count = hashes.size();
+            for (size_t i = 0; i < Min(count, PrefetchDistance); ++i) {
+                PrefetchHomeBucket(hashes[i]);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (i + PrefetchDistance < count) {
+                    PrefetchHomeBucket(hashes[i + PrefetchDistance]);
+                }
+                result[i] = GetIndex(hashes[i]);
+            }
+        }
+
         const TConstArrayRef<TBucket> GetBuckets() const {
             return Buckets;
         }
     private:
+        void PrefetchHomeBucket(ui64 hash) const {
+            const char* bucket = reinterpret_cast<const char*>(Buckets.data() + (hash & HashMask));
+            Y_PREFETCH_READ(bucket, 3);
+            // packed bucket may cross cache line boundary
+            Y_PREFETCH_READ(bucket + sizeof(TBucket) - 1, 3);
+        }
+
         ui64 HashMask = 0;
         TConstArrayRef<TBucket> Buckets;
     };
 
+#pragma pack(push, 1)
+    //! Cache line sized group of bucketized cuckoo hash, hashes and values are stored separately to compare all slots in one pass
+    struct TBucketGroup {
+        static constexpr size_t SlotCount = 5;
+        ui64 Hashes[SlotCount];
+        ui32 IndexValues[SlotCount];
+        //! Nonzero if some hash with this group as first candidate is stored in its second group
+        ui32 HasDisplacedHashes;
+    };
+#pragma pack(pop)
+
+    //! Allocator of cache line aligned storage, start of allocation is stored right before returned block
+    template <class T>
+    class TCacheLineAlignedAllocator {
+    public:
+        using value_type = T;
+        static constexpr size_t CacheLineSize = 64;
+
+        TCacheLineAlignedAllocator() noexcept = default;
+
+        template <class U>
+        TCacheLineAlignedAllocator(const TCacheLineAlignedAllocator<U>&) noexcept {
+        }
+
+        T* allocate(size_t count) {
+            char* raw = static_cast<char*>(::operator new(count * sizeof(T) + CacheLineSize + sizeof(void*)));
+            char* aligned = AlignUp(raw + sizeof(void*), CacheLineSize);
+            memcpy(aligned - sizeof(void*), &raw, sizeof(void*));
+            return reinterpret_cast<T*>(aligned);
+        }
+
+        void deallocate(T* ptr, size_t) noexcept {
+            void* raw;
+            memcpy(&raw, reinterpret_cast<char*>(ptr) - sizeof(void*), sizeof(void*));
+            ::operator delete(raw);
+        }
+
+        template <class U>
+        bool operator==(const TCacheLineAlignedAllocator<U>&) const noexcept {
+            return true;
+        }
+
+        template <class U>
+        bool operator!=(const TCacheLineAlignedAllocator<U>&) const noexcept {
+            return false;
+        }
+    };
+
+    using TBucketGroups = TVector<TBucketGroup, TCacheLineAlignedAllocator<TBucketGroup>>;
+
+    inline bool IsCacheLineAligned(const void* ptr) {
+        return reinterpret_cast<uintptr_t>(ptr) % TCacheLineAlignedAllocator<TBucketGroup>::CacheLineSize == 0;
+    }
+
+    /**
+     * Bucketized cuckoo hash index [ui64] -> [ui32]: every hash is stored in one of two candidate groups,
+     * so lookup reads at most two groups of TBucketGroup::SlotCount slots regardless of table load.
+     * Second group is read only if first one has displaced hashes, so most lookups (misses included) read one group.
+     * Empty slots have TBucket::InvalidHashValue hash and NotFoundIndex value.
+     * Groups should be cache line aligned, so every group lookup touches exactly one cache line.
+     */
+    class TCuckooIndexHashView {
+    public:
+        static_assert(sizeof(TBucketGroup) == 64, "Expected sizeof(TBucketGroup) == 64 bytes");
+        static constexpr ui32 NotFoundIndex = 0xffffffffu;
+
+        explicit TCuckooIndexHashView(TConstArrayRef<TBucketGroup> groupsRef)
+            : GroupMask(groupsRef.size() - 1)
+            , Groups(groupsRef)
+        {
+            Y_ENSURE(IsPowerOf2(groupsRef.size()), "Cuckoo hash view must have 2^k groups");
+            Y_ASSERT(IsCacheLineAligned(groupsRef.data()));
+        }
+
+        static ui64 GetFirstGroupIdx(ui64 hash, ui64 groupMask) {
+            return hash & groupMask;
+        }
+
+        static ui64 GetSecondGroupIdx(ui64 hash, ui64 groupMask) {
+            return IntHash(hash) & groupMask;
+        }
+
+        static ui32 FindInGroup(const TBucketGroup& group, ui64 hash) {
+            ui32 result = NotFoundIndex;
+            for (size_t slot = 0; slot < TBucketGroup::SlotCount; ++slot) {
+                result = group.Hashes[slot] == hash ? group.IndexValues[slot] : result;
+            }
+            return result;
+        }
+
+        ui32 GetIndex(ui64 hash) const {
+            const auto& firstGroup = Groups[GetFirstGroupIdx(hash, GroupMask)];
+            const ui32 index = FindInGroup(firstGroup, hash);
+            if (index != NotFoundIndex || !firstGroup.HasDisplacedHashes) {
+                return index;
+            }
+            return FindInGroup(Groups[GetSecondGroupIdx(hash, GroupMask)], hash);
+        }
+
+        //! Batched GetIndex, first candidate groups are prefetched as in TDenseIndexHashView::GetIndexes
+        void GetIndexes(TConstArrayRef<ui64> hashes, TArrayRef<ui32> result) const {
+            Y_ASSERT(hashes.size() <= result.size());
+            const size_t count = hashes.size();
+            for (size_t i = 0; i < Min(count, TDenseIndexHashView::PrefetchDistance); ++i) {
+                PrefetchFirstGroup(hashes[i]);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (i + TDenseIndexHashView::PrefetchDistance < count) {
+                    PrefetchFirstGroup(hashes[i + TDenseIndexHashView::PrefetchDistance]);
+                }
+                result[i] = GetIndex(hashes[i]);
+            }
+        }
+
+        size_t GetGroupCount() const {
+            return Groups.size();
+        }
+
+        const TConstArrayRef<TBucketGroup> GetGroups() const {
+            return Groups;
+        }
+
+    private:
+        void PrefetchFirstGroup(ui64 hash) const {
+            const char* group = reinterpret_cast<const char*>(Groups.data() + GetFirstGroupIdx(hash, GroupMask));
+            Y_PREFETCH_READ(group, 3);
+        }
+
+        ui64 GroupMask = 0;
+        TConstArrayRef<TBucketGroup> Groups;
+    };
+
+    /**
+     * Builds cuckoo index with the same hash -> index mapping as linear probing buckets.
+     * Group count is grown until all hashes are placed, load factor is kept below 0.8.
+     */
+    TBucketGroups BuildCuckooIndex(TConstArrayRef<TBucket> buckets);
+
+    //! Inverse of BuildCuckooIndex, linear probing buckets are sized by TDenseIndexHashBuilder::GetProperBucketsCount
+    TVector<TBucket> BuildLinearProbingIndex(TConstArrayRef<TBucketGroup> groups);
+
     class TDenseIndexHashBuilder {
     public:
         static_assert(sizeof(TBucket) == 12, "Expected sizeof(TBucket) == 12 bytes");
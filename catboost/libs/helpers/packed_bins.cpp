@@ -0,0 +1,46 @@
+#include "packed_bins.h"
+
+#include <library/threading/local_executor/local_executor.h>
+
+#include <util/generic/utility.h>
+
+void TPackedBins::PackAt(size_t begin, TConstArrayRef<ui8> values) {
+    const size_t end = begin + values.size();
+    Y_ASSERT(end <= Size);
+    const size_t valuesPerByte = GetValuesPerByte();
+    size_t valueIdx = begin;
+    for (; valueIdx < end && valueIdx % valuesPerByte != 0; ++valueIdx) {
+        SetValue(valueIdx, values[valueIdx - begin]);
+    }
+    for (; valueIdx + valuesPerByte <= end; valueIdx += valuesPerByte) {
+        ui8 packed = 0;
+        for (size_t i = 0; i < valuesPerByte; ++i) {
+            Y_ASSERT(values[valueIdx - begin + i] <= ValueMask);
+            packed |= values[valueIdx - begin + i] << (i << BitsPerValueLog2);
+        }
+        Data[valueIdx / valuesPerByte] = packed;
+    }
+    for (; valueIdx < end; ++valueIdx) {
+        SetValue(valueIdx, values[valueIdx - begin]);
+    }
+}
+
+void TPackedBins::Unpack(size_t begin, size_t end, ui8* dst) const {
+    Y_ASSERT(begin <= end && end <= Size);
+    for (size_t idx = begin; idx < end; ++idx) {
+        dst[idx - begin] = (*this)[idx];
+    }
+}
+
+TPackedBins PackBins(TConstArrayRef<ui8> values, ui32 bitsPerValue, NPar::TLocalExecutor* localExecutor) {
+    constexpr size_t blockSize = 1 << 16; // multiple of values per byte for any bits per value
+    TPackedBins bins(values.size(), bitsPerValue);
+    const size_t blockCount = (values.size() + blockSize - 1) / blockSize;
+    if (blockCount > 0) {
+        localExecutor->ExecRange([&](int blockIdx) {
+            const size_t blockStart = blockIdx * blockSize;
+            bins.Pack(values.data(), blockStart, Min(values.size(), blockStart + blockSize));
+        }, 0, blockCount, NPar::TLocalExecutor::WAIT_COMPLETE);
+    }
+    return bins;
+}
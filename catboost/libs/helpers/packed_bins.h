@@ -0,0 +1,115 @@
+#pragma once
+
+#include <library/binsaver/bin_saver.h>
+
+#include <util/generic/array_ref.h>
+#include <util/generic/vector.h>
+#include <util/system/yassert.h>
+
+namespace NPar {
+    class TLocalExecutor;
+}
+
+//! Array of small bin values stored by 1, 2, 4 or 8 bits per value
+class TPackedBins {
+public:
+    TPackedBins() = default;
+
+    //! Zero filled bins
+    TPackedBins(size_t size, ui32 bitsPerValue)
+        : Size(size)
+        , BitsPerValueLog2(GetBitsPerValueLog2(bitsPerValue))
+        , ValueMask(static_cast<ui8>((1u << bitsPerValue) - 1))
+    {
+        Data.resize(GetByteCount(size));
+    }
+
+    //! Minimal supported bits count for values in [0, maxValue]
+    static ui32 GetBitsPerValue(ui32 maxValue) {
+        Y_VERIFY(maxValue < 256);
+        ui32 bitsPerValue = 1;
+        while ((1u << bitsPerValue) <= maxValue) {
+            bitsPerValue *= 2;
+        }
+        return bitsPerValue;
+    }
+
+    ui8 operator[](size_t idx) const {
+        Y_ASSERT(idx < Size);
+        const ui32 valuesPerByteLog2 = 3 - BitsPerValueLog2;
+        const ui32 shift = (idx & ((1u << valuesPerByteLog2) - 1)) << BitsPerValueLog2;
+        return (Data[idx >> valuesPerByteLog2] >> shift) & ValueMask;
+    }
+
+    /**
+     * Pack values[begin, end) into bins.
+     * Ranges with bounds at multiples of GetValuesPerByte() don't share bytes, so they can be packed concurrently.
+     */
+    void Pack(const ui8* values, size_t begin, size_t end) {
+        PackAt(begin, MakeArrayRef(values + begin, end - begin));
+    }
+
+    //! Pack values into bins[begin, begin + values.size()), bins sharing bytes with the range are kept
+    void PackAt(size_t begin, TConstArrayRef<ui8> values);
+
+    //! Unpack bins[begin, end) into dst
+    void Unpack(size_t begin, size_t end, ui8* dst) const;
+
+    size_t GetValuesPerByte() const {
+        return 8 >> BitsPerValueLog2;
+    }
+
+    ui32 GetBitsPerValue() const {
+        return 1u << BitsPerValueLog2;
+    }
+
+    size_t size() const {
+        return Size;
+    }
+
+    bool empty() const {
+        return Size == 0;
+    }
+
+    size_t GetMemoryUsage() const {
+        return Data.capacity();
+    }
+
+    bool operator==(const TPackedBins& rhs) const {
+        return Size == rhs.Size && BitsPerValueLog2 == rhs.BitsPerValueLog2 && Data == rhs.Data;
+    }
+
+    SAVELOAD(Data, Size, BitsPerValueLog2, ValueMask);
+
+private:
+    static ui8 GetBitsPerValueLog2(ui32 bitsPerValue) {
+        Y_VERIFY(bitsPerValue == 1 || bitsPerValue == 2 || bitsPerValue == 4 || bitsPerValue == 8, "Unsupported bits per value %u", bitsPerValue);
+        ui8 bitsPerValueLog2 = 0;
+        while ((1u << bitsPerValueLog2) < bitsPerValue) {
+            ++bitsPerValueLog2;
+        }
+        return bitsPerValueLog2;
+    }
+
+    void SetValue(size_t idx, ui8 value) {
+        Y_ASSERT(value <= ValueMask);
+        const ui32 valuesPerByteLog2 = 3 - BitsPerValueLog2;
+        const ui32 shift = (idx & ((1u << valuesPerByteLog2) - 1)) << BitsPerValueLog2;
+        ui8& byte = Data[idx >> valuesPerByteLog2];
+        byte = static_cast<ui8>((byte & ~(ValueMask << shift)) | (value << shift));
+    }
+
+    size_t GetByteCount(size_t valueCount) const {
+        const size_t valuesPerByte = GetValuesPerByte();
+        return (valueCount + valuesPerByte - 1) / valuesPerByte;
+    }
+
+private:
+    TVector<ui8> Data;
+    size_t Size = 0;
+    ui8 BitsPerValueLog2 = 3;
+    ui8 ValueMask = 0xff;
+};
+
+//! Pack values by bitsPerValue bits in parallel blocks
+TPackedBins PackBins(TConstArrayRef<ui8> values, ui32 bitsPerValue, NPar::TLocalExecutor* localExecutor);
@@ -18,6 +18,19 @@ static inline void ApplyPermutation(const TVector<ui64>& permutation, TVector<TD
     }
 }
 
+static void ApplyPermutation(const TVector<ui64>& permutation, TPackedBins* bins) {
+    if (bins->empty()) {
+        return;
+    }
+    TVector<ui8> permutedValues(bins->size());
+    for (ui64 elementIdx = 0; elementIdx < bins->size(); ++elementIdx) {
+        permutedValues[permutation[elementIdx]] = (*bins)[elementIdx];
+    }
+    TPackedBins permutedBins(bins->size(), bins->GetBitsPerValue());
+    permutedBins.Pack(permutedValues.data(), 0, permutedValues.size());
+    *bins = std::move(permutedBins);
+}
+
 void ApplyPermutationToPairs(const TVector<ui64>& permutation, TVector<TPair>* pairs) {
     for (auto& pair : *pairs) {
         pair.WinnerId = permutation[pair.WinnerId];
@@ -34,6 +47,14 @@ void ApplyPermutation(const TVector<ui64>& permutation, TPool* pool, NPar::TLoca
             ApplyPermutation(permutation, &pool->Docs.Factors[factorIdx]);
         }, blockParams, NPar::TLocalExecutor::WAIT_COMPLETE);
 
+        TVector<TPackedBins*> quantizedFactorBins;
+        for (auto& quantizedFactor : pool->Docs.QuantizedFactors) {
+            quantizedFactorBins.push_back(&quantizedFactor.second.Bins);
+        }
+        localExecutor->ExecRange([&] (int quantizedFactorIdx) {
+            ApplyPermutation(permutation, quantizedFactorBins[quantizedFactorIdx]);
+        }, 0, quantizedFactorBins.ysize(), NPar::TLocalExecutor::WAIT_COMPLETE);
+
         for (int dim = 0; dim < pool->Docs.GetBaselineDimension(); ++dim) {
             ApplyPermutation(permutation, &pool->Docs.Baseline[dim]);
         }
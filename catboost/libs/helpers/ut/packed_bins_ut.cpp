@@ -0,0 +1,98 @@
+#include <catboost/libs/helpers/packed_bins.h>
+
+#include <library/binsaver/mem_io.h>
+#include <library/threading/local_executor/local_executor.h>
+#include <library/unittest/registar.h>
+
+#include <util/random/fast.h>
+
+static TVector<ui8> GenerateValues(size_t size, ui32 bitsPerValue, TFastRng64& rng) {
+    TVector<ui8> values(size);
+    for (auto& value : values) {
+        value = rng.Uniform(1u << bitsPerValue);
+    }
+    return values;
+}
+
+static TVector<ui8> UnpackAll(const TPackedBins& bins) {
+    TVector<ui8> values(bins.size());
+    bins.Unpack(0, bins.size(), values.data());
+    return values;
+}
+
+Y_UNIT_TEST_SUITE(TPackedBinsTest) {
+    Y_UNIT_TEST(TestPackUnpack) {
+        TFastRng64 rng(0);
+        for (ui32 bitsPerValue : {1, 2, 4, 8}) {
+            for (size_t size : {0, 1, 3, 7, 8, 9, 15, 17, 1001}) {
+                const auto values = GenerateValues(size, bitsPerValue, rng);
+                TPackedBins bins(size, bitsPerValue);
+                UNIT_ASSERT_VALUES_EQUAL(bins.GetBitsPerValue(), bitsPerValue);
+                UNIT_ASSERT_VALUES_EQUAL(bins.GetValuesPerByte(), 8 / bitsPerValue);
+                bins.Pack(values.data(), 0, size);
+                UNIT_ASSERT_EQUAL(UnpackAll(bins), values);
+                for (size_t idx = 0; idx < size; ++idx) {
+                    UNIT_ASSERT_VALUES_EQUAL(bins[idx], values[idx]);
+                }
+                if (size > 2) {
+                    TVector<ui8> middle(size - 2);
+                    bins.Unpack(1, size - 1, middle.data());
+                    UNIT_ASSERT_EQUAL(middle, TVector<ui8>(values.begin() + 1, values.end() - 1));
+                }
+            }
+        }
+    }
+
+    Y_UNIT_TEST(TestPackAtUnalignedRanges) {
+        TFastRng64 rng(1);
+        for (ui32 bitsPerValue : {1, 2, 4, 8}) {
+            const size_t size = 1001;
+            const auto values = GenerateValues(size, bitsPerValue, rng);
+            for (size_t rangeSize : {1, 3, 5, 13, 1000}) {
+                // ranges are packed in reverse order, so values of already packed neighbours should be kept
+                TPackedBins bins(size, bitsPerValue);
+                const size_t rangeCount = (size + rangeSize - 1) / rangeSize;
+                for (size_t rangeIdx = rangeCount; rangeIdx > 0; --rangeIdx) {
+                    const size_t begin = (rangeIdx - 1) * rangeSize;
+                    const size_t end = Min(size, begin + rangeSize);
+                    bins.PackAt(begin, MakeArrayRef(values.data() + begin, end - begin));
+                }
+                UNIT_ASSERT_EQUAL(UnpackAll(bins), values);
+            }
+        }
+    }
+
+    Y_UNIT_TEST(TestPackBins) {
+        TFastRng64 rng(2);
+        NPar::TLocalExecutor localExecutor;
+        localExecutor.RunAdditionalThreads(3);
+        for (ui32 bitsPerValue : {1, 2, 4, 8}) {
+            for (size_t size : {0, 5, (1 << 16) + 3, 3 * (1 << 16) + 7}) {
+                const auto values = GenerateValues(size, bitsPerValue, rng);
+                TPackedBins expected(size, bitsPerValue);
+                expected.Pack(values.data(), 0, size);
+                const auto bins = PackBins(values, bitsPerValue, &localExecutor);
+                UNIT_ASSERT(bins == expected);
+                UNIT_ASSERT_EQUAL(UnpackAll(bins), values);
+            }
+        }
+    }
+
+    Y_UNIT_TEST(TestSaveLoad) {
+        TFastRng64 rng(3);
+        for (ui32 bitsPerValue : {1, 2, 4, 8}) {
+            for (size_t size : {0, 1, 7, 9, 1001}) {
+                const auto values = GenerateValues(size, bitsPerValue, rng);
+                TPackedBins bins(size, bitsPerValue);
+                bins.Pack(values.data(), 0, size);
+                TVector<char> buffer;
+                SerializeToMem(&buffer, bins);
+                TPackedBins loaded;
+                SerializeFromMem(&buffer, loaded);
+                UNIT_ASSERT(loaded == bins);
+                UNIT_ASSERT_VALUES_EQUAL(loaded.GetBitsPerValue(), bitsPerValue);
+                UNIT_ASSERT_EQUAL(UnpackAll(loaded), values);
+            }
+        }
+    }
+}
@@ -90,6 +90,12 @@ inline bool DoOutputIteration(int currentIteration, int iterationsCount, int wri
     return currentIteration % writePeriod == 0 || currentIteration == iterationsCount - 1;
 }
 
+inline void OutputThreadUtilization(const TProfileResults& profileResults, IOutputStream* out) {
+    if (profileResults.ThreadUtilization > 0) {
+        *out << "Thread utilization: " << FloatToString(100 * profileResults.ThreadUtilization, PREC_NDIGITS, 3) << "%" << Endl;
+    }
+}
+
 class TJsonLoggingBackend : public ILoggingBackend {
 public:
     explicit TJsonLoggingBackend(const TString& fileName, const NJson::TJsonValue& metaJson, int writePeriod = 1)
@@ -161,6 +167,7 @@ public:
             for (const auto& it : profileResults.OperationToTime) {
                 Stream << it.first << ": " << FloatToString(it.second, PREC_NDIGITS, 3) << " sec" << Endl;
             }
+            OutputThreadUtilization(profileResults, &Stream);
             Stream << "Passed: " << FloatToString(profileResults.CurrentTime, PREC_NDIGITS, 3) << " sec" << Endl;
         }
         if (profileResults.IsIterationGood) {
@@ -195,6 +202,7 @@ public:
         for (const auto& it : profileResults.OperationToTime) {
             Stream << it.first << ": " << FloatToString(it.second, PREC_NDIGITS, 3) << " sec" << Endl;
         }
+        OutputThreadUtilization(profileResults, &Stream);
         Stream << "Passed: " << FloatToString(profileResults.CurrentTime, PREC_NDIGITS, 3) << " sec" << Endl;
         if (profileResults.IsIterationGood) {
             Stream << "\ttotal: " << HumanReadable(TDuration::Seconds(profileResults.PassedTime));
@@ -254,6 +262,9 @@ public:
         for (const auto& it : profileResults.OperationToTime) {
             times[it.first] = it.second;
         }
+        if (profileResults.ThreadUtilization > 0) {
+            CurrentValue["thread_utilization"] = profileResults.ThreadUtilization;
+        }
 
         PassedIterations = profileResults.PassedIterations;
         OperationToTimeInAllIterations = profileResults.OperationToTimeInAllIterations;
@@ -4,6 +4,7 @@
 
 #include <util/ysaveload.h>
 #include <util/generic/map.h>
+#include <util/generic/utility.h>
 #include <util/stream/file.h>
 #include <util/stream/format.h>
 #include <util/system/hp_timer.h>
@@ -16,7 +17,8 @@ struct TProfileResults {
         double currentTime = 0,
         int passedIterations = 0,
         TMap<TString, double> operationToTime = {},
-        TMap<TString, double> operationToTimeInAllIterations = {}
+        TMap<TString, double> operationToTimeInAllIterations = {},
+        double threadUtilization = 0
     )
         : PassedTime(passedTime)
         , RemainingTime(remainingTime)
@@ -25,6 +27,7 @@ struct TProfileResults {
         , PassedIterations(passedIterations)
         , OperationToTime(operationToTime)
         , OperationToTimeInAllIterations(operationToTimeInAllIterations)
+        , ThreadUtilization(threadUtilization)
     {
     }
 
@@ -35,6 +38,7 @@ struct TProfileResults {
     int PassedIterations;
     TMap<TString, double> OperationToTime;
     TMap<TString, double> OperationToTimeInAllIterations;
+    double ThreadUtilization; // share of threads time spent in parallel operations of iteration, 0 if not measured
 };
 
 struct TProfileInfoData {
@@ -90,6 +94,8 @@ public:
         CurrentTime = 0;
         Timer.Reset();
         OperationToTime.clear();
+        ThreadBusyTime = 0;
+        ThreadAvailableTime = 0;
     }
 
     void StartNextIteration() {
@@ -102,6 +108,12 @@ public:
         OperationToTime[operation] += passedTime; // operations can be repeated in one iteration
     }
 
+    // busyTime is the sum of times threads spent working during wallTime of a parallel operation
+    void AddThreadUtilization(double busyTime, double wallTime, int threadCount) {
+        ThreadBusyTime += busyTime;
+        ThreadAvailableTime += wallTime * threadCount;
+    }
+
     void FinishIterationBlock(int blockSize) {
         CurrentTime += Timer.PassedReset();
         double averageTime = ProfileData.PassedIterations == InitIterations + ProfileData.BadIterations ?
@@ -135,7 +147,8 @@ public:
             CurrentTime,
             ProfileData.PassedIterations,
             OperationToTime,
-            ProfileData.OperationToTimeInAllIterations
+            ProfileData.OperationToTimeInAllIterations,
+            ThreadAvailableTime > 0 ? Min(ThreadBusyTime / ThreadAvailableTime, 1.0) : 0.0
         };
     }
 
@@ -150,4 +163,6 @@ private:
     double RemainingTime;
     double LocalPassedTime;
     double CurrentTime;
+    double ThreadBusyTime = 0;
+    double ThreadAvailableTime = 0;
 };
@@ -28,3 +28,36 @@ void TCtrData::Load(IInputStream* s) {
         LearnCtrs[ctrBase] = std::move(table);
     }
 }
+
+void TCtrData::Load(TMemoryInput* in, bool inPlace, NPar::TLocalExecutor* executor) {
+    const size_t cnt = ::LoadSize(in);
+    TVector<TConstArrayRef<ui8>> serializedTables;
+    serializedTables.reserve(cnt);
+    for (size_t i = 0; i != cnt; ++i) {
+        const ui32 size = ::LoadSize(in);
+        CB_ENSURE(in->Avail() >= size, "Unexpected end of ctr data");
+        serializedTables.emplace_back(reinterpret_cast<const ui8*>(in->Buf()), size);
+        in->Skip(size);
+    }
+    TVector<TCtrValueTable> tables(cnt);
+    auto loadTable = [&](int tableIdx) {
+        const auto& serializedTable = serializedTables[tableIdx];
+        if (inPlace) {
+            tables[tableIdx].LoadThin(serializedTable.data(), serializedTable.size());
+        } else {
+            tables[tableIdx].LoadSolid(const_cast<ui8*>(serializedTable.data()), serializedTable.size());
+        }
+    };
+    if (executor && cnt > 1) {
+        executor->ExecRangeWithThrow(loadTable, 0, cnt, NPar::TLocalExecutor::WAIT_COMPLETE);
+    } else {
+        for (size_t i = 0; i != cnt; ++i) {
+            loadTable(i);
+        }
+    }
+    LearnCtrs.reserve(cnt);
+    for (auto& table : tables) {
+        TModelCtrBase ctrBase = table.ModelCtrBase;
+        LearnCtrs[ctrBase] = std::move(table);
+    }
+}
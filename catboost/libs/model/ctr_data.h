@@ -1,6 +1,8 @@
 #pragma once
 
 #include "ctr_value_table.h"
+#include <library/threading/local_executor/local_executor.h>
+#include <util/stream/mem.h>
 #include <util/system/mutex.h>
 #include <util/system/guard.h>
 
@@ -18,6 +20,14 @@ struct TCtrData {
     void Save(IOutputStream* s) const;
 
     void Load(IInputStream* s);
+
+    /**
+     * Load tables from serialized data in memory.
+     * @param in stream over serialized data, positioned at ctr data start
+     * @param inPlace tables reference serialized data (see TCtrValueTable::LoadThin) instead of copying it
+     * @param executor optional executor, tables are deserialized in parallel on its threads
+     */
+    void Load(TMemoryInput* in, bool inPlace, NPar::TLocalExecutor* executor);
 };
 
 struct TCtrDataStreamWriter {
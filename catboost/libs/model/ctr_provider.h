@@ -39,6 +39,11 @@ public:
         throw yexception() << "Deserialization not allowed";
     };
 
+    //! Saved data can be read by models of first format version, otherwise model is saved with current version
+    virtual bool IsLegacyFormatCompatible() const {
+        return true;
+    }
+
     // can use this later for complex model deserialization logic
     virtual TString ModelPartIdentifier() const = 0;
 };
@@ -101,6 +106,60 @@ inline void CalcHashes(
     }
 }
 
+//! One step of projection hash calculation: either cat feature hash or binarized feature check
+struct TProjectionHashStep {
+    bool IsCatFeature = false;
+    int TransposedCatFeatureIndex = 0;
+    TBinFeatureIndexValue BinFeatureIndex;
+
+    bool operator==(const TProjectionHashStep& other) const {
+        if (IsCatFeature != other.IsCatFeature) {
+            return false;
+        }
+        if (IsCatFeature) {
+            return TransposedCatFeatureIndex == other.TransposedCatFeatureIndex;
+        }
+        return BinFeatureIndex.BinIndex == other.BinFeatureIndex.BinIndex &&
+            BinFeatureIndex.CheckValueEqual == other.BinFeatureIndex.CheckValueEqual &&
+            BinFeatureIndex.Value == other.BinFeatureIndex.Value;
+    }
+};
+
+/**
+ * Apply one hash step to hashes of projection prefix, gives same values as CalcHashes for extended projection
+ * @param prefixHashes hashes of projection prefix, nullptr for empty prefix
+ */
+inline void ApplyProjectionHashStep(
+    const TProjectionHashStep& step,
+    const TConstArrayRef<ui8>& binarizedFeatures,
+    const TConstArrayRef<int>& hashedCatFeatures,
+    size_t docCount,
+    const ui64* prefixHashes,
+    ui64* result) {
+    if (prefixHashes == nullptr) {
+        std::fill(result, result + docCount, 0);
+        prefixHashes = result;
+    }
+    if (step.IsCatFeature) {
+        auto valPtr = &hashedCatFeatures[step.TransposedCatFeatureIndex * docCount];
+        for (size_t i = 0; i < docCount; ++i) {
+            result[i] = CalcHash(prefixHashes[i], (ui64)valPtr[i]);
+        }
+        return;
+    }
+    const auto& binFeatureIndex = step.BinFeatureIndex;
+    const ui8* binFPtr = &binarizedFeatures[binFeatureIndex.BinIndex * docCount];
+    if (!binFeatureIndex.CheckValueEqual) {
+        for (size_t i = 0; i < docCount; ++i) {
+            result[i] = CalcHash(prefixHashes[i], (ui64)(binFPtr[i] >= binFeatureIndex.Value));
+        }
+    } else {
+        for (size_t i = 0; i < docCount; ++i) {
+            result[i] = CalcHash(prefixHashes[i], (ui64)(binFPtr[i] == binFeatureIndex.Value));
+        }
+    }
+}
+
 template <typename TFloatFeatureAccessor, typename TCatFeatureAccessor>
 inline void CalcHashes(
     const TFeatureCombination& featureCombination,
@@ -1,41 +1,83 @@
 #include "ctr_value_table.h"
 #include "flatbuffers_serializer_helper.h"
+#include <catboost/libs/helpers/exception.h>
 #include <catboost/libs/model/flatbuffers/model.fbs.h>
 #include <util/stream/input.h>
 #include <util/ysaveload.h>
 
 
+static NCatBoostFbs::ECtrIndexHashLayout ToFbsIndexLayout(ECtrTableIndexLayout layout) {
+    switch (layout) {
+        case ECtrTableIndexLayout::LinearProbing:
+            return NCatBoostFbs::ECtrIndexHashLayout_LinearProbing;
+        case ECtrTableIndexLayout::BucketizedCuckoo:
+            return NCatBoostFbs::ECtrIndexHashLayout_BucketizedCuckoo;
+    }
+    Y_UNREACHABLE();
+}
+
+static ECtrTableIndexLayout FromFbsIndexLayout(NCatBoostFbs::ECtrIndexHashLayout layout) {
+    switch (layout) {
+        case NCatBoostFbs::ECtrIndexHashLayout_LinearProbing:
+            return ECtrTableIndexLayout::LinearProbing;
+        case NCatBoostFbs::ECtrIndexHashLayout_BucketizedCuckoo:
+            return ECtrTableIndexLayout::BucketizedCuckoo;
+    }
+    ythrow TCatboostException() << "Unknown ctr table index layout " << (int)layout << ", model is saved by newer version";
+}
+
+static void LoadPrecomputedCtrs(
+    const flatbuffers::Vector<flatbuffers::Offset<NCatBoostFbs::TPrecomputedCtrValues>>* fbPrecomputedCtrs,
+    size_t indexValueCount,
+    TVector<TPrecomputedCtrValues>* precomputedCtrs) {
+    precomputedCtrs->clear();
+    if (fbPrecomputedCtrs == nullptr) {
+        return;
+    }
+    for (const auto fbPrecomputed : *fbPrecomputedCtrs) {
+        CB_ENSURE(fbPrecomputed != nullptr, "Precomputed ctr values are missing");
+        CB_ENSURE(fbPrecomputed->Ctr() && fbPrecomputed->BinValues() && fbPrecomputed->Bins(),
+                  "Precomputed ctr values are incomplete");
+        // bin of every table index and of missing hashes
+        CB_ENSURE(fbPrecomputed->Bins()->size() == indexValueCount + 1,
+                  "Precomputed ctr values have " << fbPrecomputed->Bins()->size() << " bins, expected " << indexValueCount + 1);
+        TPrecomputedCtrValues precomputed;
+        precomputed.Ctr.FBDeserialize(fbPrecomputed->Ctr());
+        precomputed.BinValues.assign(fbPrecomputed->BinValues()->begin(), fbPrecomputed->BinValues()->end());
+        precomputed.Bins.assign(fbPrecomputed->Bins()->begin(), fbPrecomputed->Bins()->end());
+        precomputedCtrs->push_back(std::move(precomputed));
+    }
+}
+
 void TCtrValueTable::Save(IOutputStream* s) const {
     using namespace flatbuffers;
     using namespace NCatBoostFbs;
     TModelPartsCachingSerializer serializer;
-    if (Impl.Is<TSolidTable>()) {
-        auto& solid = Impl.As<TSolidTable>();
-        auto indexHashOffset = serializer.FlatbufBuilder.CreateVector((const ui8*) solid.IndexBuckets.data(),
-                                                sizeof(NCatboost::TBucket) * solid.IndexBuckets.size());
-        auto ctrBlob = serializer.FlatbufBuilder.CreateVector(solid.CTRBlob);
-        auto ctrValueTable = CreateTCtrValueTable(
-            serializer.FlatbufBuilder,
-            serializer.GetOffset(ModelCtrBase),
-            indexHashOffset,
-            ctrBlob,
-            CounterDenominator,
-            TargetClassesCount);
-        serializer.FlatbufBuilder.Finish(ctrValueTable);
-    } else {
-        auto& thin = Impl.As<TThinTable>();
-        auto indexHashOffset = serializer.FlatbufBuilder.CreateVector((const ui8*) thin.IndexBuckets.data(),
-                                                sizeof(NCatboost::TBucket) * thin.IndexBuckets.size());
-        auto ctrBlob = serializer.FlatbufBuilder.CreateVector(thin.CTRBlob.data(), thin.CTRBlob.size());
-        auto ctrValueTable = CreateTCtrValueTable(
-            serializer.FlatbufBuilder,
-            serializer.GetOffset(ModelCtrBase),
-            indexHashOffset,
-            ctrBlob,
-            CounterDenominator,
-            TargetClassesCount);
-        serializer.FlatbufBuilder.Finish(ctrValueTable);
+    const auto indexRaw = GetIndexRaw();
+    const auto ctrBlobRaw = GetTypedArrayRefForBlobData<ui8>();
+    auto indexHashOffset = serializer.FlatbufBuilder.CreateVector(indexRaw.data(), indexRaw.size());
+    auto ctrBlob = serializer.FlatbufBuilder.CreateVector(ctrBlobRaw.data(), ctrBlobRaw.size());
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<NCatBoostFbs::TPrecomputedCtrValues>>> precomputedCtrsOffset = 0;
+    if (!PrecomputedCtrs.empty()) {
+        std::vector<flatbuffers::Offset<NCatBoostFbs::TPrecomputedCtrValues>> precomputedOffsets;
+        for (const auto& precomputed : PrecomputedCtrs) {
+            auto ctrOffset = serializer.GetOffset(precomputed.Ctr);
+            auto binValuesOffset = serializer.FlatbufBuilder.CreateVector(precomputed.BinValues.data(), precomputed.BinValues.size());
+            auto binsOffset = serializer.FlatbufBuilder.CreateVector(precomputed.Bins.data(), precomputed.Bins.size());
+            precomputedOffsets.push_back(CreateTPrecomputedCtrValues(serializer.FlatbufBuilder, ctrOffset, binValuesOffset, binsOffset));
+        }
+        precomputedCtrsOffset = serializer.FlatbufBuilder.CreateVector(precomputedOffsets);
     }
+    auto ctrValueTable = CreateTCtrValueTable(
+        serializer.FlatbufBuilder,
+        serializer.GetOffset(ModelCtrBase),
+        indexHashOffset,
+        ctrBlob,
+        CounterDenominator,
+        TargetClassesCount,
+        ToFbsIndexLayout(IndexLayout),
+        precomputedCtrsOffset);
+    serializer.FlatbufBuilder.Finish(ctrValueTable);
     SaveSize(s, serializer.FlatbufBuilder.GetSize());
     s->Write(serializer.FlatbufBuilder.GetBufferPointer(), serializer.FlatbufBuilder.GetSize());
 }
@@ -47,18 +89,115 @@ void TCtrValueTable::Load(IInputStream* s) {
     LoadSolid(arrayHolder.Get(), size);
 }
 
+static const NCatBoostFbs::TCtrValueTable* GetVerifiedCtrValueTable(const void* buf, size_t length) {
+    flatbuffers::Verifier verifier(static_cast<const ui8*>(buf), length);
+    CB_ENSURE(NCatBoostFbs::VerifyTCtrValueTableBuffer(verifier), "Flatbuffers ctr value table verification failed");
+    auto ctrValueTable = flatbuffers::GetRoot<NCatBoostFbs::TCtrValueTable>(buf);
+    CB_ENSURE(ctrValueTable->ModelCtrBase() && ctrValueTable->IndexHashRaw() && ctrValueTable->CTRBlob(),
+              "Ctr value table is incomplete");
+    return ctrValueTable;
+}
+
 void TCtrValueTable::LoadSolid(void* buf, size_t length) {
-    Y_UNUSED(length); // TODO(kirillovs): add length validation
     using namespace flatbuffers;
+    auto ctrValueTable = GetVerifiedCtrValueTable(buf, length);
     Impl = TSolidTable();
     auto& solid = Impl.As<TSolidTable>();
-    auto ctrValueTable = flatbuffers::GetRoot<NCatBoostFbs::TCtrValueTable>(buf);
     ModelCtrBase.FBDeserialize(ctrValueTable->ModelCtrBase());
     CounterDenominator = ctrValueTable->CounterDenominator();
     TargetClassesCount = ctrValueTable->TargetClassesCount();
-    solid.IndexBuckets.assign((NCatboost::TBucket*)ctrValueTable->IndexHashRaw()->data(),
-                              (NCatboost::TBucket*)(ctrValueTable->IndexHashRaw()->data() + ctrValueTable->IndexHashRaw()->size()));
+    IndexLayout = FromFbsIndexLayout(ctrValueTable->IndexHashLayout());
+    const ui8* indexHashBegin = ctrValueTable->IndexHashRaw()->data();
+    const ui8* indexHashEnd = indexHashBegin + ctrValueTable->IndexHashRaw()->size();
+    if (IndexLayout == ECtrTableIndexLayout::LinearProbing) {
+        solid.IndexBuckets.assign((const NCatboost::TBucket*)indexHashBegin, (const NCatboost::TBucket*)indexHashEnd);
+    } else {
+        solid.IndexGroups.assign((const NCatboost::TBucketGroup*)indexHashBegin, (const NCatboost::TBucketGroup*)indexHashEnd);
+    }
 
     solid.CTRBlob.assign(ctrValueTable->CTRBlob()->data(),
                          ctrValueTable->CTRBlob()->data() + ctrValueTable->CTRBlob()->size());
+    LoadPrecomputedCtrs(ctrValueTable->PrecomputedCtrs(), GetIndexValueCount(), &PrecomputedCtrs);
+}
+
+void TCtrValueTable::LoadThin(const void* buf, size_t length) {
+    static_assert(alignof(NCatboost::TBucket) == 1, "index buckets are referenced at arbitrary offsets");
+    static_assert(alignof(NCatboost::TBucketGroup) == 1, "index groups alignment is checked at runtime");
+    auto ctrValueTable = GetVerifiedCtrValueTable(buf, length);
+    ModelCtrBase.FBDeserialize(ctrValueTable->ModelCtrBase());
+    CounterDenominator = ctrValueTable->CounterDenominator();
+    TargetClassesCount = ctrValueTable->TargetClassesCount();
+    IndexLayout = FromFbsIndexLayout(ctrValueTable->IndexHashLayout());
+    Impl = TThinTable();
+    auto& thin = Impl.As<TThinTable>();
+    const ui8* indexHashData = ctrValueTable->IndexHashRaw()->data();
+    const size_t indexHashSize = ctrValueTable->IndexHashRaw()->size();
+    if (IndexLayout == ECtrTableIndexLayout::LinearProbing) {
+        thin.IndexBuckets = MakeArrayRef(
+            reinterpret_cast<const NCatboost::TBucket*>(indexHashData),
+            indexHashSize / sizeof(NCatboost::TBucket));
+    } else {
+        thin.IndexGroups = MakeArrayRef(
+            reinterpret_cast<const NCatboost::TBucketGroup*>(indexHashData),
+            indexHashSize / sizeof(NCatboost::TBucketGroup));
+        if (!NCatboost::IsCacheLineAligned(indexHashData)) {
+            thin.IndexGroupsHolder = MakeAtomicShared<const NCatboost::TBucketGroups>(thin.IndexGroups.begin(), thin.IndexGroups.end());
+            thin.IndexGroups = *thin.IndexGroupsHolder;
+        }
+    }
+    thin.CTRBlob = MakeArrayRef(ctrValueTable->CTRBlob()->data(), ctrValueTable->CTRBlob()->size());
+    LoadPrecomputedCtrs(ctrValueTable->PrecomputedCtrs(), GetIndexValueCount(), &PrecomputedCtrs);
+}
+
+size_t TCtrValueTable::GetIndexValueCount() const {
+    const auto indexRaw = GetIndexRaw();
+    size_t count = 0;
+    if (IndexLayout == ECtrTableIndexLayout::LinearProbing) {
+        const auto buckets = MakeArrayRef(
+            reinterpret_cast<const NCatboost::TBucket*>(indexRaw.data()),
+            indexRaw.size() / sizeof(NCatboost::TBucket));
+        for (const auto& bucket : buckets) {
+            count += bucket.Hash != NCatboost::TBucket::InvalidHashValue;
+        }
+    } else {
+        const auto groups = MakeArrayRef(
+            reinterpret_cast<const NCatboost::TBucketGroup*>(indexRaw.data()),
+            indexRaw.size() / sizeof(NCatboost::TBucketGroup));
+        for (const auto& group : groups) {
+            for (const ui64 hash : group.Hashes) {
+                count += hash != NCatboost::TBucket::InvalidHashValue;
+            }
+        }
+    }
+    return count;
+}
+
+void TCtrValueTable::SetIndexLayout(ECtrTableIndexLayout layout) {
+    if (layout == IndexLayout) {
+        return;
+    }
+    if (Impl.Is<TThinTable>()) {
+        TSolidTable solid;
+        Impl.As<TThinTable>().ToSolidTable(&solid);
+        Impl = std::move(solid);
+    }
+    auto& solid = Impl.As<TSolidTable>();
+    if (layout == ECtrTableIndexLayout::BucketizedCuckoo) {
+        solid.IndexGroups = NCatboost::BuildCuckooIndex(solid.IndexBuckets);
+        solid.IndexBuckets = TVector<NCatboost::TBucket>();
+    } else {
+        solid.IndexBuckets = NCatboost::BuildLinearProbingIndex(solid.IndexGroups);
+        solid.IndexGroups = NCatboost::TBucketGroups();
+    }
+    IndexLayout = layout;
+}
+
+void TCtrValueTable::DropCounters() {
+    CB_ENSURE(!PrecomputedCtrs.empty(), "Ctr counters can be dropped only after ctr values precomputation");
+    if (Impl.Is<TThinTable>()) {
+        TSolidTable solid;
+        Impl.As<TThinTable>().ToSolidTable(&solid);
+        Impl = std::move(solid);
+    }
+    Impl.As<TSolidTable>().CTRBlob = TVector<ui8>();
 }
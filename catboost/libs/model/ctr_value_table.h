@@ -4,34 +4,52 @@
 #include <catboost/libs/model/flatbuffers/ctr_data.fbs.h>
 
 #include <catboost/libs/helpers/dense_hash_view.h>
+#include <catboost/libs/options/enums.h>
+#include <util/generic/ptr.h>
 #include <util/generic/vector.h>
 #include <util/generic/variant.h>
 #include <tuple>
 #include <util/stream/input.h>
 #include <util/stream/output.h>
 
+//! Final values of model ctr for each table index, quantized by ctr feature borders
+struct TPrecomputedCtrValues {
+    TModelCtr Ctr;
+    TVector<float> BinValues; // value of each bin, binarizes back to the same bin
+    TVector<ui8> Bins; // bin of each table index, last one is for missing hashes
+
+    ui8 GetBin(ui32 index) const {
+        return index != NCatboost::TDenseIndexHashView::NotFoundIndex ? Bins[index] : Bins.back();
+    }
+
+    bool operator==(const TPrecomputedCtrValues& other) const {
+        return std::tie(Ctr, BinValues, Bins) == std::tie(other.Ctr, other.BinValues, other.Bins);
+    }
+};
+
 class TCtrValueTable {
+    // only index of current IndexLayout is filled
     struct TSolidTable {
         TVector<NCatboost::TBucket> IndexBuckets;
+        NCatboost::TBucketGroups IndexGroups;
         TVector<ui8> CTRBlob;
-        bool operator==(const TSolidTable& other) const {
-            return std::tie(IndexBuckets, CTRBlob) == std::tie(other.IndexBuckets, other.CTRBlob);
-        }
     };
     struct TThinTable {
         TConstArrayRef<NCatboost::TBucket> IndexBuckets;
+        TConstArrayRef<NCatboost::TBucketGroup> IndexGroups;
         TConstArrayRef<ui8> CTRBlob;
+        //! Aligned copy of index groups which are not cache line aligned in serialized data
+        TAtomicSharedPtr<const NCatboost::TBucketGroups> IndexGroupsHolder;
 
-        bool operator==(const TThinTable& other) const {
-            return std::tie(IndexBuckets, CTRBlob) == std::tie(other.IndexBuckets, other.CTRBlob);
-        }
-
-        void ToSolidTable(TSolidTable* table) {
+        void ToSolidTable(TSolidTable* table) const {
             table->IndexBuckets.assign(IndexBuckets.begin(), IndexBuckets.end());
+            table->IndexGroups.assign(IndexGroups.begin(), IndexGroups.end());
             table->CTRBlob.assign(CTRBlob.begin(), CTRBlob.end());
         }
     };
 public:
+    static constexpr ui32 NotFoundIndex = NCatboost::TDenseIndexHashView::NotFoundIndex;
+    static_assert(NotFoundIndex == NCatboost::TCuckooIndexHashView::NotFoundIndex, "");
 
     TCtrValueTable()
         : Impl(TSolidTable())
@@ -67,6 +85,7 @@ public:
     }
 
     NCatboost::TDenseIndexHashView GetIndexHashViewer() const {
+        Y_ENSURE(IndexLayout == ECtrTableIndexLayout::LinearProbing, "Ctr table index has " << IndexLayout << " layout");
         if (Impl.Is<TSolidTable>()) {
             auto& solid = Impl.As<TSolidTable>();
             return NCatboost::TDenseIndexHashView(solid.IndexBuckets);
@@ -76,7 +95,69 @@ public:
         }
     }
 
+    NCatboost::TCuckooIndexHashView GetCuckooIndexHashViewer() const {
+        Y_ENSURE(IndexLayout == ECtrTableIndexLayout::BucketizedCuckoo, "Ctr table index has " << IndexLayout << " layout");
+        if (Impl.Is<TSolidTable>()) {
+            return NCatboost::TCuckooIndexHashView(Impl.As<TSolidTable>().IndexGroups);
+        } else {
+            return NCatboost::TCuckooIndexHashView(Impl.As<TThinTable>().IndexGroups);
+        }
+    }
+
+    //! Batched index lookup with index of any layout, NotFoundIndex for missing hashes
+    void GetIndexes(TConstArrayRef<ui64> hashes, TArrayRef<ui32> indexes) const {
+        if (IndexLayout == ECtrTableIndexLayout::LinearProbing) {
+            GetIndexHashViewer().GetIndexes(hashes, indexes);
+        } else {
+            GetCuckooIndexHashViewer().GetIndexes(hashes, indexes);
+        }
+    }
+
+    //! Linear probing buckets for index of any layout, used by model exporters
+    TVector<NCatboost::TBucket> GetLinearProbingIndexBuckets() const {
+        if (IndexLayout == ECtrTableIndexLayout::LinearProbing) {
+            const auto buckets = GetIndexHashViewer().GetBuckets();
+            return TVector<NCatboost::TBucket>(buckets.begin(), buckets.end());
+        }
+        return NCatboost::BuildLinearProbingIndex(GetCuckooIndexHashViewer().GetGroups());
+    }
+
+    //! Count of hashes stored in index, table indexes are [0, count)
+    size_t GetIndexValueCount() const;
+
+    const TPrecomputedCtrValues* FindPrecomputedCtrValues(const TModelCtr& ctr) const {
+        for (const auto& precomputed : PrecomputedCtrs) {
+            if (precomputed.Ctr == ctr) {
+                return &precomputed;
+            }
+        }
+        return nullptr;
+    }
+
+    //! Counters are dropped from tables with precomputed values of all used ctrs to shrink the model
+    bool HasCounters() const {
+        return PrecomputedCtrs.empty() || !GetTypedArrayRefForBlobData<ui8>().empty();
+    }
+
+    void DropCounters();
+
+    //! Table can be read by models of first format version: linear probing index and counters
+    bool IsLegacyFormatCompatible() const {
+        return IndexLayout == ECtrTableIndexLayout::LinearProbing && HasCounters();
+    }
+
+    ECtrTableIndexLayout GetIndexLayout() const {
+        return IndexLayout;
+    }
+
+    /**
+     * Rebuild index in given layout, hash to index mapping is preserved.
+     * Table referencing serialized data is copied first.
+     */
+    void SetIndexLayout(ECtrTableIndexLayout layout);
+
     NCatboost::TDenseIndexHashBuilder GetIndexHashBuilder(size_t uniqueValuesCount) {
+        Y_ENSURE(IndexLayout == ECtrTableIndexLayout::LinearProbing, "Ctr table index has " << IndexLayout << " layout");
         auto& solid = Impl.As<TSolidTable>();
         auto bucketCount = NCatboost::TDenseIndexHashBuilder::GetProperBucketsCount(uniqueValuesCount);
         solid.IndexBuckets.resize(bucketCount);
@@ -88,15 +169,50 @@ public:
 
     void LoadSolid(void* buf, size_t length);
 
+    /**
+     * Load table referencing serialized data in place, memory should outlive the table.
+     * Index groups which are not cache line aligned in serialized data are copied.
+     */
+    void LoadThin(const void* buf, size_t length);
+
+    bool IsThin() const {
+        return Impl.Is<TThinTable>();
+    }
+
     bool operator==(const TCtrValueTable& other) const {
-        return std::tie(CounterDenominator, TargetClassesCount, Impl) ==
-               std::tie(other.CounterDenominator, other.TargetClassesCount, other.Impl);
+        // solid and thin tables with the same content are equal
+        return std::tie(CounterDenominator, TargetClassesCount, IndexLayout) ==
+               std::tie(other.CounterDenominator, other.TargetClassesCount, other.IndexLayout) &&
+               PrecomputedCtrs == other.PrecomputedCtrs &&
+               GetIndexRaw() == other.GetIndexRaw() &&
+               GetTypedArrayRefForBlobData<ui8>() == other.GetTypedArrayRefForBlobData<ui8>();
     }
 
 public:
     TModelCtrBase ModelCtrBase;
     int CounterDenominator = 0;
     int TargetClassesCount = 0;
+    TVector<TPrecomputedCtrValues> PrecomputedCtrs;
+private:
+    //! Serialized bytes of index in current layout
+    TConstArrayRef<ui8> GetIndexRaw() const {
+        TConstArrayRef<NCatboost::TBucket> buckets;
+        TConstArrayRef<NCatboost::TBucketGroup> groups;
+        if (Impl.Is<TSolidTable>()) {
+            buckets = Impl.As<TSolidTable>().IndexBuckets;
+            groups = Impl.As<TSolidTable>().IndexGroups;
+        } else {
+            buckets = Impl.As<TThinTable>().IndexBuckets;
+            groups = Impl.As<TThinTable>().IndexGroups;
+        }
+        if (IndexLayout == ECtrTableIndexLayout::LinearProbing) {
+            return MakeArrayRef(reinterpret_cast<const ui8*>(buckets.data()), buckets.size() * sizeof(NCatboost::TBucket));
+        } else {
+            return MakeArrayRef(reinterpret_cast<const ui8*>(groups.data()), groups.size() * sizeof(NCatboost::TBucketGroup));
+        }
+    }
+
 private:
+    ECtrTableIndexLayout IndexLayout = ECtrTableIndexLayout::LinearProbing;
     TVariant<TSolidTable, TThinTable> Impl;
 };
@@ -1,6 +1,8 @@
 #include "formula_evaluator.h"
+#include "formula_evaluator_kernels.h"
 
 #include <util/stream/format.h>
+#include <util/system/cpu_id.h>
 
 #include <emmintrin.h>
 #include <pmmintrin.h>
@@ -28,6 +30,179 @@ void TFeatureCachedTreeEvaluator::Calc(size_t treeStart, size_t treeEnd, TArrayR
 
 constexpr size_t SSE_BLOCK_SIZE = 16;
 
+static void BinarizeFloatsBasic(
+    const float* __restrict values,
+    size_t docCount,
+    TConstArrayRef<float> borders,
+    ui8* __restrict result
+) {
+    const auto docCount8 = (docCount | 0x7) ^ 0x7;
+    for (size_t docId = 0; docId < docCount8; docId += 8) {
+        const float* val = values + docId;
+        ui32 writeVal[2] = {0, 0};
+        for (const auto border : borders) {
+            writeVal[0] += (val[0] > border) + ((val[1] > border) << 8) + ((val[2] > border) << 16) + ((val[3] > border) << 24);
+            writeVal[1] += (val[4] > border) + ((val[5] > border) << 8) + ((val[6] > border) << 16) + ((val[7] > border) << 24);
+        }
+        memcpy(result + docId, writeVal, sizeof(writeVal));
+    }
+    for (size_t docId = docCount8; docId < docCount; ++docId) {
+        const float val = values[docId];
+        for (const auto border : borders) {
+            result[docId] += (ui8)(val > border);
+        }
+    }
+}
+
+static void BinarizeFloatsSse(
+    const float* __restrict values,
+    size_t docCount,
+    TConstArrayRef<float> borders,
+    ui8* __restrict result
+) {
+    const auto docCount16 = (docCount | 0xf) ^ 0xf;
+    const __m128i mask = _mm_set1_epi8(1);
+    for (size_t docId = 0; docId < docCount16; docId += SSE_BLOCK_SIZE) {
+        const __m128 floats0 = _mm_loadu_ps(values + docId + 0);
+        const __m128 floats1 = _mm_loadu_ps(values + docId + 4);
+        const __m128 floats2 = _mm_loadu_ps(values + docId + 8);
+        const __m128 floats3 = _mm_loadu_ps(values + docId + 12);
+        __m128i resultVec = _mm_setzero_si128();
+        for (const auto border : borders) {
+            const __m128 borderVec = _mm_set1_ps(border);
+            const __m128i r0 = _mm_castps_si128(_mm_cmpgt_ps(floats0, borderVec));
+            const __m128i r1 = _mm_castps_si128(_mm_cmpgt_ps(floats1, borderVec));
+            const __m128i r2 = _mm_castps_si128(_mm_cmpgt_ps(floats2, borderVec));
+            const __m128i r3 = _mm_castps_si128(_mm_cmpgt_ps(floats3, borderVec));
+            const __m128i packed = _mm_packs_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+            resultVec = _mm_add_epi8(resultVec, _mm_and_si128(packed, mask));
+        }
+        _mm_storeu_si128((__m128i*)(result + docId), resultVec);
+    }
+    for (size_t docId = docCount16; docId < docCount; ++docId) {
+        const float val = values[docId];
+        for (const auto border : borders) {
+            result[docId] += (ui8)(val > border);
+        }
+    }
+}
+
+static void BinarizeFloatsBinarySearchBasic(
+    const float* __restrict values,
+    size_t docCount,
+    TConstArrayRef<float> borders,
+    ui8* __restrict result
+) {
+    if (borders.empty()) {
+        memset(result, 0, docCount);
+        return;
+    }
+    const float* bordersPtr = borders.data();
+    const auto docCount4 = (docCount | 0x3) ^ 0x3;
+    for (size_t docId = 0; docId < docCount4; docId += 4) {
+        // four independent searches, index arithmetic instead of unpredictable branches
+        const float* val = values + docId;
+        size_t idx0 = 0, idx1 = 0, idx2 = 0, idx3 = 0;
+        size_t n = borders.size();
+        while (n > 1) {
+            const size_t half = n / 2;
+            const float* candidates = bordersPtr + half - 1;
+            idx0 += (val[0] > candidates[idx0]) * half;
+            idx1 += (val[1] > candidates[idx1]) * half;
+            idx2 += (val[2] > candidates[idx2]) * half;
+            idx3 += (val[3] > candidates[idx3]) * half;
+            n -= half;
+        }
+        result[docId + 0] = (ui8)(idx0 + (val[0] > bordersPtr[idx0]));
+        result[docId + 1] = (ui8)(idx1 + (val[1] > bordersPtr[idx1]));
+        result[docId + 2] = (ui8)(idx2 + (val[2] > bordersPtr[idx2]));
+        result[docId + 3] = (ui8)(idx3 + (val[3] > bordersPtr[idx3]));
+    }
+    for (size_t docId = docCount4; docId < docCount; ++docId) {
+        const float val = values[docId];
+        size_t idx = 0;
+        size_t n = borders.size();
+        while (n > 1) {
+            const size_t half = n / 2;
+            idx += (val > bordersPtr[idx + half - 1]) * half;
+            n -= half;
+        }
+        result[docId] = (ui8)(idx + (val > bordersPtr[idx]));
+    }
+}
+
+bool IsFormulaEvaluatorKernelSupported(EFormulaEvaluatorKernel kernel) {
+    switch (kernel) {
+        case EFormulaEvaluatorKernel::Basic:
+            return true;
+        case EFormulaEvaluatorKernel::Sse:
+#ifdef NO_SSE
+            return false;
+#else
+            return true;
+#endif
+        case EFormulaEvaluatorKernel::Avx2:
+            return HasAvx2FormulaEvaluatorKernels() && NX86::CachedHaveAVX() && NX86::CachedHaveAVX2();
+        case EFormulaEvaluatorKernel::Avx512:
+            return HasAvx512FormulaEvaluatorKernels() && NX86::CachedHaveAVX512F() && NX86::CachedHaveAVX512BW();
+    }
+    Y_UNREACHABLE();
+}
+
+EFormulaEvaluatorKernel GetBestFormulaEvaluatorKernel() {
+    static const EFormulaEvaluatorKernel bestKernel = [] {
+        for (auto kernel : {EFormulaEvaluatorKernel::Avx512, EFormulaEvaluatorKernel::Avx2, EFormulaEvaluatorKernel::Sse}) {
+            if (IsFormulaEvaluatorKernelSupported(kernel)) {
+                return kernel;
+            }
+        }
+        return EFormulaEvaluatorKernel::Basic;
+    }();
+    return bestKernel;
+}
+
+size_t GetBinarySearchMinBorderCount(EFormulaEvaluatorKernel kernel) {
+    // crossover points measured with catboost/tools/evaluator_benchmark
+    switch (kernel) {
+        case EFormulaEvaluatorKernel::Basic:
+            return 16;
+        case EFormulaEvaluatorKernel::Sse:
+            return 128;
+        case EFormulaEvaluatorKernel::Avx2:
+            return 96;
+        case EFormulaEvaluatorKernel::Avx512:
+            return 64;
+    }
+    Y_UNREACHABLE();
+}
+
+TBinarizeFloatsKernel GetBinarizeFloatsKernel(EFormulaEvaluatorKernel kernel, EBinarizationMethod method) {
+    CB_ENSURE(IsFormulaEvaluatorKernelSupported(kernel), "Formula evaluator kernel is not supported on this CPU");
+    if (method == EBinarizationMethod::BinarySearch) {
+        switch (kernel) {
+            case EFormulaEvaluatorKernel::Basic:
+            case EFormulaEvaluatorKernel::Sse:
+                return BinarizeFloatsBinarySearchBasic;
+            case EFormulaEvaluatorKernel::Avx2:
+                return BinarizeFloatsBinarySearchAvx2;
+            case EFormulaEvaluatorKernel::Avx512:
+                return BinarizeFloatsBinarySearchAvx512;
+        }
+        Y_UNREACHABLE();
+    }
+    switch (kernel) {
+        case EFormulaEvaluatorKernel::Basic:
+            return BinarizeFloatsBasic;
+        case EFormulaEvaluatorKernel::Sse:
+            return BinarizeFloatsSse;
+        case EFormulaEvaluatorKernel::Avx2:
+            return BinarizeFloatsAvx2;
+        case EFormulaEvaluatorKernel::Avx512:
+            return BinarizeFloatsAvx512;
+    }
+    Y_UNREACHABLE();
+}
+
 template<bool NeedXorMask, size_t START_BLOCK, typename TIndexType>
 Y_FORCE_INLINE void CalcIndexesBasic(
         const ui8* __restrict binFeatures,
@@ -219,6 +394,29 @@ Y_FORCE_INLINE void CalcIndexesSse(
 #undef STORE_16_DOCS_RESULT
 }
 
+template<EFormulaEvaluatorKernel Kernel, bool NeedXorMask, size_t SSEBlockCount>
+Y_FORCE_INLINE void CalcIndexesShallowTree(
+        const ui8* __restrict binFeatures,
+        size_t docCountInBlock,
+        ui8* __restrict indexesVec,
+        const TRepackedBin* __restrict treeSplitsCurPtr,
+        const int curTreeSize) {
+    switch (Kernel) {
+        case EFormulaEvaluatorKernel::Basic:
+            CalcIndexesBasic<NeedXorMask, 0>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
+            break;
+        case EFormulaEvaluatorKernel::Sse:
+            CalcIndexesSse<NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
+            break;
+        case EFormulaEvaluatorKernel::Avx2:
+            CalcIndexesAvx2(NeedXorMask, binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
+            break;
+        case EFormulaEvaluatorKernel::Avx512:
+            CalcIndexesAvx512(NeedXorMask, binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
+            break;
+    }
+}
+
 template<typename TIndexType>
 Y_FORCE_INLINE void CalculateLeafValues(const size_t docCountInBlock, const double* __restrict treeLeafPtr, const TIndexType* __restrict indexesPtr, double* __restrict writePtr) {
     Y_PREFETCH_READ(treeLeafPtr, 3);
@@ -320,7 +518,7 @@ Y_FORCE_INLINE void CalculateLeafValuesMulti(const size_t docCountInBlock, const
     }
 }
 
-template<bool IsSingleClassModel, bool NeedXorMask, int SSEBlockCount>
+template<EFormulaEvaluatorKernel Kernel, bool IsSingleClassModel, bool NeedXorMask, int SSEBlockCount>
 Y_FORCE_INLINE void CalcTreesBlockedImpl(
     const TFullModel& model,
     const ui8* __restrict binFeatures,
@@ -357,13 +555,13 @@ Y_FORCE_INLINE void CalcTreesBlockedImpl(
         auto treeEnd4 = treeStart + (((treeEnd - treeStart) | 0x3) ^ 0x3);
         for (size_t treeId = treeStart; treeId < treeEnd4; treeId += 4) {
             memset(indexesVec, 0, sizeof(ui32) * docCountInBlock);
-            CalcIndexesSse<NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec + docCountInBlock * 0, treeSplitsCurPtr, model.ObliviousTrees.TreeSizes[treeId]);
+            CalcIndexesShallowTree<Kernel, NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec + docCountInBlock * 0, treeSplitsCurPtr, model.ObliviousTrees.TreeSizes[treeId]);
             treeSplitsCurPtr += model.ObliviousTrees.TreeSizes[treeId];
-            CalcIndexesSse<NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec + docCountInBlock * 1, treeSplitsCurPtr, model.ObliviousTrees.TreeSizes[treeId + 1]);
+            CalcIndexesShallowTree<Kernel, NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec + docCountInBlock * 1, treeSplitsCurPtr, model.ObliviousTrees.TreeSizes[treeId + 1]);
             treeSplitsCurPtr += model.ObliviousTrees.TreeSizes[treeId + 1];
-            CalcIndexesSse<NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec + docCountInBlock * 2, treeSplitsCurPtr, model.ObliviousTrees.TreeSizes[treeId + 2]);
+            CalcIndexesShallowTree<Kernel, NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec + docCountInBlock * 2, treeSplitsCurPtr, model.ObliviousTrees.TreeSizes[treeId + 2]);
             treeSplitsCurPtr += model.ObliviousTrees.TreeSizes[treeId + 2];
-            CalcIndexesSse<NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec + docCountInBlock * 3, treeSplitsCurPtr, model.ObliviousTrees.TreeSizes[treeId + 3]);
+            CalcIndexesShallowTree<Kernel, NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec + docCountInBlock * 3, treeSplitsCurPtr, model.ObliviousTrees.TreeSizes[treeId + 3]);
             treeSplitsCurPtr += model.ObliviousTrees.TreeSizes[treeId + 3];
 
             CalculateLeafValues4<SSEBlockCount>(
@@ -388,7 +586,7 @@ Y_FORCE_INLINE void CalcTreesBlockedImpl(
         auto curTreeSize = model.ObliviousTrees.TreeSizes[treeId];
         memset(indexesVec, 0, sizeof(ui32) * docCountInBlock);
         if (curTreeSize <= 8) {
-            CalcIndexesSse<NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
+            CalcIndexesShallowTree<Kernel, NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
             if (IsSingleClassModel) { // single class model
                 CalculateLeafValues(docCountInBlock, treeLeafPtr + firstLeafOffsetsPtr[treeId], indexesVec, resultsPtr);
             } else { // mutliclass model
@@ -406,7 +604,7 @@ Y_FORCE_INLINE void CalcTreesBlockedImpl(
     }
 }
 
-template<bool IsSingleClassModel, bool NeedXorMask>
+template<EFormulaEvaluatorKernel Kernel, bool IsSingleClassModel, bool NeedXorMask>
 inline void CalcTreesBlocked(
     const TFullModel& model,
     const ui8* __restrict binFeatures,
@@ -417,37 +615,184 @@ inline void CalcTreesBlocked(
     double* __restrict resultsPtr) {
     switch (docCountInBlock / SSE_BLOCK_SIZE) {
     case 0:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 0>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<Kernel, IsSingleClassModel, NeedXorMask, 0>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 1:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 1>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<Kernel, IsSingleClassModel, NeedXorMask, 1>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 2:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 2>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<Kernel, IsSingleClassModel, NeedXorMask, 2>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 3:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 3>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<Kernel, IsSingleClassModel, NeedXorMask, 3>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 4:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 4>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<Kernel, IsSingleClassModel, NeedXorMask, 4>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 5:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 5>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<Kernel, IsSingleClassModel, NeedXorMask, 5>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 6:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 6>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<Kernel, IsSingleClassModel, NeedXorMask, 6>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 7:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 7>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<Kernel, IsSingleClassModel, NeedXorMask, 7>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 8:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 8>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<Kernel, IsSingleClassModel, NeedXorMask, 8>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     default:
         Y_UNREACHABLE();
     }
 }
 
+static TCalcIndexesKernel GetCalcIndexesFixedDepthKernel(EFormulaEvaluatorKernel kernel, bool needXorMask, int depth) {
+    switch (kernel) {
+        case EFormulaEvaluatorKernel::Avx2:
+            return GetCalcIndexesAvx2Kernel(needXorMask, depth);
+        case EFormulaEvaluatorKernel::Avx512:
+            return GetCalcIndexesAvx512Kernel(needXorMask, depth);
+        default:
+            return nullptr;
+    }
+}
+
+template<EFormulaEvaluatorKernel Kernel, bool NeedXorMask, int Depth>
+Y_FORCE_INLINE void CalcIndexesFixedDepth(
+        TCalcIndexesKernel isaKernel,
+        const ui8* __restrict binFeatures,
+        ui8* __restrict indexesVec,
+        const TRepackedBin* __restrict treeSplitsCurPtr) {
+    switch (Kernel) {
+        case EFormulaEvaluatorKernel::Basic:
+            CalcIndexesBasic<NeedXorMask, 0>(binFeatures, FORMULA_EVALUATION_BLOCK_SIZE, indexesVec, treeSplitsCurPtr, Depth);
+            break;
+        case EFormulaEvaluatorKernel::Sse:
+            CalcIndexesSse<NeedXorMask, FORMULA_EVALUATION_BLOCK_SIZE / SSE_BLOCK_SIZE>(binFeatures, FORMULA_EVALUATION_BLOCK_SIZE, indexesVec, treeSplitsCurPtr, Depth);
+            break;
+        case EFormulaEvaluatorKernel::Avx2:
+        case EFormulaEvaluatorKernel::Avx512:
+            isaKernel(binFeatures, FORMULA_EVALUATION_BLOCK_SIZE, indexesVec, treeSplitsCurPtr);
+            break;
+    }
+}
+
+/**
+ * Evaluates trees [treeStart; treeEnd) of equal depth on full block of documents.
+ * Depth and block size are compile time constants: index calculation is unrolled and leaf arrays have fixed stride.
+ */
+template<EFormulaEvaluatorKernel Kernel, bool IsSingleClassModel, bool NeedXorMask, int Depth>
+static void CalcTreeDepthGroup(
+    const TFullModel& model,
+    const ui8* __restrict binFeatures,
+    ui8* __restrict indexesVec,
+    size_t treeStart,
+    size_t treeEnd,
+    double* __restrict resultsPtr)
+{
+    constexpr size_t docCountInBlock = FORMULA_EVALUATION_BLOCK_SIZE;
+    constexpr int sseBlockCount = FORMULA_EVALUATION_BLOCK_SIZE / SSE_BLOCK_SIZE;
+    static_assert(FORMULA_EVALUATION_BLOCK_SIZE * 4 <= FORMULA_EVALUATION_BLOCK_SIZE * sizeof(TCalcerIndexType), "4 trees ui8 indexes should fit into indexes buffer");
+    const TCalcIndexesKernel isaKernel = GetCalcIndexesFixedDepthKernel(Kernel, NeedXorMask, Depth);
+    const TRepackedBin* treeSplitsCurPtr =
+        model.ObliviousTrees.GetRepackedBins().data() + model.ObliviousTrees.TreeStartOffsets[treeStart];
+    const double* treeLeafPtr = model.ObliviousTrees.GetFirstLeafPtrForTree(treeStart);
+    const size_t leafCount = (size_t(1) << Depth) * model.ObliviousTrees.ApproxDimension;
+    if (IsSingleClassModel) {
+        const auto treeEnd4 = treeStart + (((treeEnd - treeStart) | 0x3) ^ 0x3);
+        for (size_t treeId = treeStart; treeId < treeEnd4; treeId += 4) {
+            memset(indexesVec, 0, docCountInBlock * 4);
+            CalcIndexesFixedDepth<Kernel, NeedXorMask, Depth>(isaKernel, binFeatures, indexesVec + docCountInBlock * 0, treeSplitsCurPtr + Depth * 0);
+            CalcIndexesFixedDepth<Kernel, NeedXorMask, Depth>(isaKernel, binFeatures, indexesVec + docCountInBlock * 1, treeSplitsCurPtr + Depth * 1);
+            CalcIndexesFixedDepth<Kernel, NeedXorMask, Depth>(isaKernel, binFeatures, indexesVec + docCountInBlock * 2, treeSplitsCurPtr + Depth * 2);
+            CalcIndexesFixedDepth<Kernel, NeedXorMask, Depth>(isaKernel, binFeatures, indexesVec + docCountInBlock * 3, treeSplitsCurPtr + Depth * 3);
+            CalculateLeafValues4<sseBlockCount>(
+                docCountInBlock,
+                treeLeafPtr + leafCount * 0,
+                treeLeafPtr + leafCount * 1,
+                treeLeafPtr + leafCount * 2,
+                treeLeafPtr + leafCount * 3,
+                indexesVec + docCountInBlock * 0,
+                indexesVec + docCountInBlock * 1,
+                indexesVec + docCountInBlock * 2,
+                indexesVec + docCountInBlock * 3,
+                resultsPtr
+            );
+            treeSplitsCurPtr += Depth * 4;
+            treeLeafPtr += leafCount * 4;
+        }
+        treeStart = treeEnd4;
+    }
+    for (size_t treeId = treeStart; treeId < treeEnd; ++treeId) {
+        memset(indexesVec, 0, docCountInBlock);
+        CalcIndexesFixedDepth<Kernel, NeedXorMask, Depth>(isaKernel, binFeatures, indexesVec, treeSplitsCurPtr);
+        if (IsSingleClassModel) {
+            CalculateLeafValues(docCountInBlock, treeLeafPtr, indexesVec, resultsPtr);
+        } else {
+            CalculateLeafValuesMulti(docCountInBlock, treeLeafPtr, indexesVec, model.ObliviousTrees.ApproxDimension, resultsPtr);
+        }
+        treeSplitsCurPtr += Depth;
+        treeLeafPtr += leafCount;
+    }
+}
+
+/**
+ * Depth specialized evaluation: trees are processed by groups of equal depth precomputed in model metadata,
+ * each group is dispatched to kernel instantiated for its depth. Partial blocks and trees deeper than 8
+ * are evaluated by generic CalcTreesBlocked.
+ */
+template<EFormulaEvaluatorKernel Kernel, bool IsSingleClassModel, bool NeedXorMask>
+inline void CalcTreesDepthSpecialized(
+    const TFullModel& model,
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    TCalcerIndexType* __restrict indexesVec,
+    size_t treeStart,
+    size_t treeEnd,
+    double* __restrict resultsPtr)
+{
+    if (docCountInBlock != FORMULA_EVALUATION_BLOCK_SIZE) {
+        CalcTreesBlocked<Kernel, IsSingleClassModel, NeedXorMask>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        return;
+    }
+    // SSE leaf gather needs aligned results
+    auto alignedResultsPtr = resultsPtr;
+    const size_t neededMemory = docCountInBlock * model.ObliviousTrees.ApproxDimension * sizeof(double);
+    if (IsSingleClassModel && (uintptr_t)alignedResultsPtr % sizeof(__m128d) != 0) {
+        alignedResultsPtr = GetAligned((double *)alloca(neededMemory + 0x20));
+        memcpy(alignedResultsPtr, resultsPtr, neededMemory);
+    }
+    for (const auto& group : model.ObliviousTrees.GetTreeDepthGroups()) {
+        const size_t groupStart = Max(group.TreeStart, treeStart);
+        const size_t groupEnd = Min(group.TreeEnd, treeEnd);
+        if (groupStart >= groupEnd) {
+            continue;
+        }
+        ui8* indexes = (ui8*)indexesVec;
+#define CALC_TREE_DEPTH_GROUP(depth) \
+        case depth: \
+            CalcTreeDepthGroup<Kernel, IsSingleClassModel, NeedXorMask, depth>(model, binFeatures, indexes, groupStart, groupEnd, alignedResultsPtr); \
+            break;
+        switch (group.Depth) {
+            CALC_TREE_DEPTH_GROUP(0)
+            CALC_TREE_DEPTH_GROUP(1)
+            CALC_TREE_DEPTH_GROUP(2)
+            CALC_TREE_DEPTH_GROUP(3)
+            CALC_TREE_DEPTH_GROUP(4)
+            CALC_TREE_DEPTH_GROUP(5)
+            CALC_TREE_DEPTH_GROUP(6)
+            CALC_TREE_DEPTH_GROUP(7)
+            CALC_TREE_DEPTH_GROUP(8)
+            default:
+                CalcTreesBlocked<Kernel, IsSingleClassModel, NeedXorMask>(model, binFeatures, docCountInBlock, indexesVec, groupStart, groupEnd, alignedResultsPtr);
+        }
+#undef CALC_TREE_DEPTH_GROUP
+    }
+    if (alignedResultsPtr != resultsPtr) {
+        memcpy(resultsPtr, alignedResultsPtr, neededMemory);
+    }
+}
+
 template<bool IsSingleClassModel, bool NeedXorMask>
 inline void CalcTreesSingleDocImpl(
     const TFullModel& model,
@@ -491,35 +836,341 @@ inline void CalcTreesSingleDocImpl(
     }
 }
 
-TTreeCalcFunction GetCalcTreesFunction(const TFullModel& model, size_t docCountInBlock) {
-    const bool hasOneHots = !model.ObliviousTrees.OneHotFeatures.empty();
-    if (model.ObliviousTrees.ApproxDimension == 1) {
-        if (docCountInBlock == 1) {
-            if (hasOneHots) {
-                return CalcTreesSingleDocImpl<true, true>;
+template<typename TLeafValue>
+static const TLeafValue* GetCompactLeafValues(const TObliviousTrees& trees);
+
+template<>
+const float* GetCompactLeafValues<float>(const TObliviousTrees& trees) {
+    return trees.GetFloatLeafValues().data();
+}
+
+template<>
+const i16* GetCompactLeafValues<i16>(const TObliviousTrees& trees) {
+    return trees.GetInt16LeafValues().data();
+}
+
+template<typename TLeafValue, typename TIndexType>
+Y_FORCE_INLINE void CalculateCompactLeafValues(
+    const size_t docCountInBlock,
+    const TLeafValue* __restrict treeLeafPtr,
+    const double scale,
+    const TIndexType* __restrict indexesPtr,
+    double* __restrict writePtr)
+{
+    for (size_t docId = 0; docId < docCountInBlock; ++docId) {
+        writePtr[docId] += treeLeafPtr[indexesPtr[docId]] * scale;
+    }
+}
+
+template<typename TLeafValue>
+Y_FORCE_INLINE void CalculateCompactLeafValues4(
+    const size_t docCountInBlock,
+    const TLeafValue* __restrict treeLeafPtr0,
+    const TLeafValue* __restrict treeLeafPtr1,
+    const TLeafValue* __restrict treeLeafPtr2,
+    const TLeafValue* __restrict treeLeafPtr3,
+    const double* __restrict scales,
+    const ui8* __restrict indexesPtr,
+    double* __restrict writePtr)
+{
+    const ui8* __restrict indexesPtr0 = indexesPtr + docCountInBlock * 0;
+    const ui8* __restrict indexesPtr1 = indexesPtr + docCountInBlock * 1;
+    const ui8* __restrict indexesPtr2 = indexesPtr + docCountInBlock * 2;
+    const ui8* __restrict indexesPtr3 = indexesPtr + docCountInBlock * 3;
+    for (size_t docId = 0; docId < docCountInBlock; ++docId) {
+        writePtr[docId] += treeLeafPtr0[indexesPtr0[docId]] * scales[0]
+            + treeLeafPtr1[indexesPtr1[docId]] * scales[1]
+            + treeLeafPtr2[indexesPtr2[docId]] * scales[2]
+            + treeLeafPtr3[indexesPtr3[docId]] * scales[3];
+    }
+}
+
+template<typename TLeafValue, typename TIndexType>
+Y_FORCE_INLINE void CalculateCompactLeafValuesMulti(
+    const size_t docCountInBlock,
+    const TLeafValue* __restrict leafPtr,
+    const double scale,
+    const TIndexType* __restrict indexesVec,
+    const int approxDimension,
+    double* __restrict writePtr)
+{
+    for (size_t docId = 0; docId < docCountInBlock; ++docId) {
+        auto leafValuePtr = leafPtr + indexesVec[docId] * approxDimension;
+        for (int classId = 0; classId < approxDimension; ++classId) {
+            writePtr[classId] += leafValuePtr[classId] * scale;
+        }
+        writePtr += approxDimension;
+    }
+}
+
+template<EFormulaEvaluatorKernel Kernel, bool NeedXorMask>
+Y_FORCE_INLINE void CalcIndexesCompactLeavesTree(
+        const ui8* __restrict binFeatures,
+        size_t docCountInBlock,
+        ui8* __restrict indexesVec,
+        const TRepackedBin* __restrict treeSplitsCurPtr,
+        const int curTreeSize) {
+    if (docCountInBlock == FORMULA_EVALUATION_BLOCK_SIZE) {
+        CalcIndexesShallowTree<Kernel, NeedXorMask, FORMULA_EVALUATION_BLOCK_SIZE / SSE_BLOCK_SIZE>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
+    } else {
+        CalcIndexesShallowTree<Kernel, NeedXorMask, 0>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
+    }
+}
+
+/**
+ * Trees evaluation with reduced precision leaf values (see TObliviousTrees::SetLeafValuesPrecision).
+ * Leaf values are converted and scaled on gather, results are accumulated in double.
+ */
+template<EFormulaEvaluatorKernel Kernel, typename TLeafValue, bool IsSingleClassModel, bool NeedXorMask>
+inline void CalcTreesCompactLeaves(
+    const TFullModel& model,
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    TCalcerIndexType* __restrict indexesVecUI32,
+    size_t treeStart,
+    size_t treeEnd,
+    double* __restrict resultsPtr)
+{
+    const auto& trees = model.ObliviousTrees;
+    const TRepackedBin* treeSplitsCurPtr = trees.GetRepackedBins().data() + trees.TreeStartOffsets[treeStart];
+    const TLeafValue* leafValues = GetCompactLeafValues<TLeafValue>(trees);
+    const double* scales = trees.GetTreeLeafScales().data();
+    const auto firstLeafOffsetsPtr = trees.GetFirstLeafOffsets().data();
+    const auto treeSizes = trees.TreeSizes.data();
+    TCalcerIndexType singleDocIndexes[4];
+    if (indexesVecUI32 == nullptr) {
+        Y_ASSERT(docCountInBlock == 1);
+        indexesVecUI32 = singleDocIndexes;
+    }
+    ui8* __restrict indexesVec = (ui8*)indexesVecUI32;
+    if (IsSingleClassModel) {
+        for (; treeStart + 4 <= treeEnd; treeStart += 4) {
+            if (Max(Max(treeSizes[treeStart], treeSizes[treeStart + 1]), Max(treeSizes[treeStart + 2], treeSizes[treeStart + 3])) > 8) {
+                break;
+            }
+            memset(indexesVec, 0, sizeof(ui32) * docCountInBlock);
+            for (size_t treeIdx = 0; treeIdx < 4; ++treeIdx) {
+                CalcIndexesCompactLeavesTree<Kernel, NeedXorMask>(binFeatures, docCountInBlock, indexesVec + docCountInBlock * treeIdx, treeSplitsCurPtr, treeSizes[treeStart + treeIdx]);
+                treeSplitsCurPtr += treeSizes[treeStart + treeIdx];
+            }
+            CalculateCompactLeafValues4(
+                docCountInBlock,
+                leafValues + firstLeafOffsetsPtr[treeStart + 0],
+                leafValues + firstLeafOffsetsPtr[treeStart + 1],
+                leafValues + firstLeafOffsetsPtr[treeStart + 2],
+                leafValues + firstLeafOffsetsPtr[treeStart + 3],
+                scales + treeStart,
+                indexesVec,
+                resultsPtr);
+        }
+    }
+    for (size_t treeId = treeStart; treeId < treeEnd; ++treeId) {
+        const auto curTreeSize = treeSizes[treeId];
+        memset(indexesVec, 0, sizeof(ui32) * docCountInBlock);
+        const TLeafValue* treeLeafPtr = leafValues + firstLeafOffsetsPtr[treeId];
+        if (curTreeSize <= 8) {
+            CalcIndexesCompactLeavesTree<Kernel, NeedXorMask>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
+            if (IsSingleClassModel) {
+                CalculateCompactLeafValues(docCountInBlock, treeLeafPtr, scales[treeId], indexesVec, resultsPtr);
             } else {
-                return CalcTreesSingleDocImpl<true, false>;
+                CalculateCompactLeafValuesMulti(docCountInBlock, treeLeafPtr, scales[treeId], indexesVec, trees.ApproxDimension, resultsPtr);
             }
         } else {
-            if (hasOneHots) {
-                return CalcTreesBlocked<true, true>;
+            CalcIndexesBasic<NeedXorMask, 0>(binFeatures, docCountInBlock, indexesVecUI32, treeSplitsCurPtr, curTreeSize);
+            if (IsSingleClassModel) {
+                CalculateCompactLeafValues(docCountInBlock, treeLeafPtr, scales[treeId], indexesVecUI32, resultsPtr);
             } else {
-                return CalcTreesBlocked<true, false>;
+                CalculateCompactLeafValuesMulti(docCountInBlock, treeLeafPtr, scales[treeId], indexesVecUI32, trees.ApproxDimension, resultsPtr);
             }
         }
+        treeSplitsCurPtr += curTreeSize;
+    }
+}
+
+template<EFormulaEvaluatorKernel Kernel, typename TLeafValue>
+static TTreeCalcFunction GetCalcTreesCompactLeavesFunction(bool isSingleClassModel, bool hasOneHots) {
+    if (isSingleClassModel) {
+        if (hasOneHots) {
+            return CalcTreesCompactLeaves<Kernel, TLeafValue, true, true>;
+        } else {
+            return CalcTreesCompactLeaves<Kernel, TLeafValue, true, false>;
+        }
+    } else {
+        if (hasOneHots) {
+            return CalcTreesCompactLeaves<Kernel, TLeafValue, false, true>;
+        } else {
+            return CalcTreesCompactLeaves<Kernel, TLeafValue, false, false>;
+        }
+    }
+}
+
+template<EFormulaEvaluatorKernel Kernel>
+static TTreeCalcFunction GetCalcTreesCompactLeavesFunction(ELeafValuesPrecision precision, bool isSingleClassModel, bool hasOneHots) {
+    if (precision == ELeafValuesPrecision::Float) {
+        return GetCalcTreesCompactLeavesFunction<Kernel, float>(isSingleClassModel, hasOneHots);
+    } else {
+        Y_ASSERT(precision == ELeafValuesPrecision::Int16);
+        return GetCalcTreesCompactLeavesFunction<Kernel, i16>(isSingleClassModel, hasOneHots);
+    }
+}
+
+template<EFormulaEvaluatorKernel Kernel, bool IsSingleClassModel, bool NeedXorMask>
+static TTreeCalcFunction GetCalcTreesBlockedFunction(bool depthSpecialized) {
+    if (depthSpecialized) {
+        return CalcTreesDepthSpecialized<Kernel, IsSingleClassModel, NeedXorMask>;
+    } else {
+        return CalcTreesBlocked<Kernel, IsSingleClassModel, NeedXorMask>;
+    }
+}
+
+template<EFormulaEvaluatorKernel Kernel>
+static TTreeCalcFunction GetCalcTreesBlockedFunction(bool isSingleClassModel, bool hasOneHots, bool depthSpecialized) {
+    if (isSingleClassModel) {
+        if (hasOneHots) {
+            return GetCalcTreesBlockedFunction<Kernel, true, true>(depthSpecialized);
+        } else {
+            return GetCalcTreesBlockedFunction<Kernel, true, false>(depthSpecialized);
+        }
     } else {
+        if (hasOneHots) {
+            return GetCalcTreesBlockedFunction<Kernel, false, true>(depthSpecialized);
+        } else {
+            return GetCalcTreesBlockedFunction<Kernel, false, false>(depthSpecialized);
+        }
+    }
+}
+
+TTreeCalcFunction GetCalcTreesFunction(
+    const TFullModel& model,
+    size_t docCountInBlock,
+    EFormulaEvaluatorKernel kernel,
+    bool depthSpecialized
+) {
+    const bool hasOneHots = !model.ObliviousTrees.OneHotFeatures.empty();
+    const bool isSingleClassModel = model.ObliviousTrees.ApproxDimension == 1;
+    const auto leafValuesPrecision = model.ObliviousTrees.LeafValuesPrecision;
+    if (leafValuesPrecision != ELeafValuesPrecision::Double) {
+        // single document blocks are evaluated by the same function with basic kernel
         if (docCountInBlock == 1) {
+            kernel = EFormulaEvaluatorKernel::Basic;
+        }
+        CB_ENSURE(IsFormulaEvaluatorKernelSupported(kernel), "Formula evaluator kernel is not supported on this CPU");
+        switch (kernel) {
+            case EFormulaEvaluatorKernel::Basic:
+                return GetCalcTreesCompactLeavesFunction<EFormulaEvaluatorKernel::Basic>(leafValuesPrecision, isSingleClassModel, hasOneHots);
+            case EFormulaEvaluatorKernel::Sse:
+                return GetCalcTreesCompactLeavesFunction<EFormulaEvaluatorKernel::Sse>(leafValuesPrecision, isSingleClassModel, hasOneHots);
+            case EFormulaEvaluatorKernel::Avx2:
+                return GetCalcTreesCompactLeavesFunction<EFormulaEvaluatorKernel::Avx2>(leafValuesPrecision, isSingleClassModel, hasOneHots);
+            case EFormulaEvaluatorKernel::Avx512:
+                return GetCalcTreesCompactLeavesFunction<EFormulaEvaluatorKernel::Avx512>(leafValuesPrecision, isSingleClassModel, hasOneHots);
+        }
+        Y_UNREACHABLE();
+    }
+    if (docCountInBlock == 1) {
+        if (isSingleClassModel) {
             if (hasOneHots) {
-                return CalcTreesSingleDocImpl<false, true>;
+                return CalcTreesSingleDocImpl<true, true>;
             } else {
-                return CalcTreesSingleDocImpl<false, false>;
+                return CalcTreesSingleDocImpl<true, false>;
             }
         } else {
             if (hasOneHots) {
-                return CalcTreesBlocked<false, true>;
+                return CalcTreesSingleDocImpl<false, true>;
             } else {
-                return CalcTreesBlocked<false, false>;
+                return CalcTreesSingleDocImpl<false, false>;
+            }
+        }
+    }
+    CB_ENSURE(IsFormulaEvaluatorKernelSupported(kernel), "Formula evaluator kernel is not supported on this CPU");
+    switch (kernel) {
+        case EFormulaEvaluatorKernel::Basic:
+            return GetCalcTreesBlockedFunction<EFormulaEvaluatorKernel::Basic>(isSingleClassModel, hasOneHots, depthSpecialized);
+        case EFormulaEvaluatorKernel::Sse:
+            return GetCalcTreesBlockedFunction<EFormulaEvaluatorKernel::Sse>(isSingleClassModel, hasOneHots, depthSpecialized);
+        case EFormulaEvaluatorKernel::Avx2:
+            return GetCalcTreesBlockedFunction<EFormulaEvaluatorKernel::Avx2>(isSingleClassModel, hasOneHots, depthSpecialized);
+        case EFormulaEvaluatorKernel::Avx512:
+            return GetCalcTreesBlockedFunction<EFormulaEvaluatorKernel::Avx512>(isSingleClassModel, hasOneHots, depthSpecialized);
+    }
+    Y_UNREACHABLE();
+}
+
+template<EFormulaEvaluatorKernel Kernel, bool NeedXorMask, typename TLeafIndex>
+static void CalcLeafIndexesBlockImpl(
+    const TFullModel& model,
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    size_t treeStart,
+    size_t treeEnd,
+    TLeafIndex* __restrict treeLeafIndexes)
+{
+    const auto& trees = model.ObliviousTrees;
+    const TRepackedBin* treeSplitsCurPtr = trees.GetRepackedBins().data() + trees.TreeStartOffsets[treeStart];
+    const size_t treeCount = treeEnd - treeStart;
+    alignas(64) ui8 shallowIndexes[FORMULA_EVALUATION_BLOCK_SIZE];
+    TCalcerIndexType deepIndexes[FORMULA_EVALUATION_BLOCK_SIZE];
+    for (size_t treeId = treeStart; treeId < treeEnd; ++treeId) {
+        const auto curTreeSize = trees.TreeSizes[treeId];
+        TLeafIndex* __restrict writePtr = treeLeafIndexes + (treeId - treeStart);
+        if (curTreeSize <= 8) {
+            memset(shallowIndexes, 0, docCountInBlock);
+            CalcIndexesCompactLeavesTree<Kernel, NeedXorMask>(binFeatures, docCountInBlock, shallowIndexes, treeSplitsCurPtr, curTreeSize);
+            for (size_t docId = 0; docId < docCountInBlock; ++docId) {
+                writePtr[docId * treeCount] = shallowIndexes[docId];
+            }
+        } else {
+            memset(deepIndexes, 0, sizeof(TCalcerIndexType) * docCountInBlock);
+            CalcIndexesBasic<NeedXorMask, 0>(binFeatures, docCountInBlock, deepIndexes, treeSplitsCurPtr, curTreeSize);
+            for (size_t docId = 0; docId < docCountInBlock; ++docId) {
+                writePtr[docId * treeCount] = deepIndexes[docId];
             }
         }
+        treeSplitsCurPtr += curTreeSize;
+    }
+}
+
+template<EFormulaEvaluatorKernel Kernel, typename TLeafIndex>
+static void CalcLeafIndexesBlockForKernel(
+    const TFullModel& model,
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    size_t treeStart,
+    size_t treeEnd,
+    TLeafIndex* __restrict treeLeafIndexes)
+{
+    if (model.ObliviousTrees.OneHotFeatures.empty()) {
+        CalcLeafIndexesBlockImpl<Kernel, false>(model, binFeatures, docCountInBlock, treeStart, treeEnd, treeLeafIndexes);
+    } else {
+        CalcLeafIndexesBlockImpl<Kernel, true>(model, binFeatures, docCountInBlock, treeStart, treeEnd, treeLeafIndexes);
     }
 }
+
+template<typename TLeafIndex>
+void CalcLeafIndexesBlock(
+    const TFullModel& model,
+    const ui8* binFeatures,
+    size_t docCountInBlock,
+    size_t treeStart,
+    size_t treeEnd,
+    TLeafIndex* treeLeafIndexes,
+    EFormulaEvaluatorKernel kernel)
+{
+    Y_ASSERT(docCountInBlock <= FORMULA_EVALUATION_BLOCK_SIZE);
+    CB_ENSURE(IsFormulaEvaluatorKernelSupported(kernel), "Formula evaluator kernel is not supported on this CPU");
+    switch (kernel) {
+        case EFormulaEvaluatorKernel::Basic:
+            return CalcLeafIndexesBlockForKernel<EFormulaEvaluatorKernel::Basic>(model, binFeatures, docCountInBlock, treeStart, treeEnd, treeLeafIndexes);
+        case EFormulaEvaluatorKernel::Sse:
+            return CalcLeafIndexesBlockForKernel<EFormulaEvaluatorKernel::Sse>(model, binFeatures, docCountInBlock, treeStart, treeEnd, treeLeafIndexes);
+        case EFormulaEvaluatorKernel::Avx2:
+            return CalcLeafIndexesBlockForKernel<EFormulaEvaluatorKernel::Avx2>(model, binFeatures, docCountInBlock, treeStart, treeEnd, treeLeafIndexes);
+        case EFormulaEvaluatorKernel::Avx512:
+            return CalcLeafIndexesBlockForKernel<EFormulaEvaluatorKernel::Avx512>(model, binFeatures, docCountInBlock, treeStart, treeEnd, treeLeafIndexes);
+    }
+    Y_UNREACHABLE();
+}
+
+template void CalcLeafIndexesBlock<ui8>(const TFullModel&, const ui8*, size_t, size_t, size_t, ui8*, EFormulaEvaluatorKernel);
+template void CalcLeafIndexesBlock<ui16>(const TFullModel&, const ui8*, size_t, size_t, size_t, ui16*, EFormulaEvaluatorKernel);
+template void CalcLeafIndexesBlock<ui32>(const TFullModel&, const ui8*, size_t, size_t, size_t, ui32*, EFormulaEvaluatorKernel);
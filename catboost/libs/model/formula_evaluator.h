@@ -3,7 +3,6 @@
 #include "model.h"
 #include <catboost/libs/helpers/exception.h>
 #include <util/generic/ymath.h>
-#include <emmintrin.h>
 
 constexpr size_t FORMULA_EVALUATION_BLOCK_SIZE = 128;
 
@@ -25,58 +24,72 @@ inline void OneHotBinsFromTransposedCatFeatures(
     }
 }
 
-#ifdef NO_SSE
-template<bool UseNanSubstitution, typename TFloatFeatureAccessor>
-Y_FORCE_INLINE void BinarizeFloats(
-    const size_t docCount,
-    TFloatFeatureAccessor floatAccessor,
-    const TConstArrayRef<float> borders,
-    size_t start,
-    ui8*& result,
-    float nanSubstitutionValue=0.0f
-) {
-    const auto docCount8 = (docCount | 0x7) ^ 0x7;
-    for (size_t docId = 0; docId < docCount8; docId += 8) {
-        float val[8] = {
-            floatAccessor(start + docId + 0),
-            floatAccessor(start + docId + 1),
-            floatAccessor(start + docId + 2),
-            floatAccessor(start + docId + 3),
-            floatAccessor(start + docId + 4),
-            floatAccessor(start + docId + 5),
-            floatAccessor(start + docId + 6),
-            floatAccessor(start + docId + 7)
-        };
-        if (UseNanSubstitution) {
-            for (size_t i = 0; i < 8; ++i) {
-                if (IsNan(val[i])) {
-                    val[i] = nanSubstitutionValue;
-                }
-            }
-        }
-        auto writePtr = (ui32*)(result + docId);
-        for (const auto border : borders) {
-            writePtr[0] += (val[0] > border) + ((val[1] > border) << 8) + ((val[2] > border) << 16) + ((val[3] > border) << 24);
-            writePtr[1] += (val[4] > border) + ((val[5] > border) << 8) + ((val[6] > border) << 16) + ((val[7] > border) << 24);
-        }
-    }
-    for (size_t docId = docCount8; docId < docCount; ++docId) {
-        float val = floatAccessor(start + docId);
-        if (UseNanSubstitution) {
-            if (IsNan(val)) {
-                val = nanSubstitutionValue;
-            }
-        }
-        for (const auto border : borders) {
-            result[docId] += (ui8)(val > border);
-        }
+/**
+ * Instruction set used by formula evaluator kernels: float features binarization and tree indexes calculation.
+ * All kernels produce bit-identical results, the best one supported by current CPU is selected at runtime.
+ */
+enum class EFormulaEvaluatorKernel {
+    Basic,
+    Sse,
+    Avx2,
+    Avx512
+};
+
+//! Check that kernel is compiled into this binary and supported by current CPU
+bool IsFormulaEvaluatorKernelSupported(EFormulaEvaluatorKernel kernel);
+
+//! Fastest kernel supported by current CPU, CPU features are detected once per process
+EFormulaEvaluatorKernel GetBestFormulaEvaluatorKernel();
+
+/**
+ * Binarizes docCount contiguous float values: result[i] = number of borders less than values[i].
+ * NaN values should be substituted before the call.
+ */
+using TBinarizeFloatsKernel = void(*)(
+    const float* __restrict values,
+    size_t docCount,
+    TConstArrayRef<float> borders,
+    ui8* __restrict result);
+
+/**
+ * LinearScan compares every value with every border, BinarySearch does branchless search over sorted borders.
+ * Both methods give identical bins, search wins for features with many borders.
+ */
+enum class EBinarizationMethod {
+    LinearScan,
+    BinarySearch
+};
+
+/**
+ * Features with at least this many borders are binarized with binary search.
+ * Wide linear scan kernels stay faster for moderate border counts, so the threshold depends on kernel.
+ */
+size_t GetBinarySearchMinBorderCount(EFormulaEvaluatorKernel kernel);
+
+TBinarizeFloatsKernel GetBinarizeFloatsKernel(
+    EFormulaEvaluatorKernel kernel,
+    EBinarizationMethod method = EBinarizationMethod::LinearScan);
+
+//! Pair of binarizers for one instruction set, chooses method per feature by border count
+struct TFloatBinarizer {
+    TBinarizeFloatsKernel LinearScan;
+    TBinarizeFloatsKernel BinarySearch;
+    size_t BinarySearchMinBorderCount;
+
+    explicit TFloatBinarizer(EFormulaEvaluatorKernel kernel)
+        : LinearScan(GetBinarizeFloatsKernel(kernel, EBinarizationMethod::LinearScan))
+        , BinarySearch(GetBinarizeFloatsKernel(kernel, EBinarizationMethod::BinarySearch))
+        , BinarySearchMinBorderCount(GetBinarySearchMinBorderCount(kernel))
+    {}
+
+    TBinarizeFloatsKernel ForBorders(TConstArrayRef<float> borders) const {
+        return borders.size() >= BinarySearchMinBorderCount ? BinarySearch : LinearScan;
     }
-    result += docCount;
-}
+};
 
-#else
 template<bool UseNanSubstitution, typename TFloatFeatureAccessor>
 Y_FORCE_INLINE void BinarizeFloats(
+    TBinarizeFloatsKernel binarizeKernel,
     const size_t docCount,
     TFloatFeatureAccessor floatAccessor,
     const TConstArrayRef<float> borders,
@@ -84,80 +97,23 @@ Y_FORCE_INLINE void BinarizeFloats(
     ui8*& result,
     const float nanSubstitutionValue = 0.0f
 ) {
-    const __m128 substitutionValVec = _mm_set1_ps(nanSubstitutionValue);
-    const auto docCount16 = (docCount | 0xf) ^ 0xf;
-    for (size_t docId = 0; docId < docCount16; docId += 16) {
-        const float val[16] = {
-            floatAccessor(start + docId + 0),
-            floatAccessor(start + docId + 1),
-            floatAccessor(start + docId + 2),
-            floatAccessor(start + docId + 3),
-            floatAccessor(start + docId + 4),
-            floatAccessor(start + docId + 5),
-            floatAccessor(start + docId + 6),
-            floatAccessor(start + docId + 7),
-            floatAccessor(start + docId + 8),
-            floatAccessor(start + docId + 9),
-            floatAccessor(start + docId + 10),
-            floatAccessor(start + docId + 11),
-            floatAccessor(start + docId + 12),
-            floatAccessor(start + docId + 13),
-            floatAccessor(start + docId + 14),
-            floatAccessor(start + docId + 15)
-        };
-        const __m128i mask = _mm_set1_epi8(1);
-        __m128 floats0 = _mm_load_ps(val);
-        __m128 floats1 = _mm_load_ps(val + 4);
-        __m128 floats2 = _mm_load_ps(val + 8);
-        __m128 floats3 = _mm_load_ps(val + 12);
-        __m128i resultVec = _mm_setzero_si128();
-
-        if (UseNanSubstitution) {
-            {
-                const __m128 masks = _mm_cmpunord_ps(floats0, floats0);
-                floats0 = _mm_or_ps(_mm_andnot_ps(masks, floats0), _mm_and_ps(masks, substitutionValVec));
-            }
-            {
-                const __m128 masks = _mm_cmpunord_ps(floats1, floats1);
-                floats1 = _mm_or_ps(_mm_andnot_ps(masks, floats1), _mm_and_ps(masks, substitutionValVec));
-            }
-            {
-                const __m128 masks = _mm_cmpunord_ps(floats2, floats2);
-                floats2 = _mm_or_ps(_mm_andnot_ps(masks, floats2), _mm_and_ps(masks, substitutionValVec));
-            }
-            {
-                const __m128 masks = _mm_cmpunord_ps(floats3, floats3);
-                floats3 = _mm_or_ps(_mm_andnot_ps(masks, floats3), _mm_and_ps(masks, substitutionValVec));
+    alignas(64) float values[FORMULA_EVALUATION_BLOCK_SIZE];
+    for (size_t blockStart = 0; blockStart < docCount; blockStart += FORMULA_EVALUATION_BLOCK_SIZE) {
+        const size_t docCountInBlock = Min(FORMULA_EVALUATION_BLOCK_SIZE, docCount - blockStart);
+        for (size_t docId = 0; docId < docCountInBlock; ++docId) {
+            float val = floatAccessor(start + blockStart + docId);
+            if (UseNanSubstitution) {
+                if (IsNan(val)) {
+                    val = nanSubstitutionValue;
+                }
             }
+            values[docId] = val;
         }
-
-        for (const auto border : borders) {
-            const __m128 borderVec = _mm_set1_ps(border);
-            const __m128i r0 = _mm_castps_si128(_mm_cmpgt_ps(floats0, borderVec));
-            const __m128i r1 = _mm_castps_si128(_mm_cmpgt_ps(floats1, borderVec));
-            const __m128i r2 = _mm_castps_si128(_mm_cmpgt_ps(floats2, borderVec));
-            const __m128i r3 = _mm_castps_si128(_mm_cmpgt_ps(floats3, borderVec));
-            const __m128i packed = _mm_packs_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
-            resultVec = _mm_add_epi8(resultVec, _mm_and_si128(packed, mask));
-        }
-        _mm_storeu_si128((__m128i*)(result + docId), resultVec);
-    }
-    for (size_t docId = docCount16; docId < docCount; ++docId) {
-        float val = floatAccessor(start + docId);
-        if (UseNanSubstitution) {
-            if (IsNan(val)) {
-                val = nanSubstitutionValue;
-            }
-        }
-        for (const auto border : borders) {
-            result[docId] += (ui8)(val > border);
-        }
+        binarizeKernel(values, docCountInBlock, borders, result + blockStart);
     }
     result += docCount;
 }
 
-#endif
-
 /**
 * This function binarizes
 */
@@ -175,9 +131,11 @@ inline void BinarizeFeatures(
     const auto docCount = end - start;
     ui8* resultPtr = result.data();
     std::fill(result.begin(), result.end(), 0);
+    static const TFloatBinarizer binarizer(GetBestFormulaEvaluatorKernel());
     for (const auto& floatFeature : model.ObliviousTrees.FloatFeatures) {
         if (!floatFeature.HasNans || floatFeature.NanValueTreatment == NCatBoostFbs::ENanValueTreatment_AsIs) {
             BinarizeFloats<false>(
+                binarizer.ForBorders(floatFeature.Borders),
                 docCount,
                 [&floatFeature, floatAccessor](size_t index) { return floatAccessor(floatFeature, index); },
                 floatFeature.Borders,
@@ -187,6 +145,7 @@ inline void BinarizeFeatures(
             const float infinity = std::numeric_limits<float>::infinity();
             if (floatFeature.NanValueTreatment == NCatBoostFbs::ENanValueTreatment_AsFalse) {
                 BinarizeFloats<true>(
+                    binarizer.ForBorders(floatFeature.Borders),
                     docCount,
                     [&floatFeature, floatAccessor](size_t index) { return floatAccessor(floatFeature, index); },
                     floatFeature.Borders,
@@ -196,6 +155,7 @@ inline void BinarizeFeatures(
             } else {
                 Y_ASSERT(floatFeature.NanValueTreatment == NCatBoostFbs::ENanValueTreatment_AsTrue);
                 BinarizeFloats<true>(
+                    binarizer.ForBorders(floatFeature.Borders),
                     docCount,
                     [&floatFeature, floatAccessor](size_t index) { return floatAccessor(floatFeature, index); },
                     floatFeature.Borders,
@@ -232,6 +192,7 @@ inline void BinarizeFeatures(
             const auto& ctr = model.ObliviousTrees.CtrFeatures[i];
             auto ctrFloatsPtr = &ctrs[i * docCount];
             BinarizeFloats<false>(
+                binarizer.ForBorders(ctr.Borders),
                 docCount,
                 [ctrFloatsPtr](size_t index) { return ctrFloatsPtr[index]; },
                 ctr.Borders,
@@ -260,7 +221,37 @@ void CalcIndexes(
     const TRepackedBin* __restrict treeSplitsCurPtr,
     int curTreeSize);
 
-TTreeCalcFunction GetCalcTreesFunction(const TFullModel& model, size_t docCountInBlock);
+/**
+ * Returns trees evaluation function for blocks of docCountInBlock documents.
+ * With depthSpecialized full blocks are evaluated by kernels instantiated for each tree depth,
+ * using tree depth groups cached in model metadata; results are identical to generic evaluation.
+ * Models with reduced LeafValuesPrecision are always evaluated by compact leaf values kernels.
+ */
+TTreeCalcFunction GetCalcTreesFunction(
+    const TFullModel& model,
+    size_t docCountInBlock,
+    EFormulaEvaluatorKernel kernel,
+    bool depthSpecialized = true);
+
+inline TTreeCalcFunction GetCalcTreesFunction(const TFullModel& model, size_t docCountInBlock) {
+    return GetCalcTreesFunction(model, docCountInBlock, GetBestFormulaEvaluatorKernel());
+}
+
+/**
+ * Calculates leaf indexes of trees [treeStart, treeEnd) for block of binarized documents.
+ * @param[in] docCountInBlock should not exceed FORMULA_EVALUATION_BLOCK_SIZE
+ * @param[out] treeLeafIndexes indexation is [docId * (treeEnd - treeStart) + treeId - treeStart],
+ * TLeafIndex (ui8, ui16 or ui32) should fit leaf indexes of all trees in range
+ */
+template<typename TLeafIndex>
+void CalcLeafIndexesBlock(
+    const TFullModel& model,
+    const ui8* binFeatures,
+    size_t docCountInBlock,
+    size_t treeStart,
+    size_t treeEnd,
+    TLeafIndex* treeLeafIndexes,
+    EFormulaEvaluatorKernel kernel);
 
 template<class X>
 inline X* GetAligned(X* val) {
@@ -348,6 +339,257 @@ inline void CalcGeneric(
 }
 
 
+/**
+ * CalcGeneric over documents split between executor threads.
+ * Each thread evaluates a contiguous range of FORMULA_EVALUATION_BLOCK_SIZE aligned blocks,
+ * reading features through shifted accessors and writing directly into its part of results.
+ */
+template<typename TFloatFeatureAccessor, typename TCatFeatureAccessor>
+inline void CalcGenericParallel(
+    const TFullModel& model,
+    TFloatFeatureAccessor floatFeatureAccessor,
+    TCatFeatureAccessor catFeaturesAccessor,
+    size_t docCount,
+    size_t treeStart,
+    size_t treeEnd,
+    TArrayRef<double> results,
+    NPar::TLocalExecutor* executor)
+{
+    const size_t blockCount = (docCount + FORMULA_EVALUATION_BLOCK_SIZE - 1) / FORMULA_EVALUATION_BLOCK_SIZE;
+    const size_t threadCount = executor ? executor->GetThreadCount() + 1 : 1; //one for current thread
+    if (threadCount == 1 || blockCount < 2) {
+        CalcGeneric(model, floatFeatureAccessor, catFeaturesAccessor, docCount, treeStart, treeEnd, results);
+        return;
+    }
+    const size_t approxDimension = model.ObliviousTrees.ApproxDimension;
+    CB_ENSURE(results.size() == docCount * approxDimension);
+    const size_t chunkCount = Min(threadCount, blockCount);
+    const size_t docsPerChunk = (blockCount + chunkCount - 1) / chunkCount * FORMULA_EVALUATION_BLOCK_SIZE;
+    executor->ExecRangeWithThrow([&](int chunkId) {
+        const size_t chunkStart = chunkId * docsPerChunk;
+        const size_t chunkEnd = Min(docCount, chunkStart + docsPerChunk);
+        if (chunkStart >= chunkEnd) {
+            return;
+        }
+        CalcGeneric(
+            model,
+            [chunkStart, &floatFeatureAccessor](const TFloatFeature& floatFeature, size_t index) {
+                return floatFeatureAccessor(floatFeature, chunkStart + index);
+            },
+            [chunkStart, &catFeaturesAccessor](const TCatFeature& catFeature, size_t index) {
+                return catFeaturesAccessor(catFeature, chunkStart + index);
+            },
+            chunkEnd - chunkStart,
+            treeStart,
+            treeEnd,
+            MakeArrayRef(results.data() + chunkStart * approxDimension, (chunkEnd - chunkStart) * approxDimension)
+        );
+    }, 0, chunkCount, NPar::TLocalExecutor::WAIT_COMPLETE);
+}
+
+/**
+ * Early exit evaluation of single class model against decision threshold.
+ * Trees are evaluated by chunks of treeChunkSize. After each chunk objects whose partial value plus
+ * min (max) leaf sum of remaining trees is above (not above) threshold are decided and removed from the block,
+ * binarized features of remaining objects are compacted, so next chunks are evaluated only for undecided ones.
+ * Bounds are widened by rounding slack. If some objects of the block are still close to threshold after
+ * the last chunk, the whole block is binarized again and evaluated exactly as CalcGeneric does (same block size
+ * and evaluation function), so their results are bitwise equal to CalcGeneric ones
+ * and results[i] > threshold always gives the same decision as CalcGeneric.
+ * @return number of evaluated (object, tree) pairs
+ */
+template<typename TFloatFeatureAccessor, typename TCatFeatureAccessor>
+inline size_t CalcGenericWithThreshold(
+    const TFullModel& model,
+    TFloatFeatureAccessor floatFeatureAccessor,
+    TCatFeatureAccessor catFeaturesAccessor,
+    size_t docCount,
+    size_t treeStart,
+    size_t treeEnd,
+    size_t treeChunkSize,
+    double threshold,
+    TArrayRef<double> results)
+{
+    const auto& trees = model.ObliviousTrees;
+    CB_ENSURE(trees.ApproxDimension == 1, "Early exit evaluation is supported only for single class models");
+    CB_ENSURE(treeStart <= treeEnd && treeEnd <= model.GetTreeCount(), "Incorrect tree range [" << treeStart << ", " << treeEnd << ")");
+    CB_ENSURE(treeChunkSize > 0, "Tree chunk size should be positive");
+    CB_ENSURE(results.size() == docCount, "Results size " << results.size() << " should be equal to " << docCount);
+    if (docCount == 0) {
+        return 0;
+    }
+    const size_t treeCount = treeEnd - treeStart;
+    const size_t chunkCount = (treeCount + treeChunkSize - 1) / treeChunkSize;
+    // remaining trees leaf sum bounds after each chunk
+    TVector<double> remainingMin(chunkCount);
+    TVector<double> remainingMax(chunkCount);
+    double leafAbsSum = 0.0;
+    {
+        const auto& treeMinLeafValues = trees.GetTreeMinLeafValues();
+        const auto& treeMaxLeafValues = trees.GetTreeMaxLeafValues();
+        double minSum = 0.0;
+        double maxSum = 0.0;
+        for (size_t chunkId = chunkCount; chunkId > 0; --chunkId) {
+            remainingMin[chunkId - 1] = minSum;
+            remainingMax[chunkId - 1] = maxSum;
+            const size_t chunkStart = treeStart + (chunkId - 1) * treeChunkSize;
+            for (size_t treeIdx = chunkStart; treeIdx < Min(chunkStart + treeChunkSize, treeEnd); ++treeIdx) {
+                minSum += treeMinLeafValues[treeIdx];
+                maxSum += treeMaxLeafValues[treeIdx];
+                leafAbsSum += Max(Abs(treeMinLeafValues[treeIdx]), Abs(treeMaxLeafValues[treeIdx]));
+            }
+        }
+    }
+    // partial sums, bounds and full evaluation differ by summation order, reduced precision leaves differ from exact ones
+    const double slack = 4.0 * (treeCount + 1) * std::numeric_limits<double>::epsilon() * leafAbsSum
+        + trees.GetLeafValuesMaxAbsError();
+
+    const size_t blockSize = Min(FORMULA_EVALUATION_BLOCK_SIZE, docCount);
+    const size_t bucketCount = trees.GetEffectiveBinaryFeaturesBucketsCount();
+    // blocked evaluation function is used even for single object, active objects count changes between chunks
+    auto calcTrees = GetCalcTreesFunction(model, FORMULA_EVALUATION_BLOCK_SIZE);
+    // same choice as in CalcGeneric for reevaluation of undecided objects
+    auto exactCalcTrees = GetCalcTreesFunction(model, blockSize);
+    TVector<ui8> binFeatures(blockSize * bucketCount);
+    TVector<TCalcerIndexType> indexesVec(blockSize);
+    TVector<int> transposedHash(blockSize * trees.CatFeatures.size());
+    TVector<float> ctrs(trees.GetUsedModelCtrs().size() * blockSize);
+    TVector<double> partialResults(blockSize);
+    TVector<ui32> activeDocs(blockSize);
+    TVector<ui32> keptPositions(blockSize);
+    size_t evaluatedTreeCount = 0;
+    for (size_t blockStart = 0; blockStart < docCount; blockStart += blockSize) {
+        const auto docCountInBlock = Min(blockSize, docCount - blockStart);
+        BinarizeFeatures(
+            model,
+            floatFeatureAccessor,
+            catFeaturesAccessor,
+            blockStart,
+            blockStart + docCountInBlock,
+            binFeatures,
+            transposedHash,
+            ctrs
+        );
+        size_t activeCount = docCountInBlock;
+        Iota(activeDocs.begin(), activeDocs.begin() + activeCount, 0);
+        std::fill(partialResults.begin(), partialResults.begin() + activeCount, 0.0);
+        for (size_t chunkId = 0; chunkId < chunkCount && activeCount > 0; ++chunkId) {
+            const size_t chunkStart = treeStart + chunkId * treeChunkSize;
+            const size_t chunkEnd = Min(chunkStart + treeChunkSize, treeEnd);
+            calcTrees(model, binFeatures.data(), activeCount, indexesVec.data(), chunkStart, chunkEnd, partialResults.data());
+            evaluatedTreeCount += activeCount * (chunkEnd - chunkStart);
+            size_t keptCount = 0;
+            for (size_t i = 0; i < activeCount; ++i) {
+                const double lowerBound = partialResults[i] + remainingMin[chunkId];
+                const double upperBound = partialResults[i] + remainingMax[chunkId];
+                if (lowerBound > threshold + slack) {
+                    results[blockStart + activeDocs[i]] = lowerBound;
+                } else if (upperBound <= threshold - slack) {
+                    results[blockStart + activeDocs[i]] = upperBound;
+                } else {
+                    activeDocs[keptCount] = activeDocs[i];
+                    partialResults[keptCount] = partialResults[i];
+                    keptPositions[keptCount] = i;
+                    ++keptCount;
+                }
+            }
+            if (keptCount != activeCount && keptCount > 0) {
+                // in place compaction is safe: destination offset never exceeds source offset
+                for (size_t bucketIdx = 0; bucketIdx < bucketCount; ++bucketIdx) {
+                    const ui8* src = binFeatures.data() + bucketIdx * activeCount;
+                    ui8* dst = binFeatures.data() + bucketIdx * keptCount;
+                    for (size_t i = 0; i < keptCount; ++i) {
+                        dst[i] = src[keptPositions[i]];
+                    }
+                }
+            }
+            activeCount = keptCount;
+        }
+        if (activeCount > 0) {
+            // compacted features are no longer needed, block is evaluated with the same shape as in CalcGeneric
+            BinarizeFeatures(
+                model,
+                floatFeatureAccessor,
+                catFeaturesAccessor,
+                blockStart,
+                blockStart + docCountInBlock,
+                binFeatures,
+                transposedHash,
+                ctrs
+            );
+            std::fill(partialResults.begin(), partialResults.begin() + docCountInBlock, 0.0);
+            exactCalcTrees(
+                model,
+                binFeatures.data(),
+                docCountInBlock,
+                docCount == 1 ? nullptr : indexesVec.data(),
+                treeStart,
+                treeEnd,
+                partialResults.data()
+            );
+            evaluatedTreeCount += docCountInBlock * treeCount;
+            for (size_t i = 0; i < activeCount; ++i) {
+                results[blockStart + activeDocs[i]] = partialResults[activeDocs[i]];
+            }
+        }
+    }
+    return evaluatedTreeCount;
+}
+
+/**
+ * Leaf indexes calculation with the same blocked binarization as CalcGeneric.
+ * Results indexation is [objectIndex * (treeEnd - treeStart) + treeIndex - treeStart].
+ */
+template<typename TLeafIndex, typename TFloatFeatureAccessor, typename TCatFeatureAccessor>
+inline void CalcLeafIndexesGeneric(
+    const TFullModel& model,
+    TFloatFeatureAccessor floatFeatureAccessor,
+    TCatFeatureAccessor catFeaturesAccessor,
+    size_t docCount,
+    size_t treeStart,
+    size_t treeEnd,
+    TArrayRef<TLeafIndex> treeLeafIndexes)
+{
+    CB_ENSURE(treeStart <= treeEnd && treeEnd <= model.GetTreeCount(), "Incorrect tree range [" << treeStart << ", " << treeEnd << ")");
+    const size_t treeCount = treeEnd - treeStart;
+    CB_ENSURE(treeLeafIndexes.size() == docCount * treeCount,
+              "Leaf indexes size " << treeLeafIndexes.size() << " should be equal to " << docCount * treeCount);
+    const int maxTreeDepth = treeCount == 0 ? 0 : *MaxElement(
+        model.ObliviousTrees.TreeSizes.begin() + treeStart,
+        model.ObliviousTrees.TreeSizes.begin() + treeEnd);
+    CB_ENSURE(maxTreeDepth <= (int)(sizeof(TLeafIndex) * 8), "Leaf index type is too narrow for tree depth " << maxTreeDepth);
+    if (docCount == 0 || treeCount == 0) {
+        return;
+    }
+    const size_t blockSize = Min(FORMULA_EVALUATION_BLOCK_SIZE, docCount);
+    const auto kernel = blockSize == 1 ? EFormulaEvaluatorKernel::Basic : GetBestFormulaEvaluatorKernel();
+    TVector<ui8> binFeatures(blockSize * model.ObliviousTrees.GetEffectiveBinaryFeaturesBucketsCount());
+    TVector<int> transposedHash(blockSize * model.ObliviousTrees.CatFeatures.size());
+    TVector<float> ctrs(model.ObliviousTrees.GetUsedModelCtrs().size() * blockSize);
+    for (size_t blockStart = 0; blockStart < docCount; blockStart += blockSize) {
+        const auto docCountInBlock = Min(blockSize, docCount - blockStart);
+        BinarizeFeatures(
+            model,
+            floatFeatureAccessor,
+            catFeaturesAccessor,
+            blockStart,
+            blockStart + docCountInBlock,
+            binFeatures,
+            transposedHash,
+            ctrs
+        );
+        CalcLeafIndexesBlock(
+            model,
+            binFeatures.data(),
+            docCountInBlock,
+            treeStart,
+            treeEnd,
+            treeLeafIndexes.data() + blockStart * treeCount,
+            kernel
+        );
+    }
+}
+
 /**
  * Warning: use aggressive caching. Stores all binarized features in RAM
  */
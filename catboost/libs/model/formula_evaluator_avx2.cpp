@@ -0,0 +1,250 @@
+#include "formula_evaluator_kernels.h"
+
+#include <util/system/yassert.h>
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+constexpr size_t AVX2_BLOCK_SIZE = 32;
+
+bool HasAvx2FormulaEvaluatorKernels() {
+    return true;
+}
+
+void BinarizeFloatsAvx2(
+    const float* __restrict values,
+    size_t docCount,
+    TConstArrayRef<float> borders,
+    ui8* __restrict result
+) {
+    const auto docCount32 = (docCount | 0x1f) ^ 0x1f;
+    // _mm256_packs_* work inside 128-bit lanes, so packed bytes come in dword order 0, 2, 4, 6, 1, 3, 5, 7
+    const __m256i unpackPermutation = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (size_t docId = 0; docId < docCount32; docId += AVX2_BLOCK_SIZE) {
+        const __m256 floats0 = _mm256_loadu_ps(values + docId + 0);
+        const __m256 floats1 = _mm256_loadu_ps(values + docId + 8);
+        const __m256 floats2 = _mm256_loadu_ps(values + docId + 16);
+        const __m256 floats3 = _mm256_loadu_ps(values + docId + 24);
+        __m256i resultVec = _mm256_setzero_si256();
+        for (const auto border : borders) {
+            const __m256 borderVec = _mm256_set1_ps(border);
+            const __m256i r0 = _mm256_castps_si256(_mm256_cmp_ps(floats0, borderVec, _CMP_GT_OQ));
+            const __m256i r1 = _mm256_castps_si256(_mm256_cmp_ps(floats1, borderVec, _CMP_GT_OQ));
+            const __m256i r2 = _mm256_castps_si256(_mm256_cmp_ps(floats2, borderVec, _CMP_GT_OQ));
+            const __m256i r3 = _mm256_castps_si256(_mm256_cmp_ps(floats3, borderVec, _CMP_GT_OQ));
+            const __m256i packed = _mm256_packs_epi16(_mm256_packs_epi32(r0, r1), _mm256_packs_epi32(r2, r3));
+            // packed bytes are 0xff (-1) for values greater than border
+            resultVec = _mm256_sub_epi8(resultVec, packed);
+        }
+        resultVec = _mm256_permutevar8x32_epi32(resultVec, unpackPermutation);
+        _mm256_storeu_si256((__m256i*)(result + docId), resultVec);
+    }
+    for (size_t docId = docCount32; docId < docCount; ++docId) {
+        const float val = values[docId];
+        for (const auto border : borders) {
+            result[docId] += (ui8)(val > border);
+        }
+    }
+}
+
+constexpr size_t AVX2_SEARCH_CHAIN_COUNT = 4;
+
+void BinarizeFloatsBinarySearchAvx2(
+    const float* __restrict values,
+    size_t docCount,
+    TConstArrayRef<float> borders,
+    ui8* __restrict result
+) {
+    if (borders.empty()) {
+        memset(result, 0, docCount);
+        return;
+    }
+    const float* bordersPtr = borders.data();
+    const size_t docStep = 8 * AVX2_SEARCH_CHAIN_COUNT;
+    const auto docCountAligned = docCount - docCount % docStep;
+    for (size_t docId = 0; docId < docCountAligned; docId += docStep) {
+        // several independent search chains hide gather latency
+        __m256 vals[AVX2_SEARCH_CHAIN_COUNT];
+        __m256i idx[AVX2_SEARCH_CHAIN_COUNT];
+        for (size_t chain = 0; chain < AVX2_SEARCH_CHAIN_COUNT; ++chain) {
+            vals[chain] = _mm256_loadu_ps(values + docId + 8 * chain);
+            idx[chain] = _mm256_setzero_si256();
+        }
+        size_t n = borders.size();
+        while (n > 1) {
+            const size_t half = n / 2;
+            const __m256i halfVec = _mm256_set1_epi32((int)half);
+            for (size_t chain = 0; chain < AVX2_SEARCH_CHAIN_COUNT; ++chain) {
+                const __m256 candidate = _mm256_i32gather_ps(bordersPtr + half - 1, idx[chain], sizeof(float));
+                const __m256i isGreater = _mm256_castps_si256(_mm256_cmp_ps(vals[chain], candidate, _CMP_GT_OQ));
+                idx[chain] = _mm256_add_epi32(idx[chain], _mm256_and_si256(isGreater, halfVec));
+            }
+            n -= half;
+        }
+        for (size_t chain = 0; chain < AVX2_SEARCH_CHAIN_COUNT; ++chain) {
+            const __m256 candidate = _mm256_i32gather_ps(bordersPtr, idx[chain], sizeof(float));
+            // compare result is -1 for values greater than border
+            idx[chain] = _mm256_sub_epi32(idx[chain], _mm256_castps_si256(_mm256_cmp_ps(vals[chain], candidate, _CMP_GT_OQ)));
+            const __m128i packed16 = _mm_packus_epi32(_mm256_castsi256_si128(idx[chain]), _mm256_extracti128_si256(idx[chain], 1));
+            _mm_storel_epi64((__m128i*)(result + docId + 8 * chain), _mm_packus_epi16(packed16, packed16));
+        }
+    }
+    for (size_t docId = docCountAligned; docId < docCount; ++docId) {
+        const float val = values[docId];
+        const float* base = bordersPtr;
+        size_t n = borders.size();
+        while (n > 1) {
+            const size_t half = n / 2;
+            base = (val > base[half - 1]) ? base + half : base;
+            n -= half;
+        }
+        result[docId] = (ui8)((base - bordersPtr) + (val > *base));
+    }
+}
+
+template<bool NeedXorMask, size_t RegCount>
+Y_FORCE_INLINE static void CalcIndexesAvx2Regs(
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    size_t docOffset,
+    ui8* __restrict indexesVec,
+    const TRepackedBin* __restrict treeSplitsCurPtr,
+    int curTreeSize
+) {
+    __m256i indexes[RegCount];
+    for (size_t reg = 0; reg < RegCount; ++reg) {
+        indexes[reg] = _mm256_setzero_si256();
+    }
+    __m256i mask = _mm256_set1_epi8(0x01);
+    for (int depth = 0; depth < curTreeSize; ++depth) {
+        const ui8* __restrict binFeaturePtr = binFeatures + treeSplitsCurPtr[depth].FeatureIndex * docCountInBlock + docOffset;
+        const __m256i borderValVec = _mm256_set1_epi8(treeSplitsCurPtr[depth].SplitIdx);
+        const __m256i xorMaskVec = _mm256_set1_epi8(treeSplitsCurPtr[depth].XorMask);
+        for (size_t reg = 0; reg < RegCount; ++reg) {
+            __m256i val = _mm256_loadu_si256((const __m256i*)(binFeaturePtr + AVX2_BLOCK_SIZE * reg));
+            if (NeedXorMask) {
+                val = _mm256_xor_si256(val, xorMaskVec);
+            }
+            // unsigned val >= border
+            const __m256i isGreaterOrEqual = _mm256_cmpeq_epi8(_mm256_max_epu8(val, borderValVec), val);
+            indexes[reg] = _mm256_or_si256(indexes[reg], _mm256_and_si256(isGreaterOrEqual, mask));
+        }
+        mask = _mm256_slli_epi16(mask, 1);
+    }
+    for (size_t reg = 0; reg < RegCount; ++reg) {
+        _mm256_storeu_si256((__m256i*)(indexesVec + docOffset + AVX2_BLOCK_SIZE * reg), indexes[reg]);
+    }
+}
+
+template<bool NeedXorMask>
+Y_FORCE_INLINE static void CalcIndexesAvx2Impl(
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    ui8* __restrict indexesVec,
+    const TRepackedBin* __restrict treeSplitsCurPtr,
+    int curTreeSize
+) {
+    Y_ASSERT(curTreeSize <= 8);
+    size_t docOffset = 0;
+    for (; docOffset + 4 * AVX2_BLOCK_SIZE <= docCountInBlock; docOffset += 4 * AVX2_BLOCK_SIZE) {
+        CalcIndexesAvx2Regs<NeedXorMask, 4>(binFeatures, docCountInBlock, docOffset, indexesVec, treeSplitsCurPtr, curTreeSize);
+    }
+    switch ((docCountInBlock - docOffset) / AVX2_BLOCK_SIZE) {
+    case 3:
+        CalcIndexesAvx2Regs<NeedXorMask, 3>(binFeatures, docCountInBlock, docOffset, indexesVec, treeSplitsCurPtr, curTreeSize);
+        docOffset += 3 * AVX2_BLOCK_SIZE;
+        break;
+    case 2:
+        CalcIndexesAvx2Regs<NeedXorMask, 2>(binFeatures, docCountInBlock, docOffset, indexesVec, treeSplitsCurPtr, curTreeSize);
+        docOffset += 2 * AVX2_BLOCK_SIZE;
+        break;
+    case 1:
+        CalcIndexesAvx2Regs<NeedXorMask, 1>(binFeatures, docCountInBlock, docOffset, indexesVec, treeSplitsCurPtr, curTreeSize);
+        docOffset += AVX2_BLOCK_SIZE;
+        break;
+    default:
+        break;
+    }
+    if (docOffset == docCountInBlock) {
+        return;
+    }
+    for (int depth = 0; depth < curTreeSize; ++depth) {
+        const ui8 borderVal = (ui8)(treeSplitsCurPtr[depth].SplitIdx);
+        const ui8 xorMask = NeedXorMask ? treeSplitsCurPtr[depth].XorMask : 0;
+        const ui8* __restrict binFeaturePtr = binFeatures + treeSplitsCurPtr[depth].FeatureIndex * docCountInBlock;
+        for (size_t docId = docOffset; docId < docCountInBlock; ++docId) {
+            indexesVec[docId] |= ((binFeaturePtr[docId] ^ xorMask) >= borderVal) << depth;
+        }
+    }
+}
+
+void CalcIndexesAvx2(
+    bool needXorMask,
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    ui8* __restrict indexesVec,
+    const TRepackedBin* __restrict treeSplitsCurPtr,
+    int curTreeSize
+) {
+    if (needXorMask) {
+        CalcIndexesAvx2Impl<true>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
+    } else {
+        CalcIndexesAvx2Impl<false>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
+    }
+}
+
+template<bool NeedXorMask, int Depth>
+static void CalcIndexesAvx2FixedDepth(
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    ui8* __restrict indexesVec,
+    const TRepackedBin* __restrict treeSplitsCurPtr
+) {
+    // constant depth is propagated into inlined implementation, so loop over tree levels is unrolled
+    CalcIndexesAvx2Impl<NeedXorMask>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, Depth);
+}
+
+template<bool NeedXorMask>
+static TCalcIndexesKernel GetCalcIndexesAvx2FixedDepthKernel(int depth) {
+    switch (depth) {
+        case 0: return CalcIndexesAvx2FixedDepth<NeedXorMask, 0>;
+        case 1: return CalcIndexesAvx2FixedDepth<NeedXorMask, 1>;
+        case 2: return CalcIndexesAvx2FixedDepth<NeedXorMask, 2>;
+        case 3: return CalcIndexesAvx2FixedDepth<NeedXorMask, 3>;
+        case 4: return CalcIndexesAvx2FixedDepth<NeedXorMask, 4>;
+        case 5: return CalcIndexesAvx2FixedDepth<NeedXorMask, 5>;
+        case 6: return CalcIndexesAvx2FixedDepth<NeedXorMask, 6>;
+        case 7: return CalcIndexesAvx2FixedDepth<NeedXorMask, 7>;
+        case 8: return CalcIndexesAvx2FixedDepth<NeedXorMask, 8>;
+        default: Y_FAIL("Depth specialized kernels support only trees with depth <= 8");
+    }
+}
+
+TCalcIndexesKernel GetCalcIndexesAvx2Kernel(bool needXorMask, int depth) {
+    return needXorMask ? GetCalcIndexesAvx2FixedDepthKernel<true>(depth) : GetCalcIndexesAvx2FixedDepthKernel<false>(depth);
+}
+
+#else
+
+bool HasAvx2FormulaEvaluatorKernels() {
+    return false;
+}
+
+void BinarizeFloatsAvx2(const float* __restrict, size_t, TConstArrayRef<float>, ui8* __restrict) {
+    Y_FAIL("AVX2 formula evaluator kernels are not compiled in this build");
+}
+
+void BinarizeFloatsBinarySearchAvx2(const float* __restrict, size_t, TConstArrayRef<float>, ui8* __restrict) {
+    Y_FAIL("AVX2 formula evaluator kernels are not compiled in this build");
+}
+
+void CalcIndexesAvx2(bool, const ui8* __restrict, size_t, ui8* __restrict, const TRepackedBin* __restrict, int) {
+    Y_FAIL("AVX2 formula evaluator kernels are not compiled in this build");
+}
+
+TCalcIndexesKernel GetCalcIndexesAvx2Kernel(bool, int) {
+    Y_FAIL("AVX2 formula evaluator kernels are not compiled in this build");
+}
+
+#endif
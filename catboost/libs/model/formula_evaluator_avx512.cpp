@@ -0,0 +1,245 @@
+#include "formula_evaluator_kernels.h"
+
+#include <util/system/yassert.h>
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+
+#include <immintrin.h>
+
+constexpr size_t AVX512_BLOCK_SIZE = 64;
+
+bool HasAvx512FormulaEvaluatorKernels() {
+    return true;
+}
+
+static inline __mmask64 GetTailMask(size_t docCount) {
+    Y_ASSERT(docCount < AVX512_BLOCK_SIZE);
+    return _cvtu64_mask64((1ull << docCount) - 1);
+}
+
+static inline __mmask16 GetFloatsTailMask(size_t docCount, size_t part) {
+    if (docCount <= part * 16) {
+        return 0;
+    }
+    const size_t count = Min<size_t>(docCount - part * 16, 16);
+    return (__mmask16)((1u << count) - 1);
+}
+
+void BinarizeFloatsAvx512(
+    const float* __restrict values,
+    size_t docCount,
+    TConstArrayRef<float> borders,
+    ui8* __restrict result
+) {
+    const __m512i one = _mm512_set1_epi8(1);
+    for (size_t docId = 0; docId < docCount; docId += AVX512_BLOCK_SIZE) {
+        const size_t docCountInStep = Min(AVX512_BLOCK_SIZE, docCount - docId);
+        __m512 floats0, floats1, floats2, floats3;
+        if (docCountInStep == AVX512_BLOCK_SIZE) {
+            floats0 = _mm512_loadu_ps(values + docId + 0);
+            floats1 = _mm512_loadu_ps(values + docId + 16);
+            floats2 = _mm512_loadu_ps(values + docId + 32);
+            floats3 = _mm512_loadu_ps(values + docId + 48);
+        } else {
+            // masked loads never touch memory outside of values array
+            floats0 = _mm512_maskz_loadu_ps(GetFloatsTailMask(docCountInStep, 0), values + docId + 0);
+            floats1 = _mm512_maskz_loadu_ps(GetFloatsTailMask(docCountInStep, 1), values + docId + 16);
+            floats2 = _mm512_maskz_loadu_ps(GetFloatsTailMask(docCountInStep, 2), values + docId + 32);
+            floats3 = _mm512_maskz_loadu_ps(GetFloatsTailMask(docCountInStep, 3), values + docId + 48);
+        }
+        __m512i resultVec = _mm512_setzero_si512();
+        for (const auto border : borders) {
+            const __m512 borderVec = _mm512_set1_ps(border);
+            const __mmask16 m0 = _mm512_cmp_ps_mask(floats0, borderVec, _CMP_GT_OQ);
+            const __mmask16 m1 = _mm512_cmp_ps_mask(floats1, borderVec, _CMP_GT_OQ);
+            const __mmask16 m2 = _mm512_cmp_ps_mask(floats2, borderVec, _CMP_GT_OQ);
+            const __mmask16 m3 = _mm512_cmp_ps_mask(floats3, borderVec, _CMP_GT_OQ);
+            const __mmask64 isGreater = _mm512_kunpackd(
+                _mm512_kunpackw(m3, m2),
+                _mm512_kunpackw(m1, m0)
+            );
+            resultVec = _mm512_mask_add_epi8(resultVec, isGreater, resultVec, one);
+        }
+        if (docCountInStep == AVX512_BLOCK_SIZE) {
+            _mm512_storeu_si512((__m512i*)(result + docId), resultVec);
+        } else {
+            _mm512_mask_storeu_epi8(result + docId, GetTailMask(docCountInStep), resultVec);
+        }
+    }
+}
+
+constexpr size_t AVX512_SEARCH_CHAIN_COUNT = 4;
+
+void BinarizeFloatsBinarySearchAvx512(
+    const float* __restrict values,
+    size_t docCount,
+    TConstArrayRef<float> borders,
+    ui8* __restrict result
+) {
+    if (borders.empty()) {
+        memset(result, 0, docCount);
+        return;
+    }
+    const float* bordersPtr = borders.data();
+    const size_t docStep = 16 * AVX512_SEARCH_CHAIN_COUNT;
+    for (size_t docId = 0; docId < docCount; docId += docStep) {
+        const size_t docCountInStep = Min(docStep, docCount - docId);
+        // several independent search chains hide gather latency
+        __m512 vals[AVX512_SEARCH_CHAIN_COUNT];
+        __m512i idx[AVX512_SEARCH_CHAIN_COUNT];
+        for (size_t chain = 0; chain < AVX512_SEARCH_CHAIN_COUNT; ++chain) {
+            // tail lanes are searched for zero value, index always stays inside borders array
+            vals[chain] = _mm512_maskz_loadu_ps(GetFloatsTailMask(docCountInStep, chain), values + docId + 16 * chain);
+            idx[chain] = _mm512_setzero_si512();
+        }
+        size_t n = borders.size();
+        while (n > 1) {
+            const size_t half = n / 2;
+            const __m512i halfVec = _mm512_set1_epi32((int)half);
+            for (size_t chain = 0; chain < AVX512_SEARCH_CHAIN_COUNT; ++chain) {
+                const __m512 candidate = _mm512_i32gather_ps(idx[chain], bordersPtr + half - 1, sizeof(float));
+                const __mmask16 isGreater = _mm512_cmp_ps_mask(vals[chain], candidate, _CMP_GT_OQ);
+                idx[chain] = _mm512_mask_add_epi32(idx[chain], isGreater, idx[chain], halfVec);
+            }
+            n -= half;
+        }
+        const __m512i one = _mm512_set1_epi32(1);
+        for (size_t chain = 0; chain < AVX512_SEARCH_CHAIN_COUNT; ++chain) {
+            const __m512 candidate = _mm512_i32gather_ps(idx[chain], bordersPtr, sizeof(float));
+            const __mmask16 isGreater = _mm512_cmp_ps_mask(vals[chain], candidate, _CMP_GT_OQ);
+            idx[chain] = _mm512_mask_add_epi32(idx[chain], isGreater, idx[chain], one);
+            _mm512_mask_cvtepi32_storeu_epi8(result + docId + 16 * chain, GetFloatsTailMask(docCountInStep, chain), idx[chain]);
+        }
+    }
+}
+
+template<bool NeedXorMask, size_t RegCount>
+Y_FORCE_INLINE static void CalcIndexesAvx512Regs(
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    size_t docOffset,
+    __mmask64 lastRegMask,
+    ui8* __restrict indexesVec,
+    const TRepackedBin* __restrict treeSplitsCurPtr,
+    int curTreeSize
+) {
+    __m512i indexes[RegCount];
+    for (size_t reg = 0; reg < RegCount; ++reg) {
+        indexes[reg] = _mm512_setzero_si512();
+    }
+    __m512i bit = _mm512_set1_epi8(0x01);
+    for (int depth = 0; depth < curTreeSize; ++depth) {
+        const ui8* __restrict binFeaturePtr = binFeatures + treeSplitsCurPtr[depth].FeatureIndex * docCountInBlock + docOffset;
+        const __m512i borderValVec = _mm512_set1_epi8(treeSplitsCurPtr[depth].SplitIdx);
+        const __m512i xorMaskVec = _mm512_set1_epi8(treeSplitsCurPtr[depth].XorMask);
+        for (size_t reg = 0; reg < RegCount; ++reg) {
+            const __mmask64 loadMask = (reg + 1 == RegCount) ? lastRegMask : ~(__mmask64)0;
+            __m512i val = _mm512_maskz_loadu_epi8(loadMask, binFeaturePtr + AVX512_BLOCK_SIZE * reg);
+            if (NeedXorMask) {
+                val = _mm512_xor_si512(val, xorMaskVec);
+            }
+            const __mmask64 isGreaterOrEqual = _mm512_cmpge_epu8_mask(val, borderValVec);
+            // bits for different depths never intersect, so add works as or
+            indexes[reg] = _mm512_mask_add_epi8(indexes[reg], isGreaterOrEqual, indexes[reg], bit);
+        }
+        bit = _mm512_add_epi8(bit, bit);
+    }
+    for (size_t reg = 0; reg < RegCount; ++reg) {
+        const __mmask64 storeMask = (reg + 1 == RegCount) ? lastRegMask : ~(__mmask64)0;
+        _mm512_mask_storeu_epi8(indexesVec + docOffset + AVX512_BLOCK_SIZE * reg, storeMask, indexes[reg]);
+    }
+}
+
+template<bool NeedXorMask>
+Y_FORCE_INLINE static void CalcIndexesAvx512Impl(
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    ui8* __restrict indexesVec,
+    const TRepackedBin* __restrict treeSplitsCurPtr,
+    int curTreeSize
+) {
+    Y_ASSERT(curTreeSize <= 8);
+    const __mmask64 fullMask = ~(__mmask64)0;
+    size_t docOffset = 0;
+    for (; docOffset + 2 * AVX512_BLOCK_SIZE <= docCountInBlock; docOffset += 2 * AVX512_BLOCK_SIZE) {
+        CalcIndexesAvx512Regs<NeedXorMask, 2>(binFeatures, docCountInBlock, docOffset, fullMask, indexesVec, treeSplitsCurPtr, curTreeSize);
+    }
+    const size_t docsLeft = docCountInBlock - docOffset;
+    if (docsLeft > AVX512_BLOCK_SIZE) {
+        const __mmask64 lastRegMask = docsLeft == 2 * AVX512_BLOCK_SIZE ? fullMask : GetTailMask(docsLeft - AVX512_BLOCK_SIZE);
+        CalcIndexesAvx512Regs<NeedXorMask, 2>(binFeatures, docCountInBlock, docOffset, lastRegMask, indexesVec, treeSplitsCurPtr, curTreeSize);
+    } else if (docsLeft > 0) {
+        const __mmask64 lastRegMask = docsLeft == AVX512_BLOCK_SIZE ? fullMask : GetTailMask(docsLeft);
+        CalcIndexesAvx512Regs<NeedXorMask, 1>(binFeatures, docCountInBlock, docOffset, lastRegMask, indexesVec, treeSplitsCurPtr, curTreeSize);
+    }
+}
+
+void CalcIndexesAvx512(
+    bool needXorMask,
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    ui8* __restrict indexesVec,
+    const TRepackedBin* __restrict treeSplitsCurPtr,
+    int curTreeSize
+) {
+    if (needXorMask) {
+        CalcIndexesAvx512Impl<true>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
+    } else {
+        CalcIndexesAvx512Impl<false>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
+    }
+}
+
+template<bool NeedXorMask, int Depth>
+static void CalcIndexesAvx512FixedDepth(
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    ui8* __restrict indexesVec,
+    const TRepackedBin* __restrict treeSplitsCurPtr
+) {
+    // constant depth is propagated into inlined implementation, so loop over tree levels is unrolled
+    CalcIndexesAvx512Impl<NeedXorMask>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, Depth);
+}
+
+template<bool NeedXorMask>
+static TCalcIndexesKernel GetCalcIndexesAvx512FixedDepthKernel(int depth) {
+    switch (depth) {
+        case 0: return CalcIndexesAvx512FixedDepth<NeedXorMask, 0>;
+        case 1: return CalcIndexesAvx512FixedDepth<NeedXorMask, 1>;
+        case 2: return CalcIndexesAvx512FixedDepth<NeedXorMask, 2>;
+        case 3: return CalcIndexesAvx512FixedDepth<NeedXorMask, 3>;
+        case 4: return CalcIndexesAvx512FixedDepth<NeedXorMask, 4>;
+        case 5: return CalcIndexesAvx512FixedDepth<NeedXorMask, 5>;
+        case 6: return CalcIndexesAvx512FixedDepth<NeedXorMask, 6>;
+        case 7: return CalcIndexesAvx512FixedDepth<NeedXorMask, 7>;
+        case 8: return CalcIndexesAvx512FixedDepth<NeedXorMask, 8>;
+        default: Y_FAIL("Depth specialized kernels support only trees with depth <= 8");
+    }
+}
+
+TCalcIndexesKernel GetCalcIndexesAvx512Kernel(bool needXorMask, int depth) {
+    return needXorMask ? GetCalcIndexesAvx512FixedDepthKernel<true>(depth) : GetCalcIndexesAvx512FixedDepthKernel<false>(depth);
+}
+
+#else
+
+bool HasAvx512FormulaEvaluatorKernels() {
+    return false;
+}
+
+void BinarizeFloatsAvx512(const float* __restrict, size_t, TConstArrayRef<float>, ui8* __restrict) {
+    Y_FAIL("AVX-512 formula evaluator kernels are not compiled in this build");
+}
+
+void BinarizeFloatsBinarySearchAvx512(const float* __restrict, size_t, TConstArrayRef<float>, ui8* __restrict) {
+    Y_FAIL("AVX-512 formula evaluator kernels are not compiled in this build");
+}
+
+void CalcIndexesAvx512(bool, const ui8* __restrict, size_t, ui8* __restrict, const TRepackedBin* __restrict, int) {
+    Y_FAIL("AVX-512 formula evaluator kernels are not compiled in this build");
+}
+
+TCalcIndexesKernel GetCalcIndexesAvx512Kernel(bool, int) {
+    Y_FAIL("AVX-512 formula evaluator kernels are not compiled in this build");
+}
+
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+ * Internal header: instruction set specific formula evaluator kernels.
+ * AVX2 and AVX-512 kernels live in separate translation units compiled with corresponding flags,
+ * so they must be called only after runtime CPU check (see IsFormulaEvaluatorKernelSupported).
+ */
+
+#include "model.h"
+
+#include <util/generic/array_ref.h>
+
+/**
+ * Leaf indexes calculation for trees of one fixed depth <= 8, indexesVec should be zeroed before the call.
+ */
+using TCalcIndexesKernel = void(*)(
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    ui8* __restrict indexesVec,
+    const TRepackedBin* __restrict treeSplitsCurPtr);
+
+//! True if kernels were compiled with AVX2 support (false on non x86 platforms)
+bool HasAvx2FormulaEvaluatorKernels();
+
+void BinarizeFloatsAvx2(
+    const float* __restrict values,
+    size_t docCount,
+    TConstArrayRef<float> borders,
+    ui8* __restrict result);
+
+//! Branchless binary search over sorted borders, 8 documents per gather
+void BinarizeFloatsBinarySearchAvx2(
+    const float* __restrict values,
+    size_t docCount,
+    TConstArrayRef<float> borders,
+    ui8* __restrict result);
+
+/**
+ * Calculates leaf indexes of one tree with depth <= 8 for docCountInBlock documents.
+ * indexesVec should be zeroed before the call.
+ */
+void CalcIndexesAvx2(
+    bool needXorMask,
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    ui8* __restrict indexesVec,
+    const TRepackedBin* __restrict treeSplitsCurPtr,
+    int curTreeSize);
+
+//! CalcIndexesAvx2 specialized for trees of given depth
+TCalcIndexesKernel GetCalcIndexesAvx2Kernel(bool needXorMask, int depth);
+
+//! True if kernels were compiled with AVX-512F and AVX-512BW support
+bool HasAvx512FormulaEvaluatorKernels();
+
+void BinarizeFloatsAvx512(
+    const float* __restrict values,
+    size_t docCount,
+    TConstArrayRef<float> borders,
+    ui8* __restrict result);
+
+//! Branchless binary search over sorted borders, 16 documents per gather
+void BinarizeFloatsBinarySearchAvx512(
+    const float* __restrict values,
+    size_t docCount,
+    TConstArrayRef<float> borders,
+    ui8* __restrict result);
+
+void CalcIndexesAvx512(
+    bool needXorMask,
+    const ui8* __restrict binFeatures,
+    size_t docCountInBlock,
+    ui8* __restrict indexesVec,
+    const TRepackedBin* __restrict treeSplitsCurPtr,
+    int curTreeSize);
+
+//! CalcIndexesAvx512 specialized for trees of given depth
+TCalcIndexesKernel GetCalcIndexesAvx512Kernel(bool needXorMask, int depth);
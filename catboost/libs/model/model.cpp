@@ -19,6 +19,11 @@
 #include <util/stream/buffer.h>
 #include <util/stream/str.h>
 #include <util/stream/file.h>
+#include <util/stream/mem.h>
+#include <util/system/hp_timer.h>
+#include <util/generic/ymath.h>
+
+#include <cmath>
 
 static const char MODEL_FILE_DESCRIPTOR_CHARS[4] = {'C', 'B', 'M', '1'};
 
@@ -26,7 +31,9 @@ ui32 GetModelFormatDescriptor() {
     return *reinterpret_cast<const ui32*>(MODEL_FILE_DESCRIPTOR_CHARS);
 }
 
-static const char* CURRENT_CORE_FORMAT_STRING = "FlabuffersModel_v1";
+// models with ctr tables unreadable by older versions are saved with current format, so they are refused by them
+static const char* LEGACY_CORE_FORMAT_STRING = "FlabuffersModel_v1";
+static const char* CURRENT_CORE_FORMAT_STRING = "FlabuffersModel_v2";
 
 void OutputModel(const TFullModel& model, const TString& modelFile) {
     TOFStream f(modelFile);
@@ -59,13 +66,17 @@ static NJson::TJsonValue RemoveInvalidParams(const NJson::TJsonValue& params) {
     return result;
 }
 
+static void RemoveInvalidModelParams(TFullModel* model) {
+    NJson::TJsonValue paramsJson = ReadTJsonValue(model->ModelInfo.at("params"));
+    paramsJson["flat_params"] = RemoveInvalidParams(paramsJson["flat_params"]);
+    model->ModelInfo["params"] = ToString<NJson::TJsonValue>(paramsJson);
+}
+
 TFullModel ReadModel(IInputStream* modelStream, EModelType format) {
     TFullModel model;
     if (format == EModelType::CatboostBinary) {
         Load(modelStream, model);
-        NJson::TJsonValue paramsJson = ReadTJsonValue(model.ModelInfo.at("params"));
-        paramsJson["flat_params"] = RemoveInvalidParams(paramsJson["flat_params"]);
-        model.ModelInfo["params"] = ToString<NJson::TJsonValue>(paramsJson);
+        RemoveInvalidModelParams(&model);
     } else {
         CoreML::Specification::Model coreMLModel;
         CB_ENSURE(coreMLModel.ParseFromString(modelStream->ReadAll()), "coreml model deserialization failed");
@@ -79,6 +90,19 @@ TFullModel ReadModel(const TString& modelFile, EModelType format) {
     return ReadModel(&f, format);
 }
 
+TFullModel ReadModel(const TString& modelFile, const TModelLoadOptions& options, TModelLoadStats* stats) {
+    TFullModel model;
+    model.Load(TBlob::FromFile(modelFile), options, stats);
+    RemoveInvalidModelParams(&model);
+    return model;
+}
+
+TFullModel ReadModelMmap(const TString& modelFile) {
+    TModelLoadOptions options;
+    options.CtrTablesInPlace = true;
+    return ReadModel(modelFile, options);
+}
+
 TFullModel ReadModel(const void* binaryBuffer, size_t binaryBufferSize, EModelType format)  {
     TBuffer buf((char*)binaryBuffer, binaryBufferSize);
     TBufferInput bs(buf);
@@ -175,6 +199,41 @@ void TObliviousTrees::Truncate(size_t begin, size_t end) {
     UpdateMetadata();
 }
 
+void TObliviousTrees::ReorderTrees(const TVector<size_t>& order) {
+    CB_ENSURE(order.size() == TreeSizes.size(), "Tree order size " << order.size() << " should be equal to tree count " << TreeSizes.size());
+    TVector<bool> seen(order.size(), false);
+    for (size_t treeIdx : order) {
+        CB_ENSURE(treeIdx < order.size() && !seen[treeIdx], "Tree order should be a permutation");
+        seen[treeIdx] = true;
+    }
+    const auto& firstLeafOffsets = GetFirstLeafOffsets();
+    TVector<int> treeSplits;
+    TVector<int> treeSizes;
+    TVector<double> leafValues;
+    TVector<TVector<double>> leafWeights;
+    treeSplits.reserve(TreeSplits.size());
+    treeSizes.reserve(TreeSizes.size());
+    leafValues.reserve(LeafValues.size());
+    for (size_t treeIdx : order) {
+        const auto splitsBegin = TreeSplits.begin() + TreeStartOffsets[treeIdx];
+        treeSplits.insert(treeSplits.end(), splitsBegin, splitsBegin + TreeSizes[treeIdx]);
+        treeSizes.push_back(TreeSizes[treeIdx]);
+        const auto leafBegin = LeafValues.begin() + firstLeafOffsets[treeIdx];
+        leafValues.insert(leafValues.end(), leafBegin, leafBegin + (1 << TreeSizes[treeIdx]) * ApproxDimension);
+        if (!LeafWeights.empty()) {
+            leafWeights.push_back(std::move(LeafWeights[treeIdx]));
+        }
+    }
+    TreeSplits.swap(treeSplits);
+    TreeSizes.swap(treeSizes);
+    LeafValues.swap(leafValues);
+    LeafWeights.swap(leafWeights);
+    for (size_t i = 0; i < TreeSizes.size(); ++i) {
+        TreeStartOffsets[i] = i == 0 ? 0 : TreeStartOffsets[i - 1] + TreeSizes[i - 1];
+    }
+    UpdateMetadata();
+}
+
 flatbuffers::Offset<NCatBoostFbs::TObliviousTrees>
 TObliviousTrees::FBSerialize(TModelPartsCachingSerializer& serializer) const {
     std::vector<flatbuffers::Offset<NCatBoostFbs::TCatFeature>> catFeaturesOffsets;
@@ -230,6 +289,53 @@ void TObliviousTrees::UpdateMetadata() const {
     for (size_t i = 0; i < TreeSizes.size(); ++i) {
         ref.TreeFirstLeafOffsets[i] = currentOffset;
         currentOffset += (1 << TreeSizes[i]) * ApproxDimension;
+        if (ref.TreeDepthGroups.empty() || ref.TreeDepthGroups.back().Depth != TreeSizes[i]) {
+            ref.TreeDepthGroups.push_back(TTreeDepthGroup{i, i + 1, TreeSizes[i]});
+        } else {
+            ref.TreeDepthGroups.back().TreeEnd = i + 1;
+        }
+    }
+
+    if (ApproxDimension == 1) {
+        ref.TreeMinLeafValues.resize(TreeSizes.size());
+        ref.TreeMaxLeafValues.resize(TreeSizes.size());
+        for (size_t treeIdx = 0; treeIdx < TreeSizes.size(); ++treeIdx) {
+            const auto leafBegin = LeafValues.begin() + ref.TreeFirstLeafOffsets[treeIdx];
+            const auto leafEnd = leafBegin + (1 << TreeSizes[treeIdx]);
+            ref.TreeMinLeafValues[treeIdx] = *MinElement(leafBegin, leafEnd);
+            ref.TreeMaxLeafValues[treeIdx] = *MaxElement(leafBegin, leafEnd);
+        }
+    }
+
+    if (LeafValuesPrecision != ELeafValuesPrecision::Double) {
+        ref.TreeLeafScales.resize(TreeSizes.size(), 1.0);
+        if (LeafValuesPrecision == ELeafValuesPrecision::Float) {
+            ref.FloatLeafValues.assign(LeafValues.begin(), LeafValues.end());
+        } else {
+            ref.Int16LeafValues.resize(LeafValues.size());
+        }
+        for (size_t treeIdx = 0; treeIdx < TreeSizes.size(); ++treeIdx) {
+            const size_t leafStart = ref.TreeFirstLeafOffsets[treeIdx];
+            const size_t leafEnd = leafStart + (1 << TreeSizes[treeIdx]) * ApproxDimension;
+            double treeMaxError = 0.0;
+            if (LeafValuesPrecision == ELeafValuesPrecision::Int16) {
+                double maxAbsValue = 0.0;
+                for (size_t leafIdx = leafStart; leafIdx < leafEnd; ++leafIdx) {
+                    maxAbsValue = Max(maxAbsValue, Abs(LeafValues[leafIdx]));
+                }
+                const double scale = maxAbsValue > 0.0 ? maxAbsValue / Max<i16>() : 1.0;
+                ref.TreeLeafScales[treeIdx] = scale;
+                for (size_t leafIdx = leafStart; leafIdx < leafEnd; ++leafIdx) {
+                    ref.Int16LeafValues[leafIdx] = static_cast<i16>(std::round(LeafValues[leafIdx] / scale));
+                    treeMaxError = Max(treeMaxError, Abs(LeafValues[leafIdx] - ref.Int16LeafValues[leafIdx] * scale));
+                }
+            } else {
+                for (size_t leafIdx = leafStart; leafIdx < leafEnd; ++leafIdx) {
+                    treeMaxError = Max(treeMaxError, Abs(LeafValues[leafIdx] - ref.FloatLeafValues[leafIdx]));
+                }
+            }
+            ref.LeafValuesMaxAbsError += treeMaxError;
+        }
     }
 
     for (const auto& ctrFeature : CtrFeatures) {
@@ -291,14 +397,15 @@ void TObliviousTrees::UpdateMetadata() const {
 void TFullModel::CalcFlat(const TVector<TConstArrayRef<float>>& features,
                                  size_t treeStart,
                                  size_t treeEnd,
-                                 TArrayRef<double> results) const {
+                                 TArrayRef<double> results,
+                                 NPar::TLocalExecutor* executor) const {
     const auto expectedFlatVecSize = ObliviousTrees.GetFlatFeatureVectorExpectedSize();
     for (const auto& flatFeaturesVec : features) {
         CB_ENSURE(flatFeaturesVec.size() >= expectedFlatVecSize,
                   "insufficient flat features vector size: " << flatFeaturesVec.size()
                                                              << " expected: " << expectedFlatVecSize);
     }
-    CalcGeneric(
+    CalcGenericParallel(
         *this,
         [&features](const TFloatFeature& floatFeature, size_t index) -> float {
             return features[index][floatFeature.FlatFeatureIndex];
@@ -309,7 +416,8 @@ void TFullModel::CalcFlat(const TVector<TConstArrayRef<float>>& features,
         features.size(),
         treeStart,
         treeEnd,
-        results
+        results,
+        executor
     );
 }
 
@@ -332,9 +440,10 @@ void TFullModel::CalcFlatSingle(const TConstArrayRef<float>& features, size_t tr
 void TFullModel::CalcFlatTransposed(const TVector<TConstArrayRef<float>>& transposedFeatures,
                                            size_t treeStart,
                                            size_t treeEnd,
-                                           TArrayRef<double> results) const {
+                                           TArrayRef<double> results,
+                                           NPar::TLocalExecutor* executor) const {
     CB_ENSURE(!transposedFeatures.empty(), "Features should not be empty");
-    CalcGeneric(
+    CalcGenericParallel(
         *this,
         [&transposedFeatures](const TFloatFeature& floatFeature, size_t index) -> float {
             return transposedFeatures[floatFeature.FlatFeatureIndex][index];
@@ -345,7 +454,8 @@ void TFullModel::CalcFlatTransposed(const TVector<TConstArrayRef<float>>& transp
         transposedFeatures[0].Size(),
         treeStart,
         treeEnd,
-        results
+        results,
+        executor
     );
 }
 
@@ -353,7 +463,8 @@ void TFullModel::Calc(const TVector<TConstArrayRef<float>>& floatFeatures,
                       const TVector<TConstArrayRef<int>>& catFeatures,
                       size_t treeStart,
                       size_t treeEnd,
-                      TArrayRef<double> results) const {
+                      TArrayRef<double> results,
+                      NPar::TLocalExecutor* executor) const {
     if (!floatFeatures.empty() && !catFeatures.empty()) {
         CB_ENSURE(catFeatures.size() == floatFeatures.size());
     }
@@ -367,7 +478,7 @@ void TFullModel::Calc(const TVector<TConstArrayRef<float>>& floatFeatures,
                   "insufficient cat features vector size: " << catFeaturesVec.size()
                                                             << " expected: " << ObliviousTrees.GetNumCatFeatures());
     }
-    CalcGeneric(
+    CalcGenericParallel(
         *this,
         [&floatFeatures](const TFloatFeature& floatFeature, size_t index) -> float {
             return floatFeatures[index][floatFeature.FeatureIndex];
@@ -378,13 +489,14 @@ void TFullModel::Calc(const TVector<TConstArrayRef<float>>& floatFeatures,
         floatFeatures.size(),
         treeStart,
         treeEnd,
-        results
+        results,
+        executor
     );
 }
 
 void TFullModel::Calc(const TVector<TConstArrayRef<float>>& floatFeatures,
                              const TVector<TVector<TStringBuf>>& catFeatures, size_t treeStart, size_t treeEnd,
-                             TArrayRef<double> results) const {
+                             TArrayRef<double> results, NPar::TLocalExecutor* executor) const {
     if (!floatFeatures.empty() && !catFeatures.empty()) {
         CB_ENSURE(catFeatures.size() == floatFeatures.size());
     }
@@ -398,7 +510,7 @@ void TFullModel::Calc(const TVector<TConstArrayRef<float>>& floatFeatures,
                   "insufficient cat features vector size: " << catFeaturesVec.size()
                                                             << " expected: " << ObliviousTrees.GetNumCatFeatures());
     }
-    CalcGeneric(
+    CalcGenericParallel(
         *this,
         [&floatFeatures](const TFloatFeature& floatFeature, size_t index) -> float {
             return floatFeatures[index][floatFeature.FeatureIndex];
@@ -409,6 +521,169 @@ void TFullModel::Calc(const TVector<TConstArrayRef<float>>& floatFeatures,
         floatFeatures.size(),
         treeStart,
         treeEnd,
+        results,
+        executor
+    );
+}
+
+template<typename TLeafIndex>
+static void CalcLeafIndexesFlatImpl(
+    const TFullModel& model,
+    const TVector<TConstArrayRef<float>>& features,
+    size_t treeStart,
+    size_t treeEnd,
+    TArrayRef<TLeafIndex> treeLeafIndexes)
+{
+    const auto expectedFlatVecSize = model.ObliviousTrees.GetFlatFeatureVectorExpectedSize();
+    for (const auto& flatFeaturesVec : features) {
+        CB_ENSURE(flatFeaturesVec.size() >= expectedFlatVecSize,
+                  "insufficient flat features vector size: " << flatFeaturesVec.size()
+                                                             << " expected: " << expectedFlatVecSize);
+    }
+    CalcLeafIndexesGeneric(
+        model,
+        [&features](const TFloatFeature& floatFeature, size_t index) -> float {
+            return features[index][floatFeature.FlatFeatureIndex];
+        },
+        [&features](const TCatFeature& catFeature, size_t index) -> int {
+            return ConvertFloatCatFeatureToIntHash(features[index][catFeature.FlatFeatureIndex]);
+        },
+        features.size(),
+        treeStart,
+        treeEnd,
+        treeLeafIndexes
+    );
+}
+
+template<typename TLeafIndex>
+static void CalcLeafIndexesImpl(
+    const TFullModel& model,
+    const TVector<TConstArrayRef<float>>& floatFeatures,
+    const TVector<TConstArrayRef<int>>& catFeatures,
+    size_t treeStart,
+    size_t treeEnd,
+    TArrayRef<TLeafIndex> treeLeafIndexes)
+{
+    if (!floatFeatures.empty() && !catFeatures.empty()) {
+        CB_ENSURE(catFeatures.size() == floatFeatures.size());
+    }
+    for (const auto& floatFeaturesVec : floatFeatures) {
+        CB_ENSURE(floatFeaturesVec.size() >= model.ObliviousTrees.GetNumFloatFeatures(),
+                  "insufficient float features vector size: " << floatFeaturesVec.size()
+                                                              << " expected: " << model.ObliviousTrees.GetNumFloatFeatures());
+    }
+    for (const auto& catFeaturesVec : catFeatures) {
+        CB_ENSURE(catFeaturesVec.size() >= model.ObliviousTrees.GetNumCatFeatures(),
+                  "insufficient cat features vector size: " << catFeaturesVec.size()
+                                                            << " expected: " << model.ObliviousTrees.GetNumCatFeatures());
+    }
+    CalcLeafIndexesGeneric(
+        model,
+        [&floatFeatures](const TFloatFeature& floatFeature, size_t index) -> float {
+            return floatFeatures[index][floatFeature.FeatureIndex];
+        },
+        [&catFeatures](const TCatFeature& catFeature, size_t index) -> int {
+            return catFeatures[index][catFeature.FeatureIndex];
+        },
+        Max(floatFeatures.size(), catFeatures.size()),
+        treeStart,
+        treeEnd,
+        treeLeafIndexes
+    );
+}
+
+void TFullModel::CalcLeafIndexesFlat(const TVector<TConstArrayRef<float>>& features, size_t treeStart, size_t treeEnd, TArrayRef<ui8> treeLeafIndexes) const {
+    CalcLeafIndexesFlatImpl(*this, features, treeStart, treeEnd, treeLeafIndexes);
+}
+
+void TFullModel::CalcLeafIndexesFlat(const TVector<TConstArrayRef<float>>& features, size_t treeStart, size_t treeEnd, TArrayRef<ui16> treeLeafIndexes) const {
+    CalcLeafIndexesFlatImpl(*this, features, treeStart, treeEnd, treeLeafIndexes);
+}
+
+void TFullModel::CalcLeafIndexes(
+    const TVector<TConstArrayRef<float>>& floatFeatures,
+    const TVector<TConstArrayRef<int>>& catFeatures,
+    size_t treeStart,
+    size_t treeEnd,
+    TArrayRef<ui8> treeLeafIndexes) const {
+    CalcLeafIndexesImpl(*this, floatFeatures, catFeatures, treeStart, treeEnd, treeLeafIndexes);
+}
+
+void TFullModel::CalcLeafIndexes(
+    const TVector<TConstArrayRef<float>>& floatFeatures,
+    const TVector<TConstArrayRef<int>>& catFeatures,
+    size_t treeStart,
+    size_t treeEnd,
+    TArrayRef<ui16> treeLeafIndexes) const {
+    CalcLeafIndexesImpl(*this, floatFeatures, catFeatures, treeStart, treeEnd, treeLeafIndexes);
+}
+
+void TFullModel::SetCtrTablesIndexLayout(ECtrTableIndexLayout layout) {
+    if (!CtrProvider) {
+        return;
+    }
+    auto staticCtrProvider = dynamic_cast<TStaticCtrProvider*>(CtrProvider.Get());
+    CB_ENSURE(staticCtrProvider, "Ctr tables index layout can be changed only for static ctr provider");
+    staticCtrProvider->SetCtrTablesIndexLayout(layout);
+}
+
+void TFullModel::PrecomputeCtrValues(bool dropCounters) {
+    if (!CtrProvider || ObliviousTrees.CtrFeatures.empty()) {
+        return;
+    }
+    auto staticCtrProvider = dynamic_cast<TStaticCtrProvider*>(CtrProvider.Get());
+    CB_ENSURE(staticCtrProvider, "Ctr values can be precomputed only for static ctr provider");
+    staticCtrProvider->PrecomputeCtrValues(ObliviousTrees.CtrFeatures, dropCounters);
+}
+
+TVector<size_t> TFullModel::OptimizeTreeOrder() {
+    const auto& trees = ObliviousTrees;
+    const auto& repackedBins = trees.GetRepackedBins();
+    TVector<TVector<ui32>> treeFeatureBuckets(trees.TreeSizes.size());
+    for (size_t treeIdx = 0; treeIdx < trees.TreeSizes.size(); ++treeIdx) {
+        auto& buckets = treeFeatureBuckets[treeIdx];
+        for (int depth = 0; depth < trees.TreeSizes[treeIdx]; ++depth) {
+            buckets.push_back(repackedBins[trees.TreeStartOffsets[treeIdx] + depth].FeatureIndex);
+        }
+        Sort(buckets.begin(), buckets.end());
+        buckets.erase(Unique(buckets.begin(), buckets.end()), buckets.end());
+    }
+    TVector<size_t> order(trees.TreeSizes.size());
+    Iota(order.begin(), order.end(), 0);
+    StableSort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+        if (trees.TreeSizes[lhs] != trees.TreeSizes[rhs]) {
+            return trees.TreeSizes[lhs] < trees.TreeSizes[rhs];
+        }
+        return treeFeatureBuckets[lhs] < treeFeatureBuckets[rhs];
+    });
+    ObliviousTrees.ReorderTrees(order);
+    return order;
+}
+
+size_t TFullModel::CalcFlatWithThreshold(
+    const TVector<TConstArrayRef<float>>& features,
+    double threshold,
+    TArrayRef<double> results,
+    size_t treeChunkSize) const {
+    const auto expectedFlatVecSize = ObliviousTrees.GetFlatFeatureVectorExpectedSize();
+    for (const auto& flatFeaturesVec : features) {
+        CB_ENSURE(flatFeaturesVec.size() >= expectedFlatVecSize,
+                  "insufficient flat features vector size: " << flatFeaturesVec.size()
+                                                             << " expected: " << expectedFlatVecSize);
+    }
+    return CalcGenericWithThreshold(
+        *this,
+        [&features](const TFloatFeature& floatFeature, size_t index) -> float {
+            return features[index][floatFeature.FlatFeatureIndex];
+        },
+        [&features](const TCatFeature& catFeature, size_t index) -> int {
+            return ConvertFloatCatFeatureToIntHash(features[index][catFeature.FlatFeatureIndex]);
+        },
+        features.size(),
+        0,
+        ObliviousTrees.TreeSizes.size(),
+        treeChunkSize,
+        threshold,
         results
     );
 }
@@ -487,9 +762,10 @@ void TFullModel::Save(IOutputStream* s) const {
     if (!!CtrProvider && CtrProvider->IsSerializable()) {
         modelPartIds.push_back(serializer.FlatbufBuilder.CreateString(CtrProvider->ModelPartIdentifier()));
     }
+    const bool isLegacyFormatCompatible = !CtrProvider || !CtrProvider->IsSerializable() || CtrProvider->IsLegacyFormatCompatible();
     auto coreOffset = CreateTModelCoreDirect(
         serializer.FlatbufBuilder,
-        CURRENT_CORE_FORMAT_STRING,
+        isLegacyFormatCompatible ? LEGACY_CORE_FORMAT_STRING : CURRENT_CORE_FORMAT_STRING,
         obliviousTreesOffset,
         infoMap.empty() ? nullptr : &infoMap,
         modelPartIds.empty() ? nullptr : &modelPartIds
@@ -502,32 +778,31 @@ void TFullModel::Save(IOutputStream* s) const {
     }
 }
 
-void TFullModel::Load(IInputStream* s) {
+/**
+ * Deserializes model core flatbuffer, creates CtrProvider if model has ctr data part
+ * @return model part identifiers stored after the core
+ */
+static TVector<TString> LoadModelCore(const void* coreData, size_t coreSize, TFullModel* model) {
     using namespace flatbuffers;
     using namespace NCatBoostFbs;
-    ui32 fileDescriptor;
-    ::Load(s, fileDescriptor);
-    CB_ENSURE(fileDescriptor == GetModelFormatDescriptor(), "Incorrect model file descriptor");
-    auto coreSize = ::LoadSize(s);
-    TArrayHolder<ui8> arrayHolder = new ui8[coreSize];
-    s->LoadOrFail(arrayHolder.Get(), coreSize);
-
     {
-        flatbuffers::Verifier verifier(arrayHolder.Get(), coreSize);
+        flatbuffers::Verifier verifier(static_cast<const ui8*>(coreData), coreSize);
         CB_ENSURE(VerifyTModelCoreBuffer(verifier), "Flatbuffers model verification failed");
     }
-    auto fbModelCore = GetTModelCore(arrayHolder.Get());
+    auto fbModelCore = GetTModelCore(coreData);
+    CB_ENSURE(fbModelCore->FormatVersion(), "Model format version is not set");
+    const TString formatVersion = fbModelCore->FormatVersion()->c_str();
     CB_ENSURE(
-        fbModelCore->FormatVersion() && fbModelCore->FormatVersion()->str() == CURRENT_CORE_FORMAT_STRING,
-        "Unsupported model format: " << fbModelCore->FormatVersion()->str()
+        formatVersion == CURRENT_CORE_FORMAT_STRING || formatVersion == LEGACY_CORE_FORMAT_STRING,
+        "Unsupported model format: " << formatVersion
     );
     if (fbModelCore->ObliviousTrees()) {
-        ObliviousTrees.FBDeserialize(fbModelCore->ObliviousTrees());
+        model->ObliviousTrees.FBDeserialize(fbModelCore->ObliviousTrees());
     }
-    ModelInfo.clear();
+    model->ModelInfo.clear();
     if (fbModelCore->InfoMap()) {
         for (auto keyVal : *fbModelCore->InfoMap()) {
-            ModelInfo[keyVal->Key()->str()] = keyVal->Value()->str();
+            model->ModelInfo[keyVal->Key()->str()] = keyVal->Value()->str();
         }
     }
     TVector<TString> modelParts;
@@ -538,13 +813,52 @@ void TFullModel::Load(IInputStream* s) {
     }
     if (!modelParts.empty()) {
         CB_ENSURE(modelParts.size() == 1, "only single part model supported now");
-        CtrProvider = new TStaticCtrProvider;
-        CB_ENSURE(modelParts[0] == CtrProvider->ModelPartIdentifier(), "only static ctr models supported");
+        model->CtrProvider = new TStaticCtrProvider;
+        CB_ENSURE(modelParts[0] == model->CtrProvider->ModelPartIdentifier(), "only static ctr models supported");
+    }
+    return modelParts;
+}
+
+void TFullModel::Load(IInputStream* s) {
+    ui32 fileDescriptor;
+    ::Load(s, fileDescriptor);
+    CB_ENSURE(fileDescriptor == GetModelFormatDescriptor(), "Incorrect model file descriptor");
+    auto coreSize = ::LoadSize(s);
+    TArrayHolder<ui8> arrayHolder = new ui8[coreSize];
+    s->LoadOrFail(arrayHolder.Get(), coreSize);
+    if (!LoadModelCore(arrayHolder.Get(), coreSize, this).empty()) {
         CtrProvider->Load(s);
     }
     UpdateDynamicData();
 }
 
+void TFullModel::Load(const TBlob& blob, const TModelLoadOptions& options, TModelLoadStats* stats) {
+    THPTimer timer;
+    TMemoryInput in(blob.Data(), blob.Size());
+    ui32 fileDescriptor;
+    ::Load(&in, fileDescriptor);
+    CB_ENSURE(fileDescriptor == GetModelFormatDescriptor(), "Incorrect model file descriptor");
+    auto coreSize = ::LoadSize(&in);
+    CB_ENSURE(in.Avail() >= coreSize, "Unexpected end of model file");
+    const void* coreData = in.Buf();
+    in.Skip(coreSize);
+    const bool hasCtrData = !LoadModelCore(coreData, coreSize, this).empty();
+    if (stats) {
+        stats->CoreLoadSeconds = timer.PassedReset();
+    }
+    if (hasCtrData) {
+        auto ctrProvider = dynamic_cast<TStaticCtrProvider*>(CtrProvider.Get());
+        const size_t ctrDataOffset = blob.Size() - in.Avail();
+        ctrProvider->Load(&in, blob, options.CtrTablesInPlace, options.Executor);
+        if (stats) {
+            stats->CtrTablesLoadSeconds = timer.PassedReset();
+            stats->CtrTableCount = ctrProvider->CtrData.LearnCtrs.size();
+            stats->CtrTablesBytes = blob.Size() - in.Avail() - ctrDataOffset;
+        }
+    }
+    UpdateDynamicData();
+}
+
 TVector<TString> GetModelUsedFeaturesNames(const TFullModel& model) {
     TVector<int> featuresIdxs;
     TVector<TString> featuresNames;
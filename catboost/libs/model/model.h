@@ -12,7 +12,9 @@
 #include <catboost/libs/cat_feature/cat_feature.h>
 
 #include <library/json/json_reader.h>
+#include <library/threading/local_executor/local_executor.h>
 
+#include <util/memory/blob.h>
 #include <util/system/mutex.h>
 #include <util/stream/file.h>
 
@@ -45,6 +47,14 @@ struct TRepackedBin {
     ui8 XorMask = 0;
     ui8 SplitIdx = 0;
 };
+
+//! Maximal run of consecutive trees [TreeStart; TreeEnd) with equal depth
+struct TTreeDepthGroup {
+    size_t TreeStart = 0;
+    size_t TreeEnd = 0;
+    int Depth = 0;
+};
+
 struct TObliviousTrees {
 
     /**
@@ -78,6 +88,24 @@ struct TObliviousTrees {
 
         //! Offset of first tree leaf in flat tree leafs array
         TVector<size_t> TreeFirstLeafOffsets;
+
+        //! Trees grouped by depth in model order, used by depth specialized evaluation kernels
+        TVector<TTreeDepthGroup> TreeDepthGroups;
+
+        /**
+         * Reduced precision copy of LeafValues with the same layout, filled according to LeafValuesPrecision.
+         * Int16 leaf value is Int16LeafValues[i] * TreeLeafScales[treeIdx], float leaf scales are 1.
+         */
+        TVector<float> FloatLeafValues;
+        TVector<i16> Int16LeafValues;
+        TVector<double> TreeLeafScales;
+
+        //! Upper bound of absolute prediction difference between reduced precision and exact leaf values
+        double LeafValuesMaxAbsError = 0.0;
+
+        //! Minimal and maximal leaf value of each tree, filled only for single class models
+        TVector<double> TreeMinLeafValues;
+        TVector<double> TreeMaxLeafValues;
     };
 
     //! Number of classes in model, in most cases equals to 1.
@@ -98,6 +126,12 @@ struct TObliviousTrees {
     //! Leaf weights layout: [treeIndex][leafId]
     TVector<TVector<double>> LeafWeights;
 
+    /**
+     * Precision of leaf values used for model evaluation. Evaluation time only setting, it is not serialized,
+     * exact LeafValues are always kept in model.
+     */
+    ELeafValuesPrecision LeafValuesPrecision = ELeafValuesPrecision::Double;
+
     //! Categorical features, used in model in OneHot conditions or/and in CTR feature combinations
     TVector<TCatFeature> CatFeatures;
 
@@ -166,14 +200,10 @@ struct TObliviousTrees {
      * @param binSplits
      */
     void AddBinTree(const TVector<int>& binSplits) {
-        Y_ASSERT(TreeSplits.size() == TreeSizes.size() && TreeSizes.size() == TreeStartOffsets.size());
+        Y_ASSERT(TreeSizes.size() == TreeStartOffsets.size());
+        TreeStartOffsets.push_back(TreeSplits.ysize());
         TreeSplits.insert(TreeSplits.end(), binSplits.begin(), binSplits.end());
         TreeSizes.push_back(binSplits.ysize());
-        if (TreeStartOffsets.empty()) {
-            TreeStartOffsets.push_back(0);
-        } else {
-            TreeStartOffsets.push_back(TreeStartOffsets.back() + binSplits.ysize());
-        }
     }
 
     bool operator==(const TObliviousTrees& other) const {
@@ -202,6 +232,12 @@ struct TObliviousTrees {
     size_t GetTreeCount() const {
         return TreeSizes.size();
     }
+    /**
+     * Internal usage only. Permute trees so that new tree i is former tree order[i].
+     * TreeSplits, leaf values and leaf weights are rewritten contiguously in new order.
+     */
+    void ReorderTrees(const TVector<size_t>& order);
+
     /**
      * Truncate oblivous trees to contain only trees from [begin; end) interval.
      * @param begin
@@ -240,6 +276,52 @@ struct TObliviousTrees {
         return MetaData->TreeFirstLeafOffsets;
     }
 
+    const TVector<TTreeDepthGroup>& GetTreeDepthGroups() const {
+        Y_ENSURE(MetaData.Defined(), "metadata should be initialized");
+        return MetaData->TreeDepthGroups;
+    }
+
+    /**
+     * Switch evaluation to reduced precision leaf values: float32 or int16 with per tree scale.
+     * Smaller leaf arrays lower memory bandwidth and cache footprint of large forests.
+     * @return upper bound of absolute prediction error compared to exact leaf values
+     */
+    double SetLeafValuesPrecision(ELeafValuesPrecision precision) {
+        LeafValuesPrecision = precision;
+        UpdateMetadata();
+        return MetaData->LeafValuesMaxAbsError;
+    }
+
+    const TVector<float>& GetFloatLeafValues() const {
+        Y_ENSURE(MetaData.Defined(), "metadata should be initialized");
+        return MetaData->FloatLeafValues;
+    }
+
+    const TVector<i16>& GetInt16LeafValues() const {
+        Y_ENSURE(MetaData.Defined(), "metadata should be initialized");
+        return MetaData->Int16LeafValues;
+    }
+
+    const TVector<double>& GetTreeLeafScales() const {
+        Y_ENSURE(MetaData.Defined(), "metadata should be initialized");
+        return MetaData->TreeLeafScales;
+    }
+
+    double GetLeafValuesMaxAbsError() const {
+        Y_ENSURE(MetaData.Defined(), "metadata should be initialized");
+        return MetaData->LeafValuesMaxAbsError;
+    }
+
+    const TVector<double>& GetTreeMinLeafValues() const {
+        Y_ENSURE(MetaData.Defined(), "metadata should be initialized");
+        return MetaData->TreeMinLeafValues;
+    }
+
+    const TVector<double>& GetTreeMaxLeafValues() const {
+        Y_ENSURE(MetaData.Defined(), "metadata should be initialized");
+        return MetaData->TreeMaxLeafValues;
+    }
+
     const double* GetFirstLeafPtrForTree(size_t treeIdx) const {
         Y_ENSURE(MetaData.Defined(), "metadata should be initialized");
         return &LeafValues[MetaData->TreeFirstLeafOffsets[treeIdx]];
@@ -289,6 +371,23 @@ private:
     mutable TMaybe<TMetaData> MetaData;
 };
 
+/**
+ * Options for CatboostBinary model loading from memory
+ */
+struct TModelLoadOptions {
+    //! CTR value tables reference model memory instead of copying it, pages are read on first use
+    bool CtrTablesInPlace = false;
+    //! Optional executor for parallel CTR value tables deserialization
+    NPar::TLocalExecutor* Executor = nullptr;
+};
+
+struct TModelLoadStats {
+    double CoreLoadSeconds = 0;
+    double CtrTablesLoadSeconds = 0;
+    size_t CtrTableCount = 0;
+    size_t CtrTablesBytes = 0;
+};
+
 /*!
  * \brief Full model class - contains all the data for model evaluation
  *
@@ -351,6 +450,13 @@ struct TFullModel {
      * @param s IInputStream ptr
      */
     void Load(IInputStream* s);
+    /**
+     * Deserialize model from memory
+     * @param blob model binary, shared with CtrProvider if CTR value tables are loaded in place
+     * @param options
+     * @param stats optional load time statistics
+     */
+    void Load(const TBlob& blob, const TModelLoadOptions& options, TModelLoadStats* stats = nullptr);
 
     //! Check if TFullModel instance has valid CTR provider.
     // If no ctr features present it will return true
@@ -369,8 +475,14 @@ struct TFullModel {
      * @param[in] treeEnd Index of tree after the last tree in model to evaluate. F.e. if you want to evaluate trees 2..5 use treeStart = 2, treeEnd = 6
      * @param[out] results Flat double vector with indexation [objectIndex * ApproxDimension + classId].
      * For single class models it is just [objectIndex]
+     * @param[in] executor optional executor, objects are split between its threads by FORMULA_EVALUATION_BLOCK_SIZE aligned ranges
      */
-    void CalcFlatTransposed(const TVector<TConstArrayRef<float>>& transposedFeatures, size_t treeStart, size_t treeEnd, TArrayRef<double> results) const;
+    void CalcFlatTransposed(
+        const TVector<TConstArrayRef<float>>& transposedFeatures,
+        size_t treeStart,
+        size_t treeEnd,
+        TArrayRef<double> results,
+        NPar::TLocalExecutor* executor = nullptr) const;
     /**
      * Special interface for model evaluation on flat feature vectors. Flat here means that float features and categorical feature are in the same float array.
      * @param[in] features vector of flat features array reference. First dimension is object index, second dimension is feature index.
@@ -379,16 +491,23 @@ struct TFullModel {
      * @param[in] treeEnd Index of tree after the last tree in model to evaluate. F.e. if you want to evaluate trees 2..5 use treeStart = 2, treeEnd = 6
      * @param[out] results Flat double vector with indexation [objectIndex * ApproxDimension + classId].
      * For single class models it is just [objectIndex]
+     * @param[in] executor optional executor, objects are split between its threads by FORMULA_EVALUATION_BLOCK_SIZE aligned ranges
      */
 
-    void CalcFlat(const TVector<TConstArrayRef<float>>& features, size_t treeStart, size_t treeEnd, TArrayRef<double> results) const;
+    void CalcFlat(
+        const TVector<TConstArrayRef<float>>& features,
+        size_t treeStart,
+        size_t treeEnd,
+        TArrayRef<double> results,
+        NPar::TLocalExecutor* executor = nullptr) const;
     /**
      * Call CalcFlat on all model trees
      * @param features
      * @param results
+     * @param executor
      */
-    void CalcFlat(const TVector<TConstArrayRef<float>>& features, TArrayRef<double> results) const {
-        CalcFlat(features, 0, ObliviousTrees.TreeSizes.size(), results);
+    void CalcFlat(const TVector<TConstArrayRef<float>>& features, TArrayRef<double> results, NPar::TLocalExecutor* executor = nullptr) const {
+        CalcFlat(features, 0, ObliviousTrees.TreeSizes.size(), results, executor);
     }
     /**
      * Same as CalcFlat method but for one object
@@ -442,22 +561,26 @@ struct TFullModel {
      * @param[in] treeStart
      * @param[in] treeEnd
      * @param[out] results results indexation is [objectIndex * ApproxDimension + classId]
+     * @param[in] executor optional executor, objects are split between its threads by FORMULA_EVALUATION_BLOCK_SIZE aligned ranges
      */
     void Calc(const TVector<TConstArrayRef<float>>& floatFeatures,
               const TVector<TConstArrayRef<int>>& catFeatures,
               size_t treeStart,
               size_t treeEnd,
-              TArrayRef<double> results) const;
+              TArrayRef<double> results,
+              NPar::TLocalExecutor* executor = nullptr) const;
     /**
      * Evaluate raw formula predictions on user data. Uses all model trees
      * @param floatFeatures
      * @param catFeatures hashed cat feature values
      * @param results results indexation is [objectIndex * ApproxDimension + classId]
+     * @param executor
      */
     void Calc(const TVector<TConstArrayRef<float>>& floatFeatures,
               const TVector<TConstArrayRef<int>>& catFeatures,
-              TArrayRef<double> results) const {
-        Calc(floatFeatures, catFeatures, 0, ObliviousTrees.TreeSizes.size(), results);
+              TArrayRef<double> results,
+              NPar::TLocalExecutor* executor = nullptr) const {
+        Calc(floatFeatures, catFeatures, 0, ObliviousTrees.TreeSizes.size(), results, executor);
     }
     /**
      * Evaluate raw formula prediction for one object. Uses all model trees
@@ -479,23 +602,95 @@ struct TFullModel {
      * @param treeStart
      * @param treeEnd
      * @param results indexation is [objectIndex * ApproxDimension + classId]
+     * @param executor optional executor, objects are split between its threads by FORMULA_EVALUATION_BLOCK_SIZE aligned ranges
      */
     void Calc(const TVector<TConstArrayRef<float>>& floatFeatures,
               const TVector<TVector<TStringBuf>>& catFeatures,
               size_t treeStart,
               size_t treeEnd,
-              TArrayRef<double> results) const;
+              TArrayRef<double> results,
+              NPar::TLocalExecutor* executor = nullptr) const;
     /**
      * Evaluate raw fomula predictions for objects. Uses all model trees.
      * @param floatFeatures
      * @param catFeatures vector of vector of TStringBuf with categorical features strings
      * @param results indexation is [objectIndex * ApproxDimension + classId]
+     * @param executor
      */
     void Calc(const TVector<TConstArrayRef<float>>& floatFeatures,
               const TVector<TVector<TStringBuf>>& catFeatures,
-              TArrayRef<double> results) const {
-        Calc(floatFeatures, catFeatures, 0, ObliviousTrees.TreeSizes.size(), results);
+              TArrayRef<double> results,
+              NPar::TLocalExecutor* executor = nullptr) const {
+        Calc(floatFeatures, catFeatures, 0, ObliviousTrees.TreeSizes.size(), results, executor);
     }
+    /**
+     * Calculate leaf indexes of trees [treeStart, treeEnd) on flat feature vectors.
+     * Documents are processed by FORMULA_EVALUATION_BLOCK_SIZE blocks and indexes are written directly into given buffer.
+     * @param[in] features vector of flat features array reference. First dimension is object index, second dimension is feature index.
+     * @param[in] treeStart
+     * @param[in] treeEnd
+     * @param[out] treeLeafIndexes indexation is [objectIndex * (treeEnd - treeStart) + treeIndex - treeStart].
+     * ui8 indexes may be used for models with tree depth up to 8.
+     */
+    void CalcLeafIndexesFlat(
+        const TVector<TConstArrayRef<float>>& features,
+        size_t treeStart,
+        size_t treeEnd,
+        TArrayRef<ui8> treeLeafIndexes) const;
+    void CalcLeafIndexesFlat(
+        const TVector<TConstArrayRef<float>>& features,
+        size_t treeStart,
+        size_t treeEnd,
+        TArrayRef<ui16> treeLeafIndexes) const;
+    /**
+     * Same as CalcLeafIndexesFlat but for float features and hashed cat feature values
+     */
+    void CalcLeafIndexes(
+        const TVector<TConstArrayRef<float>>& floatFeatures,
+        const TVector<TConstArrayRef<int>>& catFeatures,
+        size_t treeStart,
+        size_t treeEnd,
+        TArrayRef<ui8> treeLeafIndexes) const;
+    void CalcLeafIndexes(
+        const TVector<TConstArrayRef<float>>& floatFeatures,
+        const TVector<TConstArrayRef<int>>& catFeatures,
+        size_t treeStart,
+        size_t treeEnd,
+        TArrayRef<ui16> treeLeafIndexes) const;
+    /**
+     * Early exit evaluation of single class model decisions on flat feature vectors.
+     * Trees are applied by chunks of treeChunkSize, object is dropped from evaluation as soon as
+     * its partial value plus min/max leaf sums of remaining trees can't cross threshold.
+     * @param[in] features vector of flat features array reference. First dimension is object index, second dimension is feature index.
+     * @param[in] threshold decision threshold on raw formula value
+     * @param[out] results results[i] > threshold exactly when full model value is greater than threshold.
+     * Fully evaluated objects get model value, early stopped ones get the bound of model value that decided.
+     * @return number of evaluated (object, tree) pairs
+     */
+    size_t CalcFlatWithThreshold(
+        const TVector<TConstArrayRef<float>>& features,
+        double threshold,
+        TArrayRef<double> results,
+        size_t treeChunkSize = 16) const;
+    /**
+     * Reorder trees for evaluation locality. Trees are grouped by depth, so depth specialized kernels get long runs,
+     * and sorted by used binary feature buckets inside each group, so consecutive trees read the same rows of binarized features.
+     * Model values change only by summation rounding, but staged evaluation and CopyTreeRange no longer follow training order.
+     * @return applied permutation: new tree i is former tree order[i]
+     */
+    TVector<size_t> OptimizeTreeOrder();
+    /**
+     * Rebuild indexes of ctr tables in given layout, it is stored in model on save.
+     * BucketizedCuckoo layout bounds lookup by two groups of buckets, old models have LinearProbing layout.
+     * Ctr provider is shared between model copies, so they are affected too.
+     */
+    void SetCtrTablesIndexLayout(ECtrTableIndexLayout layout);
+    /**
+     * Precompute values of used ctrs binarized by ctr feature borders for every ctr table index,
+     * ctr calculation becomes a lookup of one byte per document.
+     * @param dropCounters remove raw ctr counters to shrink the model, it can't be exported to C++ or Python then
+     */
+    void PrecomputeCtrValues(bool dropCounters);
     /**
      * Truncate model to contain only trees from [begin; end) interval.
      * @param begin
@@ -526,6 +721,18 @@ struct TFullModel {
 void OutputModel(const TFullModel& model, const TString& modelFile);
 TFullModel ReadModel(const TString& modelFile, EModelType format = EModelType::CatboostBinary);
 TFullModel ReadModel(const void* binaryBuffer, size_t binaryBufferSize, EModelType format = EModelType::CatboostBinary);
+/**
+ * Read CatboostBinary model from memory mapped file.
+ * CTR value tables are not copied and reference mapped pages, so processes loading the same model share page cache.
+ * Trees are still deserialized into model owned arrays.
+ */
+TFullModel ReadModelMmap(const TString& modelFile);
+
+/**
+ * Read CatboostBinary model from file with given load options.
+ * File is memory mapped, so with executor CTR value tables are copied from page cache in parallel.
+ */
+TFullModel ReadModel(const TString& modelFile, const TModelLoadOptions& options, TModelLoadStats* stats = nullptr);
 
 /**
  * Export model in our binary or protobuf CoreML format
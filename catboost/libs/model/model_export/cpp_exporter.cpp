@@ -191,11 +191,12 @@ namespace NCatboost {
         comma.ResetCount(ctrProvider->CtrData.LearnCtrs.size());
         for (const auto& learnCtr : ctrProvider->CtrData.LearnCtrs) {
             TSequenceCommaSeparator commaInner(AddSpaceAfterComma);
+            CB_ENSURE(learnCtr.second.HasCounters(), "Export of model with dropped ctr counters to C++ is not supported.");
             out << indent++ << "{" << '\n';
             out << indent << learnCtr.first.GetHash() << "ull," << '\n';
             out << indent++ << "{" << '\n';
             out << indent << WN("IndexHashViewer") << "{";
-            const TConstArrayRef<TBucket> HashViewerBuckets = learnCtr.second.GetIndexHashViewer().GetBuckets();
+            const TVector<TBucket> HashViewerBuckets = learnCtr.second.GetLinearProbingIndexBuckets();
             commaInner.ResetCount(HashViewerBuckets.size());
             for (const auto& bucket : HashViewerBuckets) {
                 out << "{" << bucket.Hash << "ull, " << bucket.IndexValue << "}" << commaInner;
@@ -165,10 +165,11 @@ namespace NCatboost {
         comma.ResetCount(ctrProvider->CtrData.LearnCtrs.size());
         for (const auto& learnCtr : ctrProvider->CtrData.LearnCtrs) {
             TSequenceCommaSeparator commaInner(AddSpaceAfterComma);
+            CB_ENSURE(learnCtr.second.HasCounters(), "Export of model with dropped ctr counters to Python is not supported.");
             out << indent << learnCtr.first.GetHash() << " :" << '\n';
             out << indent++ << "catboost_ctr_value_table(" << '\n';
             out << indent << "index_hash_viewer = {";
-            const TConstArrayRef<TBucket> HashViewerBuckets = learnCtr.second.GetIndexHashViewer().GetBuckets();
+            const TVector<TBucket> HashViewerBuckets = learnCtr.second.GetLinearProbingIndexBuckets();
             commaInner.ResetCount(HashViewerBuckets.size());
             for (const auto& bucket : HashViewerBuckets) {
                 out << bucket.Hash << " : " << bucket.IndexValue << commaInner;
@@ -7,6 +7,7 @@ static inline TString GetFeatureName(const TString& featureId, int featureIndex)
 }
 
 void CheckModelAndPoolCompatibility(const TFullModel& model, const TPool& pool) {
+    CB_ENSURE(pool.Docs.QuantizedFactors.empty(), "Model can't be applied to pool with quantized features");
     const int poolFeaturesCount = pool.Docs.GetEffectiveFactorCount();
     THashSet<int> poolCatFeatures(pool.CatFeatures.begin(), pool.CatFeatures.end());
 
@@ -2,6 +2,8 @@
 
 #include <catboost/libs/helpers/exception.h>
 
+#include <util/generic/hash_set.h>
+
 struct TCompressedModelCtr {
     const TFeatureCombination* Projection;
     TVector<const TModelCtr*> ModelCtrs;
@@ -25,40 +27,66 @@ void TStaticCtrProvider::CalcCtrs(const TVector<TModelCtr>& neededCtrs,
         compressedModelCtrs.back().ModelCtrs.push_back(&neededCtrs[i]);
     }
     size_t samplesCount = docCount;
-    TVector<ui64> ctrHashes(samplesCount);
-    TVector<ui64> buckets(samplesCount);
+    TVector<ui32> buckets(samplesCount);
     size_t resultIdx = 0;
     float* resultPtr = result.data();
-    TVector<int> transposedCatFeatureIndexes;
-    TVector<TBinFeatureIndexValue> binarizedIndexes;
+    // Needed ctrs are sorted, so consecutive projections walk the prefix tree of projections in depth-first order:
+    // prefixHashes[k] holds hashes of first k + 1 hash steps of current projection and is reused by the next one.
+    TVector<TVector<ui64>> prefixHashes;
+    TVector<TProjectionHashStep> currentSteps;
+    TVector<TProjectionHashStep> resolvedSteps;
+    TVector<ui64> emptyProjectionHashes;
     for (size_t i = 0; i < compressedModelCtrs.size(); ++i) {
         auto& proj = *compressedModelCtrs[i].Projection;
-        binarizedIndexes.clear();
-        transposedCatFeatureIndexes.clear();
-        for (const auto feature : proj.CatFeatures) {
-            transposedCatFeatureIndexes.push_back(CatFeatureIndex.at(feature));
+        const TVector<TProjectionHashStep>* steps = ProjectionHashSteps.FindPtr(proj);
+        if (steps == nullptr) {
+            CB_ENSURE(ResolveProjectionHashSteps(proj, &resolvedSteps), "Unknown feature in ctr projection");
+            steps = &resolvedSteps;
+        }
+        size_t commonPrefixSize = 0;
+        while (commonPrefixSize < Min(currentSteps.size(), steps->size()) &&
+            currentSteps[commonPrefixSize] == (*steps)[commonPrefixSize]) {
+            ++commonPrefixSize;
+        }
+        if (prefixHashes.size() < steps->size()) {
+            prefixHashes.resize(steps->size());
         }
-        for (const auto feature : proj.BinFeatures ) {
-            binarizedIndexes.push_back(FloatFeatureIndexes.at(feature));
+        for (size_t stepIdx = commonPrefixSize; stepIdx < steps->size(); ++stepIdx) {
+            prefixHashes[stepIdx].yresize(docCount);
+            ApplyProjectionHashStep(
+                (*steps)[stepIdx],
+                binarizedFeatures,
+                hashedCatFeatures,
+                docCount,
+                stepIdx == 0 ? nullptr : prefixHashes[stepIdx - 1].data(),
+                prefixHashes[stepIdx].data());
         }
-        for (const auto feature : proj.OneHotFeatures ) {
-            binarizedIndexes.push_back(OneHotFeatureIndexes.at(feature));
+        currentSteps.assign(steps->begin(), steps->end());
+        if (steps->empty()) {
+            emptyProjectionHashes.assign(docCount, 0);
         }
-        CalcHashes(binarizedFeatures, hashedCatFeatures, transposedCatFeatureIndexes, binarizedIndexes, docCount, &ctrHashes);
+        TConstArrayRef<ui64> ctrHashes = steps->empty() ? emptyProjectionHashes : prefixHashes[steps->size() - 1];
         for (size_t j = 0; j < compressedModelCtrs[i].ModelCtrs.size(); ++j) {
             auto& ctr = *compressedModelCtrs[i].ModelCtrs[j];
             auto& learnCtr = CtrData.LearnCtrs.at(ctr.Base);
-            auto hashIndexResolver = learnCtr.GetIndexHashViewer();
             const ECtrType ctrType = ctr.Base.CtrType;
             auto ptrBuckets = buckets.data();
-            for (size_t docId = 0; docId < samplesCount; ++docId) {
-                ptrBuckets[docId] = hashIndexResolver.GetIndex(ctrHashes[docId]);
-            }
-            if (ctrType == ECtrType::BinarizedTargetMeanValue || ctrType == ECtrType::FloatTargetMeanValue) {
+            learnCtr.GetIndexes(ctrHashes, buckets);
+            const TPrecomputedCtrValues* precomputed = learnCtr.FindPrecomputedCtrValues(ctr);
+            CB_ENSURE(precomputed != nullptr || learnCtr.HasCounters(), "Ctr counters are dropped, but ctr values are not precomputed");
+            if (precomputed != nullptr) {
+                const ui8* bins = precomputed->Bins.data();
+                const ui8 missingBin = precomputed->Bins.back();
+                const float* binValues = precomputed->BinValues.data();
+                for (size_t doc = 0; doc < samplesCount; ++doc) {
+                    const ui8 bin = ptrBuckets[doc] != TCtrValueTable::NotFoundIndex ? bins[ptrBuckets[doc]] : missingBin;
+                    resultPtr[doc + resultIdx] = binValues[bin];
+                }
+            } else if (ctrType == ECtrType::BinarizedTargetMeanValue || ctrType == ECtrType::FloatTargetMeanValue) {
                 const auto emptyVal = ctr.Calc(0.f, 0.f);
                 auto ctrMean = learnCtr.GetTypedArrayRefForBlobData<TCtrMeanHistory>();
                 for (size_t doc = 0; doc < samplesCount; ++doc) {
-                    if (ptrBuckets[doc] != NCatboost::TDenseIndexHashView::NotFoundIndex) {
+                    if (ptrBuckets[doc] != TCtrValueTable::NotFoundIndex) {
                         const TCtrMeanHistory& ctrMeanHistory = ctrMean[ptrBuckets[doc]];
                         resultPtr[doc + resultIdx] = ctr.Calc(ctrMeanHistory.Sum, ctrMeanHistory.Count);
                     } else {
@@ -70,7 +98,7 @@ void TStaticCtrProvider::CalcCtrs(const TVector<TModelCtr>& neededCtrs,
                 const int denominator = learnCtr.CounterDenominator;
                 auto emptyVal = ctr.Calc(0, denominator);
                 for (size_t doc = 0; doc < samplesCount; ++doc) {
-                    if (ptrBuckets[doc] != NCatboost::TDenseIndexHashView::NotFoundIndex) {
+                    if (ptrBuckets[doc] != TCtrValueTable::NotFoundIndex) {
                         resultPtr[doc + resultIdx] = ctr.Calc(ctrTotal[ptrBuckets[doc]], denominator);
                     } else {
                         resultPtr[doc + resultIdx] = emptyVal;
@@ -81,7 +109,7 @@ void TStaticCtrProvider::CalcCtrs(const TVector<TModelCtr>& neededCtrs,
                 const int targetClassesCount = learnCtr.TargetClassesCount;
                 auto emptyVal = ctr.Calc(0, 0);
                 for (size_t doc = 0; doc < samplesCount; ++doc) {
-                    if (ptrBuckets[doc] != NCatboost::TDenseIndexHashView::NotFoundIndex) {
+                    if (ptrBuckets[doc] != TCtrValueTable::NotFoundIndex) {
                         int goodCount = 0;
                         int totalCount = 0;
                         auto ctrHistory = MakeArrayRef(ctrIntArray.data() + ptrBuckets[doc] * targetClassesCount, targetClassesCount);
@@ -103,7 +131,7 @@ void TStaticCtrProvider::CalcCtrs(const TVector<TModelCtr>& neededCtrs,
                     for (size_t doc = 0; doc < samplesCount; ++doc) {
                         int goodCount = 0;
                         int totalCount = 0;
-                        if (ptrBuckets[doc] != NCatboost::TDenseIndexHashView::NotFoundIndex) {
+                        if (ptrBuckets[doc] != TCtrValueTable::NotFoundIndex) {
                             auto ctrHistory = MakeArrayRef(ctrIntArray.data() + ptrBuckets[doc] * targetClassesCount, targetClassesCount);
                             for (int classId = 0; classId < ctr.TargetBorderIdx + 1; ++classId) {
                                 totalCount += ctrHistory[classId];
@@ -117,7 +145,7 @@ void TStaticCtrProvider::CalcCtrs(const TVector<TModelCtr>& neededCtrs,
                     }
                 } else {
                     for (size_t doc = 0; doc < samplesCount; ++doc) {
-                        if (ptrBuckets[doc] != NCatboost::TDenseIndexHashView::NotFoundIndex) {
+                        if (ptrBuckets[doc] != TCtrValueTable::NotFoundIndex) {
                             const int* ctrHistory = &ctrIntArray[ptrBuckets[doc] * 2];
                             resultPtr[doc + resultIdx] = ctr.Calc(ctrHistory[1], ctrHistory[0] + ctrHistory[1]);
                         } else {
@@ -131,6 +159,89 @@ void TStaticCtrProvider::CalcCtrs(const TVector<TModelCtr>& neededCtrs,
     }
 }
 
+//! Values of ctr for every table index, last one is for hashes missing in table
+static TVector<float> CalcCtrValuesForTableIndexes(const TModelCtr& ctr, const TCtrValueTable& table) {
+    TVector<float> values;
+    const ECtrType ctrType = ctr.Base.CtrType;
+    if (ctrType == ECtrType::BinarizedTargetMeanValue || ctrType == ECtrType::FloatTargetMeanValue) {
+        for (const auto& ctrMeanHistory : table.GetTypedArrayRefForBlobData<TCtrMeanHistory>()) {
+            values.push_back(ctr.Calc(ctrMeanHistory.Sum, ctrMeanHistory.Count));
+        }
+        values.push_back(ctr.Calc(0.f, 0.f));
+    } else if (ctrType == ECtrType::Counter || ctrType == ECtrType::FeatureFreq) {
+        const int denominator = table.CounterDenominator;
+        for (const int total : table.GetTypedArrayRefForBlobData<int>()) {
+            values.push_back(ctr.Calc(total, denominator));
+        }
+        values.push_back(ctr.Calc(0, denominator));
+    } else {
+        const auto ctrIntArray = table.GetTypedArrayRefForBlobData<int>();
+        const int targetClassesCount = table.TargetClassesCount;
+        CB_ENSURE(targetClassesCount > 0, "Ctr table has no target classes");
+        for (size_t offset = 0; offset + targetClassesCount <= ctrIntArray.size(); offset += targetClassesCount) {
+            const int* ctrHistory = ctrIntArray.data() + offset;
+            int goodCount = 0;
+            int totalCount = 0;
+            if (ctrType == ECtrType::Buckets) {
+                goodCount = ctrHistory[ctr.TargetBorderIdx];
+                for (int classId = 0; classId < targetClassesCount; ++classId) {
+                    totalCount += ctrHistory[classId];
+                }
+            } else if (targetClassesCount > 2) {
+                for (int classId = 0; classId < ctr.TargetBorderIdx + 1; ++classId) {
+                    totalCount += ctrHistory[classId];
+                }
+                for (int classId = ctr.TargetBorderIdx + 1; classId < targetClassesCount; ++classId) {
+                    goodCount += ctrHistory[classId];
+                }
+                totalCount += goodCount;
+            } else {
+                goodCount = ctrHistory[1];
+                totalCount = ctrHistory[0] + ctrHistory[1];
+            }
+            values.push_back(ctr.Calc(goodCount, totalCount));
+        }
+        values.push_back(ctr.Calc(0, 0));
+    }
+    return values;
+}
+
+void TStaticCtrProvider::PrecomputeCtrValues(const TVector<TCtrFeature>& ctrFeatures, bool dropCounters) {
+    THashSet<TModelCtrBase> precomputedBases;
+    for (const auto& ctrFeature : ctrFeatures) {
+        auto& table = CtrData.LearnCtrs.at(ctrFeature.Ctr.Base);
+        precomputedBases.insert(ctrFeature.Ctr.Base);
+        if (table.FindPrecomputedCtrValues(ctrFeature.Ctr) != nullptr) {
+            continue;
+        }
+        CB_ENSURE(table.HasCounters(), "Ctr counters are dropped, ctr values can't be precomputed");
+        const auto& borders = ctrFeature.Borders;
+        CB_ENSURE(borders.size() <= std::numeric_limits<ui8>::max(), "Too many borders of ctr feature to precompute its values: " << borders.size());
+        TPrecomputedCtrValues precomputed;
+        precomputed.Ctr = ctrFeature.Ctr;
+        // unreachable bins keep zero value, reachable ones get value of any index in the bin
+        precomputed.BinValues.resize(borders.size() + 1);
+        TVector<bool> isBinReached(borders.size() + 1, false);
+        for (const float value : CalcCtrValuesForTableIndexes(ctrFeature.Ctr, table)) {
+            ui8 bin = 0;
+            for (const float border : borders) {
+                bin += (ui8)(value > border);
+            }
+            if (!isBinReached[bin]) {
+                isBinReached[bin] = true;
+                precomputed.BinValues[bin] = value;
+            }
+            precomputed.Bins.push_back(bin);
+        }
+        table.PrecomputedCtrs.push_back(std::move(precomputed));
+    }
+    if (dropCounters) {
+        for (const auto& ctrBase : precomputedBases) {
+            CtrData.LearnCtrs.at(ctrBase).DropCounters();
+        }
+    }
+}
+
 bool TStaticCtrProvider::HasNeededCtrs(const TVector<TModelCtr>& neededCtrs) const {
     for (const auto& ctr : neededCtrs) {
         if (!CtrData.LearnCtrs.has(ctr.Base)) {
@@ -167,4 +278,46 @@ void TStaticCtrProvider::SetupBinFeatureIndexes(const TVector<TFloatFeature> &fl
         const int prevSize = CatFeatureIndex.ysize();
         CatFeatureIndex[catFeature.FeatureIndex] = prevSize;
     }
+    ProjectionHashSteps.clear();
+    for (const auto& ctrBaseAndTable : CtrData.LearnCtrs) {
+        const auto& projection = ctrBaseAndTable.first.Projection;
+        TVector<TProjectionHashStep> steps;
+        if (!ProjectionHashSteps.has(projection) && ResolveProjectionHashSteps(projection, &steps)) {
+            ProjectionHashSteps[projection] = std::move(steps);
+        }
+    }
+}
+
+bool TStaticCtrProvider::ResolveProjectionHashSteps(const TFeatureCombination& projection, TVector<TProjectionHashStep>* steps) const {
+    // same order as in CalcHashes: cat features first, then float and one hot splits
+    steps->clear();
+    for (const auto feature : projection.CatFeatures) {
+        const auto catFeatureIdx = CatFeatureIndex.FindPtr(feature);
+        if (catFeatureIdx == nullptr) {
+            return false;
+        }
+        TProjectionHashStep step;
+        step.IsCatFeature = true;
+        step.TransposedCatFeatureIndex = *catFeatureIdx;
+        steps->push_back(step);
+    }
+    for (const auto& feature : projection.BinFeatures) {
+        const auto binFeatureIdx = FloatFeatureIndexes.FindPtr(feature);
+        if (binFeatureIdx == nullptr) {
+            return false;
+        }
+        TProjectionHashStep step;
+        step.BinFeatureIndex = *binFeatureIdx;
+        steps->push_back(step);
+    }
+    for (const auto& feature : projection.OneHotFeatures) {
+        const auto binFeatureIdx = OneHotFeatureIndexes.FindPtr(feature);
+        if (binFeatureIdx == nullptr) {
+            return false;
+        }
+        TProjectionHashStep step;
+        step.BinFeatureIndex = *binFeatureIdx;
+        steps->push_back(step);
+    }
+    return true;
 }
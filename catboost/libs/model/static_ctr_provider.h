@@ -1,5 +1,6 @@
 #pragma once
 
+#include <util/memory/blob.h>
 #include <util/system/mutex.h>
 #include <library/threading/local_executor/local_executor.h>
 #include <catboost/libs/helpers/exception.h>
@@ -43,6 +44,44 @@ public:
         ::Load(inp, CtrData);
     }
 
+    bool IsLegacyFormatCompatible() const override {
+        for (const auto& ctrBaseAndTable : CtrData.LearnCtrs) {
+            if (!ctrBaseAndTable.second.IsLegacyFormatCompatible()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Load ctr tables from model binary in memory.
+     * @param in stream over modelBlob data positioned at ctr data start
+     * @param modelBlob holder of model memory, kept while provider is alive if tables are loaded in place
+     * @param inPlace ctr tables are views into modelBlob instead of copies
+     * @param executor optional executor for parallel tables deserialization
+     */
+    void Load(TMemoryInput* in, const TBlob& modelBlob, bool inPlace, NPar::TLocalExecutor* executor) {
+        CtrData.Load(in, inPlace, executor);
+        if (inPlace) {
+            ModelBlob = modelBlob;
+        }
+    }
+
+    //! Rebuild indexes of all ctr tables in given layout, layout is kept on model save
+    void SetCtrTablesIndexLayout(ECtrTableIndexLayout layout) {
+        for (auto& ctrBaseAndTable : CtrData.LearnCtrs) {
+            ctrBaseAndTable.second.SetIndexLayout(layout);
+        }
+    }
+
+    /**
+     * Store values of ctr features binarized by their borders for every ctr table index,
+     * so ctr calculation is a gather of precomputed values.
+     * @param dropCounters remove counters of tables used by ctr features to shrink the model,
+     * such model can't be exported to C++ or Python code
+     */
+    void PrecomputeCtrValues(const TVector<TCtrFeature>& ctrFeatures, bool dropCounters);
+
     TString ModelPartIdentifier() const override {
         return "static_provider_v1";
     }
@@ -61,10 +100,17 @@ public:
 
     ~TStaticCtrProvider() override {}
     TCtrData CtrData;
+private:
+    //! false if projection uses features unknown to provider
+    bool ResolveProjectionHashSteps(const TFeatureCombination& projection, TVector<TProjectionHashStep>* steps) const;
+
 private:
     THashMap<TFloatSplit, TBinFeatureIndexValue> FloatFeatureIndexes;
     THashMap<int, int> CatFeatureIndex;
     THashMap<TOneHotSplit, TBinFeatureIndexValue> OneHotFeatureIndexes;
+    // hash steps of ctr projections known at SetupBinFeatureIndexes time, projections sharing prefix share hash steps
+    THashMap<TFeatureCombination, TVector<TProjectionHashStep>> ProjectionHashSteps;
+    TBlob ModelBlob;
 };
 
 struct TStaticCtrOnFlightSerializationProvider: public ICtrProvider {
@@ -2,6 +2,11 @@
 #include <catboost/libs/model/formula_evaluator.h>
 #include <library/unittest/registar.h>
 
+#include <util/random/fast.h>
+
+#include <cmath>
+#include <limits>
+
 using namespace std;
 
 TFullModel SimpleFloatModel() {
@@ -63,6 +68,36 @@ TFullModel MultiValueFloatModel() {
     return model;
 }
 
+TFullModel RandomFloatModel(size_t featureCount, size_t borderCount, size_t treeCount, int treeDepth, int approxDimension, TFastRng64& rng) {
+    TFullModel model;
+    for (size_t featureIdx = 0; featureIdx < featureCount; ++featureIdx) {
+        TVector<float> borders;
+        for (size_t borderIdx = 0; borderIdx < borderCount; ++borderIdx) {
+            borders.push_back(rng.GenRandReal1());
+        }
+        Sort(borders.begin(), borders.end());
+        borders.erase(Unique(borders.begin(), borders.end()), borders.end());
+        model.ObliviousTrees.FloatFeatures.emplace_back(false, (int)featureIdx, (int)featureIdx, borders, "");
+    }
+    size_t binFeatureCount = 0;
+    for (const auto& feature : model.ObliviousTrees.FloatFeatures) {
+        binFeatureCount += feature.Borders.size();
+    }
+    for (size_t treeIdx = 0; treeIdx < treeCount; ++treeIdx) {
+        TVector<int> tree;
+        for (int depth = 0; depth < treeDepth; ++depth) {
+            tree.push_back(rng.Uniform(binFeatureCount));
+        }
+        model.ObliviousTrees.AddBinTree(tree);
+        for (int leafIdx = 0; leafIdx < (1 << treeDepth) * approxDimension; ++leafIdx) {
+            model.ObliviousTrees.LeafValues.push_back(rng.GenRandReal1());
+        }
+    }
+    model.ObliviousTrees.ApproxDimension = approxDimension;
+    model.UpdateDynamicData();
+    return model;
+}
+
 Y_UNIT_TEST_SUITE(TObliviousTreeModel) {
     Y_UNIT_TEST(TestFlatCalcFloat) {
         auto modelCalcer = SimpleFloatModel();
@@ -105,4 +140,397 @@ Y_UNIT_TEST_SUITE(TObliviousTreeModel) {
         };
         UNIT_ASSERT_EQUAL(canonVals, result);
     }
+
+    Y_UNIT_TEST(TestAllKernelsGiveSameResults) {
+        TFastRng64 rng(42);
+        for (int approxDimension : {1, 3}) {
+            const auto model = RandomFloatModel(10, 200, 37, 6, approxDimension, rng);
+            for (size_t docCount : {1, 7, 16, 33, 100, 128}) {
+                TVector<TVector<float>> features(model.ObliviousTrees.FloatFeatures.size(), TVector<float>(docCount));
+                for (auto& feature : features) {
+                    for (auto& value : feature) {
+                        value = rng.GenRandReal1();
+                    }
+                }
+                TVector<ui8> canonBins;
+                TVector<double> canonResults;
+                for (auto kernel : {EFormulaEvaluatorKernel::Basic, EFormulaEvaluatorKernel::Sse, EFormulaEvaluatorKernel::Avx2, EFormulaEvaluatorKernel::Avx512}) {
+                    if (!IsFormulaEvaluatorKernelSupported(kernel)) {
+                        continue;
+                    }
+                    for (auto method : {EBinarizationMethod::LinearScan, EBinarizationMethod::BinarySearch}) {
+                        TVector<ui8> bins(model.ObliviousTrees.GetEffectiveBinaryFeaturesBucketsCount() * docCount, 0);
+                        ui8* binsPtr = bins.data();
+                        for (size_t featureIdx = 0; featureIdx < features.size(); ++featureIdx) {
+                            BinarizeFloats<false>(
+                                GetBinarizeFloatsKernel(kernel, method),
+                                docCount,
+                                [&features, featureIdx](size_t index) { return features[featureIdx][index]; },
+                                model.ObliviousTrees.FloatFeatures[featureIdx].Borders,
+                                0,
+                                binsPtr);
+                        }
+                        TVector<double> results(docCount * approxDimension, 0.0);
+                        TVector<TCalcerIndexType> indexesVec(docCount);
+                        GetCalcTreesFunction(model, docCount, kernel)(
+                            model,
+                            bins.data(),
+                            docCount,
+                            indexesVec.data(),
+                            0,
+                            model.GetTreeCount(),
+                            results.data());
+                        if (canonBins.empty()) {
+                            canonBins = bins;
+                            canonResults = results;
+                        }
+                        UNIT_ASSERT_EQUAL(canonBins, bins);
+                        UNIT_ASSERT_EQUAL(canonResults, results);
+                    }
+                }
+            }
+        }
+    }
+
+    Y_UNIT_TEST(TestBinarySearchBinarizationEdgeCases) {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        const float infinity = std::numeric_limits<float>::infinity();
+        for (size_t borderCount : {0, 1, 2, 3, 31, 32, 33, 254}) {
+            TVector<float> borders;
+            for (size_t borderIdx = 0; borderIdx < borderCount; ++borderIdx) {
+                borders.push_back(borderIdx * 0.5f - 10.f);
+            }
+            TVector<float> values = {nan, -infinity, infinity, -100.f, 100.f};
+            for (auto border : borders) {
+                values.push_back(border);
+                values.push_back(std::nextafter(border, -infinity));
+                values.push_back(std::nextafter(border, infinity));
+            }
+            for (auto kernel : {EFormulaEvaluatorKernel::Basic, EFormulaEvaluatorKernel::Sse, EFormulaEvaluatorKernel::Avx2, EFormulaEvaluatorKernel::Avx512}) {
+                if (!IsFormulaEvaluatorKernelSupported(kernel)) {
+                    continue;
+                }
+                TVector<ui8> linearBins(values.size(), 0);
+                TVector<ui8> searchBins(values.size(), 0);
+                GetBinarizeFloatsKernel(kernel, EBinarizationMethod::LinearScan)(values.data(), values.size(), borders, linearBins.data());
+                GetBinarizeFloatsKernel(kernel, EBinarizationMethod::BinarySearch)(values.data(), values.size(), borders, searchBins.data());
+                UNIT_ASSERT_EQUAL(linearBins, searchBins);
+                UNIT_ASSERT_EQUAL(searchBins[0], 0);
+                UNIT_ASSERT_EQUAL(searchBins[2], borderCount);
+            }
+        }
+    }
+
+    Y_UNIT_TEST(TestDepthSpecializedEvaluation) {
+        TFastRng64 rng(17);
+        for (int approxDimension : {1, 3}) {
+            TFullModel model;
+            for (size_t featureIdx = 0; featureIdx < 8; ++featureIdx) {
+                TVector<float> borders;
+                for (size_t borderIdx = 0; borderIdx < 20; ++borderIdx) {
+                    borders.push_back(rng.GenRandReal1());
+                }
+                Sort(borders.begin(), borders.end());
+                model.ObliviousTrees.FloatFeatures.emplace_back(false, (int)featureIdx, (int)featureIdx, borders, "");
+            }
+            // depth groups of different length, including zero depth and deep trees evaluated by generic kernel
+            for (int treeDepth : {6, 6, 6, 6, 6, 6, 0, 8, 8, 8, 8, 8, 3, 10, 10, 6, 1, 1, 1, 1, 1}) {
+                TVector<int> tree;
+                for (int depth = 0; depth < treeDepth; ++depth) {
+                    tree.push_back(rng.Uniform(8 * 20));
+                }
+                model.ObliviousTrees.AddBinTree(tree);
+                for (int leafIdx = 0; leafIdx < (1 << treeDepth) * approxDimension; ++leafIdx) {
+                    model.ObliviousTrees.LeafValues.push_back(rng.GenRandReal1());
+                }
+            }
+            model.ObliviousTrees.ApproxDimension = approxDimension;
+            model.UpdateDynamicData();
+            UNIT_ASSERT_VALUES_EQUAL(model.ObliviousTrees.GetTreeDepthGroups().size(), 7);
+            UNIT_ASSERT_VALUES_EQUAL(model.ObliviousTrees.TreeStartOffsets[8], 6 * 6 + 8);
+
+            const size_t docCount = FORMULA_EVALUATION_BLOCK_SIZE;
+            TVector<ui8> bins(model.ObliviousTrees.GetEffectiveBinaryFeaturesBucketsCount() * docCount);
+            for (auto& bin : bins) {
+                bin = rng.Uniform(21);
+            }
+            for (auto kernel : {EFormulaEvaluatorKernel::Basic, EFormulaEvaluatorKernel::Sse, EFormulaEvaluatorKernel::Avx2, EFormulaEvaluatorKernel::Avx512}) {
+                if (!IsFormulaEvaluatorKernelSupported(kernel)) {
+                    continue;
+                }
+                for (auto treeRange : {std::make_pair(0, 21), std::make_pair(2, 9), std::make_pair(13, 14), std::make_pair(7, 20)}) {
+                    TVector<double> canonResults(docCount * approxDimension + 1, 0.0);
+                    TVector<double> results(docCount * approxDimension + 1, 0.0);
+                    TVector<TCalcerIndexType> indexesVec(docCount);
+                    GetCalcTreesFunction(model, docCount, kernel, false)(
+                        model, bins.data(), docCount, indexesVec.data(), treeRange.first, treeRange.second, canonResults.data());
+                    // unaligned results buffer
+                    GetCalcTreesFunction(model, docCount, kernel, true)(
+                        model, bins.data(), docCount, indexesVec.data(), treeRange.first, treeRange.second, results.data() + 1);
+                    results.erase(results.begin());
+                    canonResults.pop_back();
+                    UNIT_ASSERT_EQUAL(canonResults, results);
+                }
+            }
+        }
+    }
+
+    Y_UNIT_TEST(TestReducedPrecisionLeafValues) {
+        TFastRng64 rng(7);
+        for (int approxDimension : {1, 3}) {
+            auto model = RandomFloatModel(10, 50, 29, 6, approxDimension, rng);
+            // deep tree is evaluated with ui32 indexes
+            {
+                TVector<int> tree;
+                for (int depth = 0; depth < 10; ++depth) {
+                    tree.push_back(rng.Uniform(10 * 50));
+                }
+                model.ObliviousTrees.AddBinTree(tree);
+                for (int leafIdx = 0; leafIdx < (1 << 10) * approxDimension; ++leafIdx) {
+                    model.ObliviousTrees.LeafValues.push_back(rng.GenRandReal1() * 100.0 - 50.0);
+                }
+                model.UpdateDynamicData();
+            }
+            for (size_t docCount : {1, 33, 128}) {
+                TVector<ui8> bins(model.ObliviousTrees.GetEffectiveBinaryFeaturesBucketsCount() * docCount);
+                for (auto& bin : bins) {
+                    bin = rng.Uniform(51);
+                }
+                TVector<TCalcerIndexType> indexesVec(docCount);
+                model.ObliviousTrees.SetLeafValuesPrecision(ELeafValuesPrecision::Double);
+                TVector<double> canonResults(docCount * approxDimension, 0.0);
+                GetCalcTreesFunction(model, docCount, EFormulaEvaluatorKernel::Basic)(
+                    model, bins.data(), docCount, indexesVec.data(), 0, model.GetTreeCount(), canonResults.data());
+                for (auto precision : {ELeafValuesPrecision::Float, ELeafValuesPrecision::Int16}) {
+                    const double maxAbsError = model.ObliviousTrees.SetLeafValuesPrecision(precision);
+                    UNIT_ASSERT(maxAbsError > 0.0);
+                    UNIT_ASSERT_VALUES_EQUAL(maxAbsError, model.ObliviousTrees.GetLeafValuesMaxAbsError());
+                    for (auto kernel : {EFormulaEvaluatorKernel::Basic, EFormulaEvaluatorKernel::Sse, EFormulaEvaluatorKernel::Avx2, EFormulaEvaluatorKernel::Avx512}) {
+                        if (!IsFormulaEvaluatorKernelSupported(kernel)) {
+                            continue;
+                        }
+                        TVector<double> results(docCount * approxDimension, 0.0);
+                        GetCalcTreesFunction(model, docCount, kernel)(
+                            model, bins.data(), docCount, docCount == 1 ? nullptr : indexesVec.data(), 0, model.GetTreeCount(), results.data());
+                        for (size_t idx = 0; idx < results.size(); ++idx) {
+                            UNIT_ASSERT_DOUBLES_EQUAL(canonResults[idx], results[idx], maxAbsError + 1e-9);
+                        }
+                    }
+                }
+                model.ObliviousTrees.SetLeafValuesPrecision(ELeafValuesPrecision::Double);
+            }
+        }
+    }
+
+    Y_UNIT_TEST(TestMultiThreadedCalcFlat) {
+        TFastRng64 rng(11);
+        NPar::TLocalExecutor executor;
+        executor.RunAdditionalThreads(3);
+        for (int approxDimension : {1, 3}) {
+            const auto model = RandomFloatModel(10, 30, 23, 5, approxDimension, rng);
+            for (size_t docCount : {1, 100, 129, 257, 1000}) {
+                TVector<TVector<float>> features(docCount, TVector<float>(model.ObliviousTrees.FloatFeatures.size()));
+                TVector<TConstArrayRef<float>> featureRefs;
+                for (auto& docFeatures : features) {
+                    for (auto& value : docFeatures) {
+                        value = rng.GenRandReal1();
+                    }
+                    featureRefs.push_back(docFeatures);
+                }
+                TVector<double> canonResults(docCount * approxDimension);
+                model.CalcFlat(featureRefs, canonResults);
+                TVector<double> results(docCount * approxDimension);
+                model.CalcFlat(featureRefs, results, &executor);
+                UNIT_ASSERT_EQUAL(canonResults, results);
+                TVector<double> calcResults(docCount * approxDimension);
+                model.Calc(featureRefs, TVector<TConstArrayRef<int>>(), calcResults, &executor);
+                UNIT_ASSERT_EQUAL(canonResults, calcResults);
+            }
+        }
+    }
+
+    Y_UNIT_TEST(TestLeafIndexes) {
+        TFastRng64 rng(5);
+        for (int treeDepth : {3, 8, 10}) {
+            auto model = RandomFloatModel(10, 20, 13, treeDepth, 1, rng);
+            // replace leaf values with leaf indexes, so prediction of one tree is its leaf index
+            for (size_t leafIdx = 0; leafIdx < model.ObliviousTrees.LeafValues.size(); ++leafIdx) {
+                model.ObliviousTrees.LeafValues[leafIdx] = leafIdx % (1 << treeDepth);
+            }
+            model.UpdateDynamicData();
+            for (size_t docCount : {1, 100, 300}) {
+                TVector<TVector<float>> features(docCount, TVector<float>(model.ObliviousTrees.FloatFeatures.size()));
+                TVector<TConstArrayRef<float>> featureRefs;
+                for (auto& docFeatures : features) {
+                    for (auto& value : docFeatures) {
+                        value = rng.GenRandReal1();
+                    }
+                    featureRefs.push_back(docFeatures);
+                }
+                const size_t treeStart = 2;
+                const size_t treeEnd = 11;
+                TVector<ui16> leafIndexes(docCount * (treeEnd - treeStart));
+                model.CalcLeafIndexesFlat(featureRefs, treeStart, treeEnd, leafIndexes);
+                if (treeDepth <= 8) {
+                    TVector<ui8> narrowLeafIndexes(leafIndexes.size());
+                    model.CalcLeafIndexes(featureRefs, TVector<TConstArrayRef<int>>(), treeStart, treeEnd, narrowLeafIndexes);
+                    UNIT_ASSERT(Equal(leafIndexes.begin(), leafIndexes.end(), narrowLeafIndexes.begin()));
+                } else {
+                    TVector<ui8> narrowLeafIndexes(leafIndexes.size());
+                    UNIT_ASSERT_EXCEPTION(model.CalcLeafIndexesFlat(featureRefs, treeStart, treeEnd, narrowLeafIndexes), TCatboostException);
+                }
+                for (size_t treeIdx = treeStart; treeIdx < treeEnd; ++treeIdx) {
+                    TVector<double> treeResults(docCount);
+                    model.CalcFlat(featureRefs, treeIdx, treeIdx + 1, treeResults);
+                    for (size_t docId = 0; docId < docCount; ++docId) {
+                        UNIT_ASSERT_VALUES_EQUAL(leafIndexes[docId * (treeEnd - treeStart) + treeIdx - treeStart], treeResults[docId]);
+                    }
+                }
+            }
+        }
+    }
+    Y_UNIT_TEST(TestEarlyExitWithThreshold) {
+        TFastRng64 rng(11);
+        auto model = RandomFloatModel(10, 20, 100, 6, 1, rng);
+        const size_t docCount = 300;
+        TVector<TVector<float>> features(docCount, TVector<float>(model.ObliviousTrees.FloatFeatures.size()));
+        TVector<TConstArrayRef<float>> featureRefs;
+        for (auto& docFeatures : features) {
+            for (auto& value : docFeatures) {
+                value = rng.GenRandReal1();
+            }
+            featureRefs.push_back(docFeatures);
+        }
+        TVector<double> canonResults(docCount);
+        model.CalcFlat(featureRefs, canonResults);
+        TVector<double> sortedResults = canonResults;
+        Sort(sortedResults.begin(), sortedResults.end());
+        for (auto precision : {ELeafValuesPrecision::Double, ELeafValuesPrecision::Int16}) {
+            model.ObliviousTrees.SetLeafValuesPrecision(precision);
+            model.CalcFlat(featureRefs, canonResults);
+            // thresholds equal to some model values check exact reevaluation of objects close to threshold
+            for (double threshold : {sortedResults[10], sortedResults[150], sortedResults[290], canonResults[7], 1e9}) {
+                for (size_t treeChunkSize : {1, 16, 1000}) {
+                    for (size_t evalDocCount : {(size_t)1, docCount}) {
+                        TVector<double> results(evalDocCount);
+                        const size_t evaluatedTreeCount = model.CalcFlatWithThreshold(
+                            TVector<TConstArrayRef<float>>(featureRefs.begin(), featureRefs.begin() + evalDocCount),
+                            threshold,
+                            results,
+                            treeChunkSize);
+                        UNIT_ASSERT(evaluatedTreeCount <= 2 * evalDocCount * model.GetTreeCount());
+                        for (size_t docId = 0; docId < evalDocCount; ++docId) {
+                            UNIT_ASSERT_VALUES_EQUAL(canonResults[docId] > threshold, results[docId] > threshold);
+                        }
+                    }
+                }
+            }
+        }
+        model.ObliviousTrees.SetLeafValuesPrecision(ELeafValuesPrecision::Double);
+        TVector<double> results(docCount);
+        UNIT_ASSERT(model.CalcFlatWithThreshold(featureRefs, 1e9, results) < docCount * model.GetTreeCount() / 2);
+        UNIT_ASSERT_EXCEPTION(MultiValueFloatModel().CalcFlatWithThreshold(featureRefs, 0.0, results), TCatboostException);
+    }
+    Y_UNIT_TEST(TestEarlyExitNearThreshold) {
+        TFastRng64 rng(17);
+        auto model = RandomFloatModel(10, 20, 100, 6, 1, rng);
+        const size_t docCount = 300;
+        TVector<TVector<float>> features(docCount, TVector<float>(model.ObliviousTrees.FloatFeatures.size()));
+        for (auto& value : features[0]) {
+            value = rng.GenRandReal1();
+        }
+        // every third object is a copy of the first one with features moved by one float ulp
+        for (size_t docId = 1; docId < docCount; ++docId) {
+            for (size_t featureIdx = 0; featureIdx < features[docId].size(); ++featureIdx) {
+                if (docId % 3 == 0) {
+                    features[docId][featureIdx] = std::nextafter(features[0][featureIdx], docId % 2 ? 2.0f : -1.0f);
+                } else {
+                    features[docId][featureIdx] = rng.GenRandReal1();
+                }
+            }
+        }
+        TVector<TConstArrayRef<float>> featureRefs(features.begin(), features.end());
+        for (auto precision : {ELeafValuesPrecision::Double, ELeafValuesPrecision::Int16}) {
+            model.ObliviousTrees.SetLeafValuesPrecision(precision);
+            for (size_t evalDocCount : {(size_t)1, (size_t)2, (size_t)129, docCount}) {
+                const TVector<TConstArrayRef<float>> evalFeatures(featureRefs.begin(), featureRefs.begin() + evalDocCount);
+                TVector<double> canonResults(evalDocCount);
+                model.CalcFlat(evalFeatures, canonResults);
+                const double value = canonResults[0];
+                const double thresholds[] = {
+                    value,
+                    std::nextafter(value, -1e9),
+                    std::nextafter(value, 1e9),
+                    value * (1.0 - std::numeric_limits<float>::epsilon()),
+                    value * (1.0 + std::numeric_limits<float>::epsilon())
+                };
+                for (double threshold : thresholds) {
+                    for (size_t treeChunkSize : {1, 7, 1000}) {
+                        TVector<double> results(evalDocCount);
+                        model.CalcFlatWithThreshold(evalFeatures, threshold, results, treeChunkSize);
+                        for (size_t docId = 0; docId < evalDocCount; ++docId) {
+                            UNIT_ASSERT_VALUES_EQUAL(canonResults[docId] > threshold, results[docId] > threshold);
+                            if (Abs(canonResults[docId] - threshold) <= 4 * std::numeric_limits<double>::epsilon() * Abs(threshold)) {
+                                UNIT_ASSERT_VALUES_EQUAL(canonResults[docId], results[docId]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    Y_UNIT_TEST(TestOptimizeTreeOrder) {
+        TFastRng64 rng(13);
+        for (int approxDimension : {1, 3}) {
+            auto model = RandomFloatModel(10, 20, 30, 6, approxDimension, rng);
+            // interleave trees of other depths
+            for (int treeDepth : {2, 8, 2, 6, 8}) {
+                TVector<int> tree;
+                for (int depth = 0; depth < treeDepth; ++depth) {
+                    tree.push_back(rng.Uniform(10 * 20));
+                }
+                model.ObliviousTrees.AddBinTree(tree);
+                for (int leafIdx = 0; leafIdx < (1 << treeDepth) * approxDimension; ++leafIdx) {
+                    model.ObliviousTrees.LeafValues.push_back(rng.GenRandReal1());
+                }
+            }
+            model.UpdateDynamicData();
+            const TFullModel originalModel = model;
+            const size_t docCount = 200;
+            TVector<TVector<float>> features(docCount, TVector<float>(model.ObliviousTrees.FloatFeatures.size()));
+            TVector<TConstArrayRef<float>> featureRefs;
+            for (auto& docFeatures : features) {
+                for (auto& value : docFeatures) {
+                    value = rng.GenRandReal1();
+                }
+                featureRefs.push_back(docFeatures);
+            }
+            TVector<double> canonResults(docCount * approxDimension);
+            originalModel.CalcFlat(featureRefs, canonResults);
+
+            const auto order = model.OptimizeTreeOrder();
+            UNIT_ASSERT_VALUES_EQUAL(model.ObliviousTrees.GetTreeDepthGroups().size(), 3);
+            for (size_t treeIdx = 0; treeIdx < order.size(); ++treeIdx) {
+                UNIT_ASSERT_VALUES_EQUAL(model.ObliviousTrees.TreeSizes[treeIdx], originalModel.ObliviousTrees.TreeSizes[order[treeIdx]]);
+                TVector<double> treeResults(docCount * approxDimension);
+                TVector<double> originalTreeResults(docCount * approxDimension);
+                model.CalcFlat(featureRefs, treeIdx, treeIdx + 1, treeResults);
+                originalModel.CalcFlat(featureRefs, order[treeIdx], order[treeIdx] + 1, originalTreeResults);
+                UNIT_ASSERT_EQUAL(treeResults, originalTreeResults);
+            }
+            TVector<double> results(docCount * approxDimension);
+            model.CalcFlat(featureRefs, results);
+            for (size_t idx = 0; idx < results.size(); ++idx) {
+                UNIT_ASSERT_DOUBLES_EQUAL(canonResults[idx], results[idx], 1e-9);
+            }
+
+            TVector<size_t> inverseOrder(order.size());
+            for (size_t treeIdx = 0; treeIdx < order.size(); ++treeIdx) {
+                inverseOrder[order[treeIdx]] = treeIdx;
+            }
+            model.ObliviousTrees.ReorderTrees(inverseOrder);
+            UNIT_ASSERT_EQUAL(model, originalModel);
+            UNIT_ASSERT_EXCEPTION(model.ObliviousTrees.ReorderTrees(TVector<size_t>(order.size(), 0)), TCatboostException);
+        }
+    }
 }
@@ -1,9 +1,21 @@
 #include "model_test_helpers.h"
 
+#include <catboost/libs/model/static_ctr_provider.h>
+#include <catboost/libs/model/flatbuffers/model.fbs.h>
+
 #include <library/unittest/registar.h>
 
+#include <util/stream/file.h>
+#include <util/system/unaligned_mem.h>
+
 using namespace std;
 
+static TString GetSavedFormatVersion(const TFullModel& model) {
+    const TString serializedModel = SerializeModel(model);
+    // descriptor and core size precede the core
+    return NCatBoostFbs::GetTModelCore(serializedModel.data() + 2 * sizeof(ui32))->FormatVersion()->c_str();
+}
+
 Y_UNIT_TEST_SUITE(TModelSerialization) {
     Y_UNIT_TEST(TestSerializeDeserializeFullModel) {
         TFullModel trainedModel = TrainFloatCatboostModel();
@@ -23,4 +35,167 @@ Y_UNIT_TEST_SUITE(TModelSerialization) {
         UNIT_ASSERT_EQUAL(trainedModel.ObliviousTrees.LeafValues, deserializedModel.ObliviousTrees.LeafValues);
         UNIT_ASSERT_EQUAL(trainedModel.ObliviousTrees.TreeSplits, deserializedModel.ObliviousTrees.TreeSplits);
     }
+
+    Y_UNIT_TEST(TestReadModelMmap) {
+        TFullModel trainedModel = TrainCatOnlyModel();
+        UNIT_ASSERT(!trainedModel.ObliviousTrees.GetUsedModelCtrs().empty());
+        OutputModel(trainedModel, "model_mmap.bin");
+        TFullModel mappedModel = ReadModelMmap("model_mmap.bin");
+        UNIT_ASSERT_EQUAL(trainedModel, mappedModel);
+        UNIT_ASSERT(mappedModel.HasValidCtrProvider());
+        const auto& ctrData = dynamic_cast<const TStaticCtrProvider&>(*mappedModel.CtrProvider).CtrData;
+        UNIT_ASSERT_EQUAL(dynamic_cast<const TStaticCtrProvider&>(*trainedModel.CtrProvider).CtrData, ctrData);
+
+        TVector<TVector<int>> catFeatures;
+        for (int docId = 0; docId < 20; ++docId) {
+            catFeatures.push_back({CalcCatFeatureHash(ToString(docId % 10)), CalcCatFeatureHash(ToString(docId % 7))});
+        }
+        TVector<TConstArrayRef<int>> catFeatureRefs(catFeatures.begin(), catFeatures.end());
+        TVector<TConstArrayRef<float>> floatFeatureRefs(catFeatures.size());
+        TVector<double> canonResults(catFeatures.size());
+        TVector<double> results(catFeatures.size());
+        trainedModel.Calc(floatFeatureRefs, catFeatureRefs, canonResults);
+        {
+            TFullModel modelCopy = mappedModel;
+            mappedModel = TFullModel();
+            modelCopy.Calc(floatFeatureRefs, catFeatureRefs, results);
+        }
+        UNIT_ASSERT_EQUAL(canonResults, results);
+    }
+
+    Y_UNIT_TEST(TestReadModelParallelCtrTables) {
+        TFullModel trainedModel = TrainCatOnlyModel();
+        OutputModel(trainedModel, "model_parallel.bin");
+        NPar::TLocalExecutor executor;
+        executor.RunAdditionalThreads(3);
+        for (bool inPlace : {false, true}) {
+            TModelLoadOptions options;
+            options.CtrTablesInPlace = inPlace;
+            options.Executor = &executor;
+            TModelLoadStats stats;
+            TFullModel loadedModel = ReadModel("model_parallel.bin", options, &stats);
+            UNIT_ASSERT_EQUAL(trainedModel, loadedModel);
+            const auto& ctrData = dynamic_cast<const TStaticCtrProvider&>(*loadedModel.CtrProvider).CtrData;
+            UNIT_ASSERT_EQUAL(dynamic_cast<const TStaticCtrProvider&>(*trainedModel.CtrProvider).CtrData, ctrData);
+            UNIT_ASSERT_VALUES_EQUAL(stats.CtrTableCount, ctrData.LearnCtrs.size());
+            UNIT_ASSERT(stats.CtrTablesBytes > 0);
+            for (const auto& ctrBaseAndTable : ctrData.LearnCtrs) {
+                UNIT_ASSERT_VALUES_EQUAL(ctrBaseAndTable.second.IsThin(), inPlace);
+            }
+        }
+    }
+    Y_UNIT_TEST(TestReadCorruptedCtrTable) {
+        TFullModel trainedModel = TrainCatOnlyModel();
+        TString serializedModel = SerializeModel(trainedModel);
+        // descriptor, core size, core, ctr table count, first table size and first table root offset
+        const size_t coreSize = ReadUnaligned<ui32>(serializedModel.data() + sizeof(ui32));
+        const size_t rootOffsetPos = 2 * sizeof(ui32) + coreSize + 2 * sizeof(ui32);
+        UNIT_ASSERT(rootOffsetPos + sizeof(ui32) <= serializedModel.size());
+        WriteUnaligned<ui32>(serializedModel.begin() + rootOffsetPos, Max<ui32>());
+        {
+            TOFStream out("model_corrupted.bin");
+            out.Write(serializedModel);
+        }
+        UNIT_ASSERT_EXCEPTION(ReadModel("model_corrupted.bin"), TCatboostException);
+        UNIT_ASSERT_EXCEPTION(ReadModelMmap("model_corrupted.bin"), TCatboostException);
+    }
+
+    Y_UNIT_TEST(TestCtrTablesCuckooIndexLayout) {
+        TFullModel trainedModel = TrainCatOnlyModel();
+        TVector<TVector<int>> catFeatures;
+        for (int docId = 0; docId < 20; ++docId) {
+            catFeatures.push_back({CalcCatFeatureHash(ToString(docId % 12)), CalcCatFeatureHash(ToString(docId % 7))});
+        }
+        TVector<TConstArrayRef<int>> catFeatureRefs(catFeatures.begin(), catFeatures.end());
+        TVector<TConstArrayRef<float>> floatFeatureRefs(catFeatures.size());
+        TVector<double> canonResults(catFeatures.size());
+        trainedModel.Calc(floatFeatureRefs, catFeatureRefs, canonResults);
+
+        // ctr provider is shared between model copies, so layout is changed in deserialized copy
+        const TString serializedModel = SerializeModel(trainedModel);
+        TFullModel cuckooModel = ReadModel(serializedModel.data(), serializedModel.size());
+        cuckooModel.SetCtrTablesIndexLayout(ECtrTableIndexLayout::BucketizedCuckoo);
+        // older versions can't read cuckoo index
+        UNIT_ASSERT_VALUES_EQUAL(GetSavedFormatVersion(trainedModel), "FlabuffersModel_v1");
+        UNIT_ASSERT_VALUES_EQUAL(GetSavedFormatVersion(cuckooModel), "FlabuffersModel_v2");
+        OutputModel(cuckooModel, "model_cuckoo.bin");
+        for (const auto& loadedModel : {ReadModel("model_cuckoo.bin"), ReadModelMmap("model_cuckoo.bin")}) {
+            UNIT_ASSERT_EQUAL(cuckooModel, loadedModel);
+            const auto& ctrData = dynamic_cast<const TStaticCtrProvider&>(*loadedModel.CtrProvider).CtrData;
+            UNIT_ASSERT_EQUAL(dynamic_cast<const TStaticCtrProvider&>(*cuckooModel.CtrProvider).CtrData, ctrData);
+            for (const auto& ctrBaseAndTable : ctrData.LearnCtrs) {
+                UNIT_ASSERT_EQUAL(ctrBaseAndTable.second.GetIndexLayout(), ECtrTableIndexLayout::BucketizedCuckoo);
+                UNIT_ASSERT(NCatboost::IsCacheLineAligned(ctrBaseAndTable.second.GetCuckooIndexHashViewer().GetGroups().data()));
+            }
+            TVector<double> results(catFeatures.size());
+            loadedModel.Calc(floatFeatureRefs, catFeatureRefs, results);
+            UNIT_ASSERT_EQUAL(canonResults, results);
+        }
+
+        cuckooModel.SetCtrTablesIndexLayout(ECtrTableIndexLayout::LinearProbing);
+        UNIT_ASSERT_VALUES_EQUAL(GetSavedFormatVersion(cuckooModel), "FlabuffersModel_v1");
+        TVector<double> results(catFeatures.size());
+        cuckooModel.Calc(floatFeatureRefs, catFeatureRefs, results);
+        UNIT_ASSERT_EQUAL(canonResults, results);
+    }
+
+    Y_UNIT_TEST(TestPrecomputedCtrValues) {
+        TFullModel trainedModel = TrainCatOnlyModel();
+        TVector<TVector<int>> catFeatures;
+        for (int docId = 0; docId < 20; ++docId) {
+            catFeatures.push_back({CalcCatFeatureHash(ToString(docId % 12)), CalcCatFeatureHash(ToString(docId % 7))});
+        }
+        TVector<TConstArrayRef<int>> catFeatureRefs(catFeatures.begin(), catFeatures.end());
+        TVector<TConstArrayRef<float>> floatFeatureRefs(catFeatures.size());
+        TVector<double> canonResults(catFeatures.size());
+        trainedModel.Calc(floatFeatureRefs, catFeatureRefs, canonResults);
+
+        const TString serializedModel = SerializeModel(trainedModel);
+        TFullModel keptCountersModel = ReadModel(serializedModel.data(), serializedModel.size());
+        keptCountersModel.PrecomputeCtrValues(/*dropCounters*/ false);
+        UNIT_ASSERT_VALUES_EQUAL(GetSavedFormatVersion(keptCountersModel), "FlabuffersModel_v1");
+        TFullModel precomputedModel = ReadModel(serializedModel.data(), serializedModel.size());
+        precomputedModel.PrecomputeCtrValues(/*dropCounters*/ true);
+        // older versions read counters of all tables
+        UNIT_ASSERT_VALUES_EQUAL(GetSavedFormatVersion(precomputedModel), "FlabuffersModel_v2");
+        OutputModel(precomputedModel, "model_precomputed_ctrs.bin");
+        UNIT_ASSERT(SerializeModel(precomputedModel).size() < serializedModel.size());
+        for (const auto& loadedModel : {ReadModel("model_precomputed_ctrs.bin"), ReadModelMmap("model_precomputed_ctrs.bin")}) {
+            UNIT_ASSERT_EQUAL(precomputedModel, loadedModel);
+            const auto& ctrData = dynamic_cast<const TStaticCtrProvider&>(*loadedModel.CtrProvider).CtrData;
+            UNIT_ASSERT_EQUAL(dynamic_cast<const TStaticCtrProvider&>(*precomputedModel.CtrProvider).CtrData, ctrData);
+            TVector<double> results(catFeatures.size());
+            loadedModel.Calc(floatFeatureRefs, catFeatureRefs, results);
+            UNIT_ASSERT_EQUAL(canonResults, results);
+        }
+    }
+
+    Y_UNIT_TEST(TestReadCorruptedPrecomputedCtrValues) {
+        TFullModel model = TrainCatOnlyModel();
+        model.PrecomputeCtrValues(/*dropCounters*/ true);
+        const auto& ctrData = dynamic_cast<const TStaticCtrProvider&>(*model.CtrProvider).CtrData;
+        UNIT_ASSERT(!ctrData.LearnCtrs.empty());
+        for (const auto& ctrBaseAndTable : ctrData.LearnCtrs) {
+            for (auto layout : {ECtrTableIndexLayout::LinearProbing, ECtrTableIndexLayout::BucketizedCuckoo}) {
+                TCtrValueTable table = ctrBaseAndTable.second;
+                table.SetIndexLayout(layout);
+                UNIT_ASSERT(!table.PrecomputedCtrs.empty());
+                {
+                    TStringStream stream;
+                    table.Save(&stream);
+                    TCtrValueTable loadedTable;
+                    loadedTable.Load(&stream);
+                    UNIT_ASSERT_EQUAL(table, loadedTable);
+                }
+                for (size_t binCount : {size_t(0), table.GetIndexValueCount()}) {
+                    TCtrValueTable corruptedTable = table;
+                    corruptedTable.PrecomputedCtrs[0].Bins.resize(binCount);
+                    TStringStream stream;
+                    corruptedTable.Save(&stream);
+                    TCtrValueTable loadedTable;
+                    UNIT_ASSERT_EXCEPTION(loadedTable.Load(&stream), TCatboostException);
+                }
+            }
+        }
+    }
 }
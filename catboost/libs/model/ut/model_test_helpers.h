@@ -1,6 +1,9 @@
 #pragma once
 
 #include <catboost/libs/train_lib/train_model.h>
+#include <catboost/libs/cat_feature/cat_feature.h>
+
+#include <util/random/fast.h>
 
 TFullModel TrainFloatCatboostModel() {
     TPool pool;
@@ -18,3 +21,25 @@ TFullModel TrainFloatCatboostModel() {
 
     return model;
 }
+
+TFullModel TrainCatOnlyModel() {
+    TFastRng64 rng(0);
+    TPool pool;
+    pool.Docs.Resize(/*doc count*/100, /*factors count*/ 2, /*baseline dimension*/ 0, /*has queryId*/ false, /*has subgroupId*/ false);
+    pool.CatFeatures = {0, 1};
+    for (size_t docId = 0; docId < 100; ++docId) {
+        pool.Docs.Target[docId] = rng.GenRandReal1();
+        for (int factorIdx = 0; factorIdx < 2; ++factorIdx) {
+            pool.Docs.Factors[factorIdx][docId] = ConvertCatFeatureHashToFloat(CalcCatFeatureHash(ToString(rng.Uniform(10))));
+        }
+    }
+
+    TFullModel model;
+    TEvalResult evalResult;
+    NJson::TJsonValue params;
+    params.InsertValue("iterations", 5);
+    params.InsertValue("random_seed", 0);
+    TrainModel(params, Nothing(), Nothing(), pool, false, pool, "", &model, &evalResult);
+
+    return model;
+}
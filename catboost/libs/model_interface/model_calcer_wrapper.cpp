@@ -2,11 +2,20 @@
 
 #include <catboost/libs/model/model.h>
 
+#include <library/threading/local_executor/local_executor.h>
+
 #include <util/generic/singleton.h>
 #include <util/stream/file.h>
 #include <util/string/builder.h>
 
-#define FULL_MODEL_PTR(x) ((TFullModel*)(x))
+struct TModelCalcerHandleImpl {
+    TFullModel Model;
+    THolder<NPar::TLocalExecutor> Executor;
+};
+
+#define CALCER_PTR(x) ((TModelCalcerHandleImpl*)(x))
+#define FULL_MODEL_PTR(x) (&CALCER_PTR(x)->Model)
+#define EXECUTOR_PTR(x) (CALCER_PTR(x)->Executor.Get())
 
 
 struct TErrorMessageHolder {
@@ -16,7 +25,7 @@ struct TErrorMessageHolder {
 extern "C" {
 EXPORT ModelCalcerHandle* ModelCalcerCreate() {
     try {
-        return new TFullModel;
+        return new TModelCalcerHandleImpl;
     } catch (...) {
         Singleton<TErrorMessageHolder>()->Message = CurrentExceptionMessage();
     }
@@ -30,7 +39,7 @@ EXPORT const char* GetErrorString() {
 
 EXPORT void ModelCalcerDelete(ModelCalcerHandle* modelHandle) {
     if (modelHandle != nullptr) {
-        delete FULL_MODEL_PTR(modelHandle);
+        delete CALCER_PTR(modelHandle);
     }
 }
 
@@ -56,6 +65,23 @@ EXPORT bool LoadFullModelFromBuffer(ModelCalcerHandle* modelHandle, const void*
     return true;
 }
 
+EXPORT bool SetPredictionThreadCount(ModelCalcerHandle* modelHandle, int threadCount) {
+    try {
+        CB_ENSURE(threadCount > 0, "Thread count should be positive, got " << threadCount);
+        auto& executor = CALCER_PTR(modelHandle)->Executor;
+        executor.Reset();
+        if (threadCount > 1) {
+            executor = MakeHolder<NPar::TLocalExecutor>();
+            executor->RunAdditionalThreads(threadCount - 1);
+        }
+    } catch (...) {
+        Singleton<TErrorMessageHolder>()->Message = CurrentExceptionMessage();
+        return false;
+    }
+
+    return true;
+}
+
 EXPORT bool CalcModelPredictionFlat(ModelCalcerHandle* modelHandle, size_t docCount, const float** floatFeatures, size_t floatFeaturesSize, double* result, size_t resultSize) {
     try {
         if (docCount == 1) {
@@ -65,7 +91,7 @@ EXPORT bool CalcModelPredictionFlat(ModelCalcerHandle* modelHandle, size_t docCo
             for (size_t i = 0; i < docCount; ++i) {
                 featuresVec[i] = TConstArrayRef<float>(floatFeatures[i], floatFeaturesSize);
             }
-            FULL_MODEL_PTR(modelHandle)->CalcFlat(featuresVec, TArrayRef<double>(result, resultSize));
+            FULL_MODEL_PTR(modelHandle)->CalcFlat(featuresVec, TArrayRef<double>(result, resultSize), EXECUTOR_PTR(modelHandle));
         }
     } catch (...) {
         Singleton<TErrorMessageHolder>()->Message = CurrentExceptionMessage();
@@ -89,7 +115,7 @@ EXPORT bool CalcModelPrediction(
                 catFeaturesVec[i][catFeatureIdx] = catFeatures[i][catFeatureIdx];
             }
         }
-        FULL_MODEL_PTR(modelHandle)->Calc(floatFeaturesVec, catFeaturesVec, TArrayRef<double>(result, resultSize));
+        FULL_MODEL_PTR(modelHandle)->Calc(floatFeaturesVec, catFeaturesVec, TArrayRef<double>(result, resultSize), EXECUTOR_PTR(modelHandle));
     } catch (...) {
         Singleton<TErrorMessageHolder>()->Message = CurrentExceptionMessage();
         return false;
@@ -128,7 +154,26 @@ EXPORT bool CalcModelPredictionWithHashedCatFeatures(ModelCalcerHandle* modelHan
             floatFeaturesVec[i] = TConstArrayRef<float>(floatFeatures[i], floatFeaturesSize);
             catFeaturesVec[i] = TConstArrayRef<int>(catFeatures[i], catFeaturesSize);
         }
-        FULL_MODEL_PTR(modelHandle)->Calc(floatFeaturesVec, catFeaturesVec, TArrayRef<double>(result, resultSize));
+        FULL_MODEL_PTR(modelHandle)->Calc(floatFeaturesVec, catFeaturesVec, TArrayRef<double>(result, resultSize), EXECUTOR_PTR(modelHandle));
+    } catch (...) {
+        Singleton<TErrorMessageHolder>()->Message = CurrentExceptionMessage();
+        return false;
+    }
+    return true;
+}
+
+EXPORT bool CalcModelLeafIndexesFlat(
+        ModelCalcerHandle* modelHandle,
+        size_t docCount,
+        const float** floatFeatures, size_t floatFeaturesSize,
+        size_t treeStart, size_t treeEnd,
+        unsigned short* leafIndexes, size_t leafIndexesSize) {
+    try {
+        TVector<TConstArrayRef<float>> featuresVec(docCount);
+        for (size_t i = 0; i < docCount; ++i) {
+            featuresVec[i] = TConstArrayRef<float>(floatFeatures[i], floatFeaturesSize);
+        }
+        FULL_MODEL_PTR(modelHandle)->CalcLeafIndexesFlat(featuresVec, treeStart, treeEnd, TArrayRef<ui16>(leafIndexes, leafIndexesSize));
     } catch (...) {
         Singleton<TErrorMessageHolder>()->Message = CurrentExceptionMessage();
         return false;
@@ -154,4 +199,8 @@ EXPORT size_t GetCatFeaturesCount(ModelCalcerHandle* modelHandle) {
     return FULL_MODEL_PTR(modelHandle)->GetNumCatFeatures();
 }
 
+EXPORT size_t GetTreeCount(ModelCalcerHandle* modelHandle) {
+    return FULL_MODEL_PTR(modelHandle)->GetTreeCount();
+}
+
 }
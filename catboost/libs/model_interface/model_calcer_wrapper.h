@@ -59,6 +59,17 @@ EXPORT bool LoadFullModelFromBuffer(
     const void* binaryBuffer,
     size_t binaryBufferSize);
 
+/**
+ * Set number of threads used for batch predictions by given model handle (1 by default).
+ * Objects are split between threads by ranges of whole evaluation blocks, so small batches still use one thread.
+ * @param calcer model handle
+ * @param threadCount thread count including the calling thread
+ * @return false if error occured
+ */
+EXPORT bool SetPredictionThreadCount(
+    ModelCalcerHandle* calcer,
+    int threadCount);
+
 /**
  * **Use this method only if you really understand what you want.**
  * Calculate raw model predictions on flat feature vectors
@@ -139,6 +150,25 @@ EXPORT bool CalcModelPredictionWithHashedCatFeatures(
     const int** catFeatures, size_t catFeaturesSize,
     double* result, size_t resultSize);
 
+/**
+ * Calculate leaf indexes of trees [treeStart, treeEnd) on flat feature vectors
+ * @param calcer model handle
+ * @param docCount number of objects
+ * @param floatFeatures array of array of float (first dimension is object index, second if feature index)
+ * @param floatFeaturesSize float values array size
+ * @param treeStart index of first tree
+ * @param treeEnd index of tree after the last tree, should not exceed GetTreeCount
+ * @param leafIndexes pointer to user allocated indexes vector, indexation is [objectIndex * (treeEnd - treeStart) + treeIndex - treeStart]
+ * @param leafIndexesSize should be equal to (treeEnd - treeStart) * docCount
+ * @return false if error occured
+ */
+EXPORT bool CalcModelLeafIndexesFlat(
+    ModelCalcerHandle* calcer,
+    size_t docCount,
+    const float** floatFeatures, size_t floatFeaturesSize,
+    size_t treeStart, size_t treeEnd,
+    unsigned short* leafIndexes, size_t leafIndexesSize);
+
 /**
  * Get hash for given string value
  * @param data we don't expect data to be zero terminated, so pass correct size
@@ -168,6 +198,12 @@ EXPORT size_t GetFloatFeaturesCount(ModelCalcerHandle* calcer);
  */
 EXPORT size_t GetCatFeaturesCount(ModelCalcerHandle* calcer);
 
+/**
+ * Get tree count of the model
+ * @param calcer model handle
+ */
+EXPORT size_t GetTreeCount(ModelCalcerHandle* calcer);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -7,6 +7,7 @@
 #include <vector>
 #include <functional>
 #include <memory>
+#include <stdexcept>
 
 /**
  * Model C API header-only wrapper class
@@ -44,6 +45,15 @@ public:
             throw std::runtime_error(GetErrorString());
         }
     }
+    /**
+     * Use threadCount threads (including the calling one) for batch predictions
+     * @param[in] threadCount
+     */
+    void SetThreadCount(int threadCount) {
+        if (!SetPredictionThreadCount(CalcerHolder.get(), threadCount)) {
+            throw std::runtime_error(GetErrorString());
+        }
+    }
     /**
      * Evaluate model on single object flat features vector.
      * Flat here means that float features and categorical feature are in the same float array.
@@ -189,6 +199,26 @@ public:
         return result;
     }
 
+    /**
+     * Calculate leaf indexes of all trees on flat feature vectors for multiple objects.
+     * @param features
+     * @return leaf indexes with indexation [objectIndex * treeCount + treeIndex]
+     */
+    std::vector<unsigned short> CalcFlatLeafIndexes(const std::vector<std::vector<float>>& features) const {
+        const size_t treeCount = GetTreeCount(CalcerHolder.get());
+        std::vector<unsigned short> result(features.size() * treeCount);
+        std::vector<const float*> ptrsVector;
+        size_t flatVecSize = 0;
+        for (const auto& flatVec : features) {
+            flatVecSize = flatVec.size();
+            ptrsVector.push_back(flatVec.data());
+        }
+        if (!CalcModelLeafIndexesFlat(CalcerHolder.get(), features.size(), ptrsVector.data(), flatVecSize, 0, treeCount, result.data(), result.size())) {
+            throw std::runtime_error(GetErrorString());
+        }
+        return result;
+    }
+
     bool init_from_file(const std::string& filename) {
         return LoadFullModelFromFile(CalcerHolder.get(), filename.c_str());
     }
@@ -206,6 +206,17 @@ enum class EModelType {
     Python
 };
 
+enum class ELeafValuesPrecision {
+    Double,
+    Float,
+    Int16
+};
+
+enum class ECtrTableIndexLayout {
+    LinearProbing,
+    BucketizedCuckoo
+};
+
 enum class EFinalCtrComputationMode {
     Skip,
     Default
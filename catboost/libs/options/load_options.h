@@ -20,6 +20,9 @@ namespace NCatboostOptions {
 
         NCB::TPathWithScheme CdFilePath;
 
+        // read pool from binary cache next to the pool file, create it if absent or outdated
+        bool UsePoolCache = false;
+
         TDsvPoolFormatParams() = default;
 
         void Validate() const {
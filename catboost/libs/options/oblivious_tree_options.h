@@ -23,6 +23,7 @@ namespace NCatboostOptions {
             , BootstrapConfig("bootstrap", TBootstrapConfig(taskType))
             , Rsm("rsm", 1.0, taskType)
             , SamplingFrequency("sampling_frequency", ESamplingFrequency::PerTreeLevel, taskType)
+            , DevScoreCalcStatsSubtraction("dev_score_calc_stats_subtraction", true, taskType)
             , ModelSizeReg("model_size_reg", 0.5, taskType)
             , ObservationsToBootstrap("observations_to_bootstrap", EObservationsToBootstrap::TestOnly, taskType) //it's specific for fold-based scheme, so here and not in bootstrap options
             , FoldSizeLossNormalization("fold_size_loss_normalization", false, taskType)
@@ -33,6 +34,7 @@ namespace NCatboostOptions {
         {
             Rsm.ChangeLoadUnimplementedPolicy(ELoadUnimplementedPolicy::ExceptionOnChange);
             SamplingFrequency.ChangeLoadUnimplementedPolicy(ELoadUnimplementedPolicy::ExceptionOnChange);
+            DevScoreCalcStatsSubtraction.ChangeLoadUnimplementedPolicy(ELoadUnimplementedPolicy::SkipWithWarning);
 
             FoldSizeLossNormalization.ChangeLoadUnimplementedPolicy(ELoadUnimplementedPolicy::ExceptionOnChange);
             AddRidgeToTargetFunctionFlag.ChangeLoadUnimplementedPolicy(ELoadUnimplementedPolicy::ExceptionOnChange);
@@ -52,7 +54,8 @@ namespace NCatboostOptions {
                         &ObservationsToBootstrap,
                         &PairwiseNonDiagReg,
                         &LeavesEstimationBacktrackingType,
-                        &SamplingFrequency);
+                        &SamplingFrequency,
+                        &DevScoreCalcStatsSubtraction);
 
             Validate();
         }
@@ -64,19 +67,21 @@ namespace NCatboostOptions {
                        ScoreFunction,
                        PairwiseNonDiagReg,
                        LeavesEstimationBacktrackingType,
-                       MaxCtrComplexityForBordersCaching, Rsm, ObservationsToBootstrap, SamplingFrequency);
+                       MaxCtrComplexityForBordersCaching, Rsm, ObservationsToBootstrap, SamplingFrequency,
+                       DevScoreCalcStatsSubtraction);
         }
 
         bool operator==(const TObliviousTreeLearnerOptions& rhs) const {
             return std::tie(MaxDepth, LeavesEstimationIterations, LeavesEstimationMethod, L2Reg, ModelSizeReg, RandomStrength,
                             BootstrapConfig, Rsm, SamplingFrequency, ObservationsToBootstrap, FoldSizeLossNormalization,
                             AddRidgeToTargetFunctionFlag, ScoreFunction, MaxCtrComplexityForBordersCaching,
-                            PairwiseNonDiagReg, LeavesEstimationBacktrackingType
+                            PairwiseNonDiagReg, LeavesEstimationBacktrackingType, DevScoreCalcStatsSubtraction
             ) ==
                    std::tie(rhs.MaxDepth, rhs.LeavesEstimationIterations, rhs.LeavesEstimationMethod, rhs.L2Reg, rhs.ModelSizeReg,
                             rhs.RandomStrength, rhs.BootstrapConfig, rhs.Rsm, rhs.SamplingFrequency,
                             rhs.ObservationsToBootstrap, rhs.FoldSizeLossNormalization, rhs.AddRidgeToTargetFunctionFlag,
-                            rhs.ScoreFunction, rhs.MaxCtrComplexityForBordersCaching, rhs.PairwiseNonDiagReg, rhs.LeavesEstimationBacktrackingType);
+                            rhs.ScoreFunction, rhs.MaxCtrComplexityForBordersCaching, rhs.PairwiseNonDiagReg, rhs.LeavesEstimationBacktrackingType,
+                            rhs.DevScoreCalcStatsSubtraction);
         }
 
         bool operator!=(const TObliviousTreeLearnerOptions& rhs) const {
@@ -105,6 +110,7 @@ namespace NCatboostOptions {
         TCpuOnlyOption<float> Rsm;
         TCpuOnlyOption<ESamplingFrequency> SamplingFrequency;
         TCpuOnlyOption<float> ModelSizeReg;
+        TCpuOnlyOption<bool> DevScoreCalcStatsSubtraction;
 
         TGpuOnlyOption<EObservationsToBootstrap> ObservationsToBootstrap;
         TGpuOnlyOption<bool> FoldSizeLossNormalization;
@@ -152,6 +152,7 @@ namespace NCatboostOptions {
         CopyOption(plainOptions, "fold_size_loss_normalization", &treeOptions, &seenKeys);
         CopyOption(plainOptions, "add_ridge_penalty_to_loss_function", &treeOptions, &seenKeys);
         CopyOption(plainOptions, "sampling_frequency", &treeOptions, &seenKeys);
+        CopyOption(plainOptions, "dev_score_calc_stats_subtraction", &treeOptions, &seenKeys);
         CopyOption(plainOptions, "dev_max_ctr_complexity_for_border_cache", &treeOptions, &seenKeys);
         CopyOption(plainOptions, "observations_to_bootstrap", &treeOptions, &seenKeys);
 
@@ -211,6 +212,7 @@ namespace NCatboostOptions {
         CopyOptionWithNewKey(plainOptions, "device_config", "devices", &systemOptions, &seenKeys);
         CopyOption(plainOptions, "devices", &systemOptions, &seenKeys);
         CopyOption(plainOptions, "used_ram_limit", &systemOptions, &seenKeys);
+        CopyOption(plainOptions, "online_ctr_cache_size", &systemOptions, &seenKeys);
         CopyOption(plainOptions, "gpu_ram_part", &systemOptions, &seenKeys);
         CopyOptionWithNewKey(plainOptions, "pinned_memory_size",
                              "pinned_memory_bytes", &systemOptions, &seenKeys);
@@ -12,6 +12,7 @@ using namespace NCatboostOptions;
 TSystemOptions::TSystemOptions(ETaskType taskType)
     : NumThreads("thread_count", NSystemInfo::CachedNumberOfCpus())
     , CpuUsedRamLimit("used_ram_limit", {}, taskType)
+    , CpuOnlineCtrCacheSize("online_ctr_cache_size", {}, taskType)
     , Devices("devices", "-1", taskType)
     , GpuRamPart("gpu_ram_part", 0.95, taskType)
     , PinnedMemorySize("pinned_memory_bytes", 104857600, taskType)
@@ -20,23 +21,24 @@ TSystemOptions::TSystemOptions(ETaskType taskType)
     , NodePort("node_port", GetUnusedNodePort(), taskType)
 {
     CpuUsedRamLimit.ChangeLoadUnimplementedPolicy(ELoadUnimplementedPolicy::SkipWithWarning);
+    CpuOnlineCtrCacheSize.ChangeLoadUnimplementedPolicy(ELoadUnimplementedPolicy::SkipWithWarning);
     Devices.ChangeLoadUnimplementedPolicy(ELoadUnimplementedPolicy::SkipWithWarning);
     GpuRamPart.ChangeLoadUnimplementedPolicy(ELoadUnimplementedPolicy::SkipWithWarning);
     PinnedMemorySize.ChangeLoadUnimplementedPolicy(ELoadUnimplementedPolicy::SkipWithWarning);
 }
 
 void TSystemOptions::Load(const NJson::TJsonValue& options) {
-    CheckedLoad(options, &NumThreads, &CpuUsedRamLimit, &Devices, &GpuRamPart, &PinnedMemorySize, &NodeType, &FileWithHosts, &NodePort);
+    CheckedLoad(options, &NumThreads, &CpuUsedRamLimit, &CpuOnlineCtrCacheSize, &Devices, &GpuRamPart, &PinnedMemorySize, &NodeType, &FileWithHosts, &NodePort);
 }
 
 void TSystemOptions::Save(NJson::TJsonValue* options) const {
-    SaveFields(options, NumThreads, CpuUsedRamLimit, Devices, GpuRamPart, PinnedMemorySize, NodeType, FileWithHosts, NodePort);
+    SaveFields(options, NumThreads, CpuUsedRamLimit, CpuOnlineCtrCacheSize, Devices, GpuRamPart, PinnedMemorySize, NodeType, FileWithHosts, NodePort);
 }
 
 bool TSystemOptions::operator==(const TSystemOptions& rhs) const {
-    return std::tie(NumThreads, CpuUsedRamLimit, Devices,
+    return std::tie(NumThreads, CpuUsedRamLimit, CpuOnlineCtrCacheSize, Devices,
                     GpuRamPart, PinnedMemorySize, NodeType, FileWithHosts, NodePort) ==
-           std::tie(rhs.NumThreads, rhs.CpuUsedRamLimit, rhs.Devices,
+           std::tie(rhs.NumThreads, rhs.CpuUsedRamLimit, rhs.CpuOnlineCtrCacheSize, rhs.Devices,
                     rhs.GpuRamPart, rhs.PinnedMemorySize, rhs.NodeType, rhs.FileWithHosts, rhs.NodePort);
 }
 
@@ -50,6 +52,9 @@ void TSystemOptions::Validate() const {
     if (!CpuUsedRamLimit.IsUnimplementedForCurrentTask()) {
         ParseMemorySizeDescription(CpuUsedRamLimit);
     }
+    if (!CpuOnlineCtrCacheSize.IsUnimplementedForCurrentTask()) {
+        ParseMemorySizeDescription(CpuOnlineCtrCacheSize);
+    }
 }
 
 bool TSystemOptions::IsMaster() const {
@@ -93,5 +98,5 @@ ui64 ParseMemorySizeDescription(const TString& description) {
             return Max<ui64>();
         }
     }
-    CB_ENSURE(false, "incomprehensible value ('used_ram_limit'): " << description);
+    CB_ENSURE(false, "incomprehensible memory size value: " << description);
 }
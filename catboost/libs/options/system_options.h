@@ -19,6 +19,7 @@ namespace NCatboostOptions {
 
         TOption<ui32> NumThreads;
         TCpuOnlyOption<TString> CpuUsedRamLimit;
+        TCpuOnlyOption<TString> CpuOnlineCtrCacheSize;
         TGpuOnlyOption<TString> Devices;
         TGpuOnlyOption<double> GpuRamPart;
         TGpuOnlyOption<ui64> PinnedMemorySize;
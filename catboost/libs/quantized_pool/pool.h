@@ -48,6 +48,9 @@ namespace NCB {
         TVector<size_t> IgnoredColumnIndices;
 
         TVector<TBlob> Blobs;
+
+        // Chunks point into file mapping that is not locked in memory, so their pages may be evicted.
+        bool AreChunksEvictable = false;
     };
 
     struct TQuantizedPoolDigest {
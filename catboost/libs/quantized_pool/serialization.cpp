@@ -5,6 +5,7 @@
 #include <catboost/idl/pool/proto/metainfo.pb.h>
 #include <catboost/idl/pool/proto/quantization_schema.pb.h>
 #include <catboost/libs/helpers/exception.h>
+#include <catboost/libs/logging/logging.h>
 
 #include <contrib/libs/flatbuffers/include/flatbuffers/flatbuffers.h>
 
@@ -25,6 +26,7 @@
 #include <util/stream/mem.h>
 #include <util/stream/output.h>
 #include <util/system/byteorder.h>
+#include <util/system/madvise.h>
 #include <util/system/unaligned_mem.h>
 
 using NCB::NIdl::TPoolMetainfo;
@@ -484,11 +486,14 @@ NCB::TQuantizedPool NCB::LoadQuantizedPool(
     const TLoadQuantizedPoolParameters& params) {
 
     TQuantizedPool pool;
-    pool.Blobs.push_back(params.LockMemory
-        ? TBlob::LockedFromFile(TString(path))
-        : TBlob::FromFile(TString(path)));
-
-    // TODO(yazevnul): optionally precharge pool
+    if (params.LockMemory) {
+        pool.Blobs.push_back(TBlob::LockedFromFile(TString(path)));
+    } else if (params.Precharge) {
+        pool.Blobs.push_back(TBlob::PrechargedFromFile(TString(path)));
+    } else {
+        pool.Blobs.push_back(TBlob::FromFile(TString(path)));
+    }
+    pool.AreChunksEvictable = !params.LockMemory;
 
     const TConstArrayRef<char> blobView{
         pool.Blobs.back().AsCharPtr(),
@@ -500,6 +505,63 @@ NCB::TQuantizedPool NCB::LoadQuantizedPool(
     return pool;
 }
 
+// Chunks of one column are written one after another, so memory of the column is a single range
+static TConstArrayRef<ui8> GetColumnMemory(const NCB::TQuantizedPool& pool, const size_t localIndex) {
+    const ui8* begin = nullptr;
+    const ui8* end = nullptr;
+    for (const auto& chunk : pool.Chunks[localIndex]) {
+        const auto* const quants = chunk.Chunk->Quants();
+        if (!quants || quants->size() == 0) {
+            continue;
+        }
+
+        begin = begin ? Min(begin, quants->data()) : quants->data();
+        end = Max(end, quants->data() + quants->size());
+    }
+
+    return {begin, static_cast<size_t>(end - begin)};
+}
+
+// Advices are hints only, so they are best effort: failures are logged and don't stop the caller
+void NCB::AdviseSequentialColumnAccess(const TQuantizedPool& pool, const size_t localIndex) {
+    if (!pool.AreChunksEvictable) {
+        return;
+    }
+
+    const auto memory = GetColumnMemory(pool, localIndex);
+    if (!memory) {
+        return;
+    }
+
+    try {
+        MadviseSequentialAccess(memory.data(), memory.size());
+    } catch (const yexception& e) {
+        MATRIXNET_DEBUG_LOG << "Sequential access advice for column " << localIndex << " failed: " << e.what() << Endl;
+    }
+}
+
+void NCB::EvictColumn(const TQuantizedPool& pool, const size_t localIndex) {
+    if (!pool.AreChunksEvictable) {
+        return;
+    }
+
+#if defined(_win_)
+    // Pages of mapped file views can't be decommitted on Windows, system trims them itself
+    Y_UNUSED(localIndex);
+#else
+    const auto memory = GetColumnMemory(pool, localIndex);
+    if (!memory) {
+        return;
+    }
+
+    try {
+        MadviseEvict(memory.data(), memory.size());
+    } catch (const yexception& e) {
+        MATRIXNET_DEBUG_LOG << "Eviction of column " << localIndex << " failed: " << e.what() << Endl;
+    }
+#endif
+}
+
 static NCB::TQuantizedPoolDigest GetQuantizedPoolDigest(
     const TPoolMetainfo& poolMetainfo,
     const TPoolQuantizationSchema& quantizationSchema) {
@@ -16,14 +16,27 @@ namespace NCB {
 namespace NCB {
     void SaveQuantizedPool(const TQuantizedPool& pool, IOutputStream* output);
 
+    // Pool file is always memory mapped and chunks in `TQuantizedPool` point directly into the mapping.
     struct TLoadQuantizedPoolParameters {
+        // Read all pages of the file and lock them in memory.
         bool LockMemory = true;
+        // Read all pages of the file during loading (ignored if `LockMemory` is set). If both flags are
+        // false pages are read on the first access to chunks, so only used columns take memory.
         bool Precharge = true;
     };
 
     // Load quantized pool saved by `SaveQuantizedPool` from file.
     TQuantizedPool LoadQuantizedPool(TStringBuf path, const TLoadQuantizedPoolParameters& params);
 
+    // Hint the kernel to read ahead chunks of column `localIndex`. No-op if memory of chunks is locked.
+    // Best effort: failure of the hint is logged, not thrown.
+    void AdviseSequentialColumnAccess(const TQuantizedPool& pool, size_t localIndex);
+
+    // Release memory of chunks of column `localIndex`, pages will be read from file again on the next
+    // access. No-op if memory of chunks is locked, and on Windows, where mapped views can't be
+    // decommitted. Best effort: failure of the eviction is logged, not thrown.
+    void EvictColumn(const TQuantizedPool& pool, size_t localIndex);
+
     NIdl::TPoolQuantizationSchema LoadQuantizationSchemaFromPool(TStringBuf path);
     NIdl::TPoolMetainfo LoadPoolMetainfo(TStringBuf path);
     TQuantizedPoolDigest CalculateQuantizedPoolDigest(TStringBuf path);
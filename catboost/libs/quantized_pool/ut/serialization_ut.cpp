@@ -154,6 +154,26 @@ Y_UNIT_TEST_SUITE(SerializationTests) {
         UNIT_ASSERT_VALUES_EQUAL(loadedPoolAsText, poolAsText);
     }
 
+    Y_UNIT_TEST(TestEvictColumns) {
+        const auto pool = MakeQuantizedPool();
+        const auto path = TFsPath(GetSystemTempDir()) / "quantized_pool.bin";
+
+        {
+            TFileOutput output(path.GetPath());
+            NCB::SaveQuantizedPool(pool, &output);
+        }
+
+        const auto loadedPool = NCB::LoadQuantizedPool(path.GetPath(), {false, false});
+        UNIT_ASSERT(loadedPool.AreChunksEvictable);
+        for (size_t localIndex = 0; localIndex < loadedPool.Chunks.size(); ++localIndex) {
+            NCB::AdviseSequentialColumnAccess(loadedPool, localIndex);
+            NCB::EvictColumn(loadedPool, localIndex);
+        }
+
+        // evicted pages are read from file again
+        UNIT_ASSERT_VALUES_EQUAL(QuantizedPoolToString(loadedPool), QuantizedPoolToString(pool));
+    }
+
     Y_UNIT_TEST(TestLoadQuantizationSchema) {
         const auto pool = MakeQuantizedPool();
         const auto path = TFsPath(GetSystemTempDir()) / "quantized_pool.bin";
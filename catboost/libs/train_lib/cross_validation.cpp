@@ -330,7 +330,7 @@ void CrossValidate(
     const bool isPairwiseScoring = IsPairwiseScoring(ctx->Params.LossFunctionDescription->GetLossFunction());
     for (size_t foldIdx = 0; foldIdx < learnFolds.size(); ++foldIdx) {
         TLearnContext& ctx = *contexts[foldIdx];
-        if (IsSamplingPerTree(ctx.Params.ObliviousTreeOptions.Get())) {
+        if (AreStatsFromPrevTreeLevelReusable(ctx.Params.ObliviousTreeOptions.Get(), isPairwiseScoring)) {
             ctx.SmallestSplitSideDocs.Create(ctx.LearnProgress.Folds, isPairwiseScoring);
             ctx.PrevTreeLevelStats.Create(
                 ctx.LearnProgress.Folds,
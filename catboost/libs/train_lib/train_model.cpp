@@ -203,7 +203,7 @@ static void Train(
     }
 
     const bool isPairwiseScoring = IsPairwiseScoring(ctx->Params.LossFunctionDescription->GetLossFunction());
-    if (IsSamplingPerTree(ctx->Params.ObliviousTreeOptions.Get())) {
+    if (AreStatsFromPrevTreeLevelReusable(ctx->Params.ObliviousTreeOptions.Get(), isPairwiseScoring)) {
         ctx->SmallestSplitSideDocs.Create(ctx->LearnProgress.Folds, isPairwiseScoring);
         ctx->PrevTreeLevelStats.Create(
             ctx->LearnProgress.Folds,
@@ -291,6 +291,13 @@ static void Train(
 
     ctx->LearnProgress.Folds.clear();
 
+    const auto& ctrCacheStats = ctx->OnlineCtrCacheStats;
+    if (ctrCacheStats.Hits + ctrCacheStats.Misses > 0) {
+        MATRIXNET_INFO_LOG << "Online ctr cache: " << ctrCacheStats.Hits << " hits, " << ctrCacheStats.Misses << " misses, hit rate "
+            << FloatToString(ctrCacheStats.GetHitRate(), PREC_NDIGITS, 3) << ", evicted " << ctrCacheStats.EvictedCtrs << " ctrs ("
+            << ctrCacheStats.EvictedBytes / (1024 * 1024) << " Mb)" << Endl;
+    }
+
     if (hasTest) {
         MATRIXNET_NOTICE_LOG << "\n";
         MATRIXNET_NOTICE_LOG << "bestTest = " << bestModelErrorTracker.GetBestError() << "\n";
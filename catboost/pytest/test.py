@@ -4167,3 +4167,181 @@ def test_pairwise_bernoulli_bootstrap(subsample, loss_function):
     yatest.common.execute(cmd)
 
     return [local_canonical_file(output_eval_path)]
+
+
+def test_fit_on_quantized_pool():
+    train = data_file('querywise', 'train')
+    cd = data_file('querywise', 'train.cd')
+    quantized_train_path = yatest.common.test_output_path('train.qbin')
+    cmd = (
+        CATBOOST_PATH,
+        'quantize',
+        '--input-path', train,
+        '--column-description', cd,
+        '-o', quantized_train_path,
+        '--block-size', '100',
+        '--sample-size', '10000',
+        '-T', '4',
+    )
+    yatest.common.execute(cmd)
+
+    # all documents are sampled, so borders are the same as ones selected by fit
+    eval_paths = []
+    for learn_set in (train, 'quantized://' + quantized_train_path):
+        output_model_path = yatest.common.test_output_path('model.bin')
+        eval_path = yatest.common.test_output_path('test_{}.eval'.format(len(eval_paths)))
+        cmd = (
+            CATBOOST_PATH,
+            'fit',
+            '--loss-function', 'QueryRMSE',
+            '-f', learn_set,
+            '-t', data_file('querywise', 'test'),
+            '--column-description', cd,
+            '-i', '20',
+            '-T', '4',
+            '-r', '0',
+            '-m', output_model_path,
+            '--eval-file', eval_path,
+            '--use-best-model', 'false',
+        )
+        yatest.common.execute(cmd)
+        eval_paths.append(eval_path)
+
+    assert filecmp.cmp(eval_paths[0], eval_paths[1])
+
+
+@pytest.mark.parametrize('nan_mode', ['Min', 'Max', 'Forbidden'])
+def test_fit_on_quantized_pool_with_const_feature(nan_mode):
+    cd_path = yatest.common.test_output_path('cd.txt')
+    np.savetxt(cd_path, [[0, 'Target']], fmt='%s', delimiter='\t')
+
+    np.random.seed(0)
+    train = generate_random_labeled_set(1000, 3, [0, 1])
+    # constant feature has no borders, so it is written without quantization schema and chunks
+    train[:, 2] = 1.0
+    train_path = yatest.common.test_output_path('train.txt')
+    np.savetxt(train_path, train, fmt='%s', delimiter='\t')
+    test_path = yatest.common.test_output_path('test.txt')
+    np.savetxt(test_path, generate_random_labeled_set(100, 3, [0, 1]), fmt='%s', delimiter='\t')
+
+    quantized_train_path = yatest.common.test_output_path('train.qbin')
+    cmd = (
+        CATBOOST_PATH,
+        'quantize',
+        '--input-path', train_path,
+        '--column-description', cd_path,
+        '-o', quantized_train_path,
+        '--sample-size', '1000',
+        '-T', '4',
+    )
+    yatest.common.execute(cmd)
+
+    eval_paths = []
+    for learn_set in (train_path, 'quantized://' + quantized_train_path):
+        output_model_path = yatest.common.test_output_path('model.bin')
+        eval_path = yatest.common.test_output_path('test_{}.eval'.format(len(eval_paths)))
+        cmd = (
+            CATBOOST_PATH,
+            'fit',
+            '--loss-function', 'Logloss',
+            '-f', learn_set,
+            '-t', test_path,
+            '--column-description', cd_path,
+            '--nan-mode', nan_mode,
+            '-i', '10',
+            '-T', '4',
+            '-r', '0',
+            '-m', output_model_path,
+            '--eval-file', eval_path,
+            '--use-best-model', 'false',
+        )
+        yatest.common.execute(cmd)
+        eval_paths.append(eval_path)
+
+    assert filecmp.cmp(eval_paths[0], eval_paths[1])
+
+
+def test_fit_on_quantized_pool_with_cat_feature():
+    cd_path = yatest.common.test_output_path('cd.txt')
+    np.savetxt(cd_path, [[0, 'Target'], [2, 'Categ']], fmt='%s', delimiter='\t')
+
+    np.random.seed(0)
+    train_path = yatest.common.test_output_path('train.txt')
+    np.savetxt(train_path, generate_random_labeled_set(1000, 3, [0, 1]), fmt='%s', delimiter='\t')
+    test_path = yatest.common.test_output_path('test.txt')
+    np.savetxt(test_path, generate_random_labeled_set(100, 3, [0, 1]), fmt='%s', delimiter='\t')
+
+    quantized_train_path = yatest.common.test_output_path('train.qbin')
+    cmd = (
+        CATBOOST_PATH,
+        'quantize',
+        '--input-path', train_path,
+        '--column-description', cd_path,
+        '-o', quantized_train_path,
+        '--sample-size', '1000',
+        '-T', '4',
+    )
+    yatest.common.execute(cmd)
+
+    def fit(learn_set, eval_path, ignored_features):
+        cmd = (
+            CATBOOST_PATH,
+            'fit',
+            '--loss-function', 'Logloss',
+            '-f', learn_set,
+            '-t', test_path,
+            '--column-description', cd_path,
+            '-i', '10',
+            '-T', '4',
+            '-r', '0',
+            '-m', yatest.common.test_output_path('model.bin'),
+            '--eval-file', eval_path,
+            '--use-best-model', 'false',
+        ) + (('-I', ignored_features) if ignored_features else ())
+        yatest.common.execute(cmd)
+
+    # categorical feature values are not stored in quantized pool
+    with pytest.raises(yatest.common.ExecutionError):
+        fit('quantized://' + quantized_train_path, yatest.common.test_output_path('test.eval'), None)
+
+    eval_paths = [yatest.common.test_output_path('test_{}.eval'.format(i)) for i in range(2)]
+    fit(train_path, eval_paths[0], '1')
+    fit('quantized://' + quantized_train_path, eval_paths[1], '1')
+    assert filecmp.cmp(eval_paths[0], eval_paths[1])
+
+
+@pytest.mark.parametrize('boosting_type', BOOSTING_TYPE)
+def test_model_does_not_depend_on_thread_count(boosting_type):
+    cd_path = yatest.common.test_output_path('cd.txt')
+    np.savetxt(cd_path, [[0, 'Target']], fmt='%s', delimiter='\t')
+
+    np.random.seed(0)
+    # enough documents for bucket stats to be calculated on several document blocks
+    train_path = yatest.common.test_output_path('train.txt')
+    np.savetxt(train_path, generate_random_labeled_set(50000, 2, [0, 1]), fmt='%s', delimiter='\t')
+    test_path = yatest.common.test_output_path('test.txt')
+    np.savetxt(test_path, generate_random_labeled_set(1000, 2, [0, 1]), fmt='%s', delimiter='\t')
+
+    eval_paths = []
+    for thread_count in ('1', '4'):
+        model_path = yatest.common.test_output_path('model_{}.bin'.format(thread_count))
+        eval_path = yatest.common.test_output_path('test_{}.eval'.format(thread_count))
+        cmd = (
+            CATBOOST_PATH,
+            'fit',
+            '--loss-function', 'Logloss',
+            '-f', train_path,
+            '-t', test_path,
+            '--column-description', cd_path,
+            '--boosting-type', boosting_type,
+            '-i', '10',
+            '-T', thread_count,
+            '-r', '0',
+            '-m', model_path,
+            '--eval-file', eval_path,
+            '--use-best-model', 'false',
+        )
+        yatest.common.execute(cmd)
+        eval_paths.append(eval_path)
+
+    assert filecmp.cmp(eval_paths[0], eval_paths[1])
@@ -763,6 +763,8 @@ def _process_synonyms(params):
 
     if 'used_ram_limit' in params:
         params['used_ram_limit'] = str(params['used_ram_limit'])
+    if 'online_ctr_cache_size' in params:
+        params['online_ctr_cache_size'] = str(params['online_ctr_cache_size'])
 
 
 class _CatBoostBase(object):
@@ -1826,6 +1828,9 @@ class CatBoostClassifier(CatBoost):
     used_ram_limit : string or number, [default=None]
         Set a limit on memory consumption (value like '1.2gb' or 1.2e9).
         WARNING: Currently this option affects CTR memory usage only.
+    online_ctr_cache_size : string or number, [default=None]
+        Memory budget for online CTRs kept between iterations (value like '1.2gb' or 1.2e9).
+        Least recently used CTRs are evicted when the budget is exceeded.
     gpu_ram_part : float, [default=0.95]
         Fraction of the GPU RAM to use for training, a value from (0, 1].
     pinned_memory_size: int [default=None]
@@ -1939,6 +1944,7 @@ class CatBoostClassifier(CatBoost):
         snapshot_file=None,
         fold_len_multiplier=None,
         used_ram_limit=None,
+        online_ctr_cache_size=None,
         gpu_ram_part=None,
         pinned_memory_size=None,
         allow_writing_files=None,
@@ -2285,6 +2291,7 @@ class CatBoostRegressor(CatBoost):
         snapshot_file=None,
         fold_len_multiplier=None,
         used_ram_limit=None,
+        online_ctr_cache_size=None,
         gpu_ram_part=None,
         pinned_memory_size=None,
         allow_writing_files=None,
@@ -0,0 +1,292 @@
+#include <catboost/libs/model/model.h>
+#include <catboost/libs/model/formula_evaluator.h>
+#include <catboost/libs/logging/logging.h>
+#include <catboost/libs/helpers/dense_hash_view.h>
+
+#include <library/getopt/small/last_getopt.h>
+
+#include <util/datetime/cputimer.h>
+#include <util/generic/algorithm.h>
+#include <util/generic/ymath.h>
+#include <util/random/fast.h>
+
+struct TBenchmarkParams {
+    size_t DocCount = 100000;
+    size_t FeatureCount = 100;
+    size_t BorderCount = 64;
+    size_t TreeCount = 1000;
+    int TreeDepth = 6;
+    size_t Repeats = 3;
+    ui64 Seed = 0;
+};
+
+static TFullModel MakeRandomModel(const TBenchmarkParams& params, TFastRng64& rng) {
+    TFullModel model;
+    for (size_t featureIdx = 0; featureIdx < params.FeatureCount; ++featureIdx) {
+        TVector<float> borders(params.BorderCount);
+        for (auto& border : borders) {
+            border = rng.GenRandReal1();
+        }
+        Sort(borders.begin(), borders.end());
+        borders.erase(Unique(borders.begin(), borders.end()), borders.end());
+        model.ObliviousTrees.FloatFeatures.emplace_back(false, (int)featureIdx, (int)featureIdx, borders, "");
+    }
+    size_t binFeatureCount = 0;
+    for (const auto& feature : model.ObliviousTrees.FloatFeatures) {
+        binFeatureCount += feature.Borders.size();
+    }
+    for (size_t treeIdx = 0; treeIdx < params.TreeCount; ++treeIdx) {
+        TVector<int> splits(params.TreeDepth);
+        for (auto& split : splits) {
+            split = rng.Uniform(binFeatureCount);
+        }
+        model.ObliviousTrees.AddBinTree(splits);
+        for (int leafIdx = 0; leafIdx < (1 << params.TreeDepth); ++leafIdx) {
+            model.ObliviousTrees.LeafValues.push_back(rng.GenRandReal1() - 0.5);
+        }
+    }
+    model.UpdateDynamicData();
+    return model;
+}
+
+static TVector<EFormulaEvaluatorKernel> GetSupportedKernels() {
+    TVector<EFormulaEvaluatorKernel> kernels;
+    for (auto kernel : {EFormulaEvaluatorKernel::Basic, EFormulaEvaluatorKernel::Sse, EFormulaEvaluatorKernel::Avx2, EFormulaEvaluatorKernel::Avx512}) {
+        if (IsFormulaEvaluatorKernelSupported(kernel)) {
+            kernels.push_back(kernel);
+        }
+    }
+    return kernels;
+}
+
+static const char* KernelName(EFormulaEvaluatorKernel kernel) {
+    switch (kernel) {
+        case EFormulaEvaluatorKernel::Basic:
+            return "Basic";
+        case EFormulaEvaluatorKernel::Sse:
+            return "SSE";
+        case EFormulaEvaluatorKernel::Avx2:
+            return "AVX2";
+        case EFormulaEvaluatorKernel::Avx512:
+            return "AVX-512";
+    }
+    Y_UNREACHABLE();
+}
+
+template <typename TFunc>
+static double MeasureBestSeconds(size_t repeats, TFunc&& func) {
+    double best = Max<double>();
+    for (size_t i = 0; i < repeats; ++i) {
+        TSimpleTimer timer;
+        func();
+        best = Min(best, timer.Get().SecondsFloat());
+    }
+    return best;
+}
+
+static void BenchmarkKernels(const TFullModel& model, const TVector<TVector<float>>& features, const TBenchmarkParams& params) {
+    const size_t docCount = params.DocCount;
+    const size_t blockSize = FORMULA_EVALUATION_BLOCK_SIZE;
+    const size_t bucketCount = model.ObliviousTrees.GetEffectiveBinaryFeaturesBucketsCount();
+
+    TVector<ui8> canonBins;
+    TVector<double> canonResults;
+    double basicBinarizeTime = 0;
+    double basicTreesTime = 0;
+    for (auto kernel : GetSupportedKernels()) {
+        TVector<ui8> bins(bucketCount * docCount);
+        double binarizeTime = 0;
+        double binarySearchTime = 0;
+        for (auto method : {EBinarizationMethod::BinarySearch, EBinarizationMethod::LinearScan}) {
+            const auto binarizeKernel = GetBinarizeFloatsKernel(kernel, method);
+            const double time = MeasureBestSeconds(params.Repeats, [&] {
+                Fill(bins.begin(), bins.end(), 0);
+                for (size_t blockStart = 0; blockStart < docCount; blockStart += blockSize) {
+                    const size_t docCountInBlock = Min(blockSize, docCount - blockStart);
+                    ui8* resultPtr = bins.data() + blockStart * bucketCount;
+                    for (size_t featureIdx = 0; featureIdx < model.ObliviousTrees.FloatFeatures.size(); ++featureIdx) {
+                        binarizeKernel(
+                            features[featureIdx].data() + blockStart,
+                            docCountInBlock,
+                            model.ObliviousTrees.FloatFeatures[featureIdx].Borders,
+                            resultPtr);
+                        resultPtr += docCountInBlock;
+                    }
+                }
+            });
+            if (method == EBinarizationMethod::BinarySearch) {
+                binarySearchTime = time;
+                if (canonBins.empty()) {
+                    canonBins = bins;
+                }
+                CB_ENSURE(bins == canonBins, KernelName(kernel) << " binary search binarization differs from " << KernelName(GetSupportedKernels()[0]));
+            } else {
+                binarizeTime = time;
+            }
+        }
+
+        TVector<double> results(docCount);
+        TVector<TCalcerIndexType> indexesVec(blockSize);
+        double treesTime = 0;
+        double specializedTreesTime = 0;
+        for (bool depthSpecialized : {true, false}) {
+            auto calcTrees = GetCalcTreesFunction(model, blockSize, kernel, depthSpecialized);
+            const double time = MeasureBestSeconds(params.Repeats, [&] {
+                Fill(results.begin(), results.end(), 0.0);
+                for (size_t blockStart = 0; blockStart < docCount; blockStart += blockSize) {
+                    const size_t docCountInBlock = Min(blockSize, docCount - blockStart);
+                    calcTrees(
+                        model,
+                        bins.data() + blockStart * bucketCount,
+                        docCountInBlock,
+                        indexesVec.data(),
+                        0,
+                        model.GetTreeCount(),
+                        results.data() + blockStart);
+                }
+            });
+            if (depthSpecialized) {
+                specializedTreesTime = time;
+                if (canonResults.empty()) {
+                    canonResults = results;
+                }
+                CB_ENSURE(results == canonResults, KernelName(kernel) << " depth specialized evaluation differs from " << KernelName(GetSupportedKernels()[0]));
+            } else {
+                treesTime = time;
+            }
+        }
+
+        if (basicTreesTime == 0) {
+            basicBinarizeTime = binarizeTime;
+            basicTreesTime = treesTime;
+        }
+        CB_ENSURE(bins == canonBins, KernelName(kernel) << " binarization differs from " << KernelName(GetSupportedKernels()[0]));
+        CB_ENSURE(results == canonResults, KernelName(kernel) << " tree evaluation differs from " << KernelName(GetSupportedKernels()[0]));
+        Cout << KernelName(kernel)
+            << "\tlinear scan: " << binarizeTime * 1000 << " ms (x" << basicBinarizeTime / binarizeTime << ")"
+            << "\tbinary search: " << binarySearchTime * 1000 << " ms (x" << basicBinarizeTime / binarySearchTime << ")"
+            << "\ttrees: " << treesTime * 1000 << " ms (x" << basicTreesTime / treesTime << ")"
+            << "\tdepth specialized: " << specializedTreesTime * 1000 << " ms (x" << basicTreesTime / specializedTreesTime << ")" << Endl;
+    }
+}
+
+static void BenchmarkLeafValuesPrecision(TFullModel& model, const TVector<TVector<float>>& features, const TBenchmarkParams& params) {
+    const size_t docCount = params.DocCount;
+    const size_t blockSize = FORMULA_EVALUATION_BLOCK_SIZE;
+    const size_t bucketCount = model.ObliviousTrees.GetEffectiveBinaryFeaturesBucketsCount();
+    const auto kernel = GetBestFormulaEvaluatorKernel();
+
+    TVector<ui8> bins(bucketCount * docCount, 0);
+    const auto binarizeKernel = GetBinarizeFloatsKernel(kernel);
+    for (size_t blockStart = 0; blockStart < docCount; blockStart += blockSize) {
+        const size_t docCountInBlock = Min(blockSize, docCount - blockStart);
+        ui8* resultPtr = bins.data() + blockStart * bucketCount;
+        for (size_t featureIdx = 0; featureIdx < model.ObliviousTrees.FloatFeatures.size(); ++featureIdx) {
+            binarizeKernel(features[featureIdx].data() + blockStart, docCountInBlock, model.ObliviousTrees.FloatFeatures[featureIdx].Borders, resultPtr);
+            resultPtr += docCountInBlock;
+        }
+    }
+
+    TVector<double> canonResults;
+    double doubleTime = 0;
+    TVector<TCalcerIndexType> indexesVec(blockSize);
+    for (auto precision : {ELeafValuesPrecision::Double, ELeafValuesPrecision::Float, ELeafValuesPrecision::Int16}) {
+        const double maxAbsErrorBound = model.ObliviousTrees.SetLeafValuesPrecision(precision);
+        auto calcTrees = GetCalcTreesFunction(model, blockSize, kernel);
+        TVector<double> results(docCount);
+        const double time = MeasureBestSeconds(params.Repeats, [&] {
+            Fill(results.begin(), results.end(), 0.0);
+            for (size_t blockStart = 0; blockStart < docCount; blockStart += blockSize) {
+                const size_t docCountInBlock = Min(blockSize, docCount - blockStart);
+                calcTrees(model, bins.data() + blockStart * bucketCount, docCountInBlock, indexesVec.data(), 0, model.GetTreeCount(), results.data() + blockStart);
+            }
+        });
+        if (canonResults.empty()) {
+            canonResults = results;
+            doubleTime = time;
+        }
+        double maxAbsError = 0;
+        for (size_t docId = 0; docId < docCount; ++docId) {
+            maxAbsError = Max(maxAbsError, Abs(results[docId] - canonResults[docId]));
+        }
+        Cout << "Leaf values " << precision
+            << "	trees: " << time * 1000 << " ms (x" << doubleTime / time << ")"
+            << "	max abs error: " << maxAbsError << " (bound " << maxAbsErrorBound << ")" << Endl;
+    }
+    model.ObliviousTrees.SetLeafValuesPrecision(ELeafValuesPrecision::Double);
+}
+
+/**
+ * Dense hash view lookups with one lookup per document, batched prefetching lookups and cuckoo layout lookups,
+ * table sizes span CTR tables from cache resident to hundreds of megabytes.
+ * Half of looked up hashes are missing in table, as for unseen categorical values.
+ */
+static void BenchmarkCtrTableLookup(const TBenchmarkParams& params, TFastRng64& rng) {
+    const size_t lookupCount = params.DocCount;
+    for (size_t uniqueValuesCount : {1 << 12, 1 << 16, 1 << 20, 1 << 23}) {
+        TVector<NCatboost::TBucket> buckets(NCatboost::TDenseIndexHashBuilder::GetProperBucketsCount(uniqueValuesCount));
+        NCatboost::TDenseIndexHashBuilder builder(buckets);
+        TVector<ui64> tableHashes(uniqueValuesCount);
+        for (auto& hash : tableHashes) {
+            hash = rng.GenRand64();
+            builder.AddIndex(hash);
+        }
+        TVector<ui64> hashes(lookupCount);
+        for (auto& hash : hashes) {
+            hash = rng.GenRand() % 2 ? tableHashes[rng.Uniform(uniqueValuesCount)] : rng.GenRand64();
+        }
+        NCatboost::TDenseIndexHashView view(buckets);
+        TVector<ui32> canonIndexes(lookupCount);
+        const double scalarTime = MeasureBestSeconds(params.Repeats, [&] {
+            for (size_t i = 0; i < lookupCount; ++i) {
+                canonIndexes[i] = view.GetIndex(hashes[i]);
+            }
+        });
+        TVector<ui32> indexes(lookupCount);
+        const double batchedTime = MeasureBestSeconds(params.Repeats, [&] {
+            view.GetIndexes(hashes, indexes);
+        });
+        CB_ENSURE(indexes == canonIndexes, "batched ctr table lookup differs from GetIndex");
+        const auto groups = NCatboost::BuildCuckooIndex(buckets);
+        NCatboost::TCuckooIndexHashView cuckooView(groups);
+        const double cuckooTime = MeasureBestSeconds(params.Repeats, [&] {
+            cuckooView.GetIndexes(hashes, indexes);
+        });
+        CB_ENSURE(indexes == canonIndexes, "cuckoo ctr table lookup differs from GetIndex");
+        Cout << "Ctr table " << uniqueValuesCount << " values (" << buckets.size() * sizeof(NCatboost::TBucket) / 1024 << " KB)"
+            << "\tlookups: " << scalarTime * 1000 << " ms"
+            << "\tbatched: " << batchedTime * 1000 << " ms (x" << scalarTime / batchedTime << ")"
+            << "\tcuckoo (" << groups.size() * sizeof(NCatboost::TBucketGroup) / 1024 << " KB): "
+            << cuckooTime * 1000 << " ms (x" << scalarTime / cuckooTime << ")" << Endl;
+    }
+}
+
+int main(int argc, const char* argv[]) {
+    TBenchmarkParams params;
+    auto parser = NLastGetopt::TOpts();
+    parser.AddHelpOption();
+    parser.AddLongOption("docs", "document count").StoreResult(&params.DocCount).Optional();
+    parser.AddLongOption("features", "float feature count").StoreResult(&params.FeatureCount).Optional();
+    parser.AddLongOption("borders", "border count per feature").StoreResult(&params.BorderCount).Optional();
+    parser.AddLongOption("trees", "tree count").StoreResult(&params.TreeCount).Optional();
+    parser.AddLongOption("depth", "tree depth").StoreResult(&params.TreeDepth).Optional();
+    parser.AddLongOption("repeats", "measurement repeats, best time is reported").StoreResult(&params.Repeats).Optional();
+    parser.AddLongOption("seed", "random seed").StoreResult(&params.Seed).Optional();
+    NLastGetopt::TOptsParseResult parseResult{&parser, argc, argv};
+    CB_ENSURE(params.BorderCount > 0 && params.BorderCount <= 254, "border count should be in [1, 254]");
+    CB_ENSURE(params.TreeDepth > 0 && params.TreeDepth <= 16, "tree depth should be in [1, 16]");
+
+    TFastRng64 rng(params.Seed);
+    TFullModel model = MakeRandomModel(params, rng);
+    TVector<TVector<float>> features(params.FeatureCount, TVector<float>(params.DocCount));
+    for (auto& feature : features) {
+        for (auto& value : feature) {
+            value = rng.GenRandReal1();
+        }
+    }
+    Cout << "Best kernel for this CPU: " << KernelName(GetBestFormulaEvaluatorKernel()) << Endl;
+    BenchmarkKernels(model, features, params);
+    BenchmarkLeafValuesPrecision(model, features, params);
+    BenchmarkCtrTableLookup(params, rng);
+    return 0;
+}